@@ -39,6 +39,10 @@ bool Engine::callMouseInTouchEvent = false;
 bool Engine::callTouchInMouseEvent = false;
 bool Engine::useDegrees = true;
 bool Engine::automaticTransparency = true;
+bool Engine::automaticInstancing = false;
+bool Engine::automaticBatching = false;
+bool Engine::multithreadedRender = false;
+int Engine::maxShadowUpdates = 0;
 bool Engine::allowEventsOutCanvas = false;
 bool Engine::ignoreEventsHandledByUI = true;
 bool Engine::fixedTimeSceneUpdate = true;
@@ -60,8 +64,14 @@ CursorType Engine::mouseCursorType = CursorType::ARROW;
 bool Engine::showCursor = true;
 
 thread_local bool Engine::asyncThread = false;
+thread_local bool Engine::recordingThread = false;
 Semaphore Engine::drawSemaphore;
 
+std::thread Engine::updateThread;
+Semaphore Engine::updateThreadSemaphore;
+std::atomic<bool> Engine::updateThreadRunning = false;
+bool Engine::updateThreadFrame = false;
+
 Framebuffer* Engine::framebuffer = nullptr;
 
 //-----Supernova user events-----
@@ -90,7 +100,7 @@ FunctionSubscribe<void(wchar_t)> Engine::onCharInput;
 
 
 void Engine::setScene(Scene* scene){
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.acquire();
 
     if (mainScene){
@@ -108,7 +118,7 @@ void Engine::setScene(Scene* scene){
         mainScene = scene;
     }
 
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.release();
 }
 
@@ -117,7 +127,7 @@ Scene* Engine::getScene(){
 }
 
 void Engine::addSceneLayer(Scene* scene){
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.acquire();
 
     if (scene){
@@ -125,12 +135,12 @@ void Engine::addSceneLayer(Scene* scene){
         includeScene(scenes.size()-1, scene);
     }
 
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.release();
 }
 
 void Engine::removeScene(Scene* scene){
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.acquire();
 
     if (scene){
@@ -145,12 +155,12 @@ void Engine::removeScene(Scene* scene){
         }
     }
 
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.release();
 }
 
 void Engine::removeAllSceneLayers(){
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.acquire();
 
         scenes.erase(
@@ -159,18 +169,18 @@ void Engine::removeAllSceneLayers(){
             scenes.end()
         );
 
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.release();
 }
 
 void Engine::removeAllScenes(){
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.acquire();
 
         scenes.clear();
         mainScene = NULL;
 
-    if (asyncThread)
+    if (asyncThread && !recordingThread)
         drawSemaphore.release();
 }
 
@@ -264,6 +274,38 @@ bool Engine::isAutomaticTransparency(){
     return automaticTransparency;
 }
 
+void Engine::setAutomaticInstancing(bool automaticInstancing){
+    Engine::automaticInstancing = automaticInstancing;
+}
+
+bool Engine::isAutomaticInstancing(){
+    return automaticInstancing;
+}
+
+void Engine::setAutomaticBatching(bool automaticBatching){
+    Engine::automaticBatching = automaticBatching;
+}
+
+bool Engine::isAutomaticBatching(){
+    return automaticBatching;
+}
+
+void Engine::setMultithreadedRender(bool multithreadedRender){
+    Engine::multithreadedRender = multithreadedRender;
+}
+
+bool Engine::isMultithreadedRender(){
+    return multithreadedRender;
+}
+
+void Engine::setMaxShadowUpdates(int maxShadowUpdates){
+    Engine::maxShadowUpdates = maxShadowUpdates;
+}
+
+int Engine::getMaxShadowUpdates(){
+    return maxShadowUpdates;
+}
+
 void Engine::setAllowEventsOutCanvas(bool allowEventsOutCanvas){
     Engine::allowEventsOutCanvas = allowEventsOutCanvas;
 }
@@ -395,6 +437,10 @@ void Engine::startAsyncThread(){
 }
 
 void Engine::commitThreadQueue(){
+    // update thread commits whole frames, commands of other threads go with them
+    if (updateThreadRunning && !recordingThread)
+        return;
+
     SystemRender::commitQueue();
 }
 
@@ -407,6 +453,10 @@ bool Engine::isAsyncThread(){
     return asyncThread;
 }
 
+bool Engine::isRecordingThread(){
+    return recordingThread;
+}
+
 bool Engine::isViewLoaded(){
     return viewLoaded;
 }
@@ -494,6 +544,12 @@ void Engine::systemViewLoaded(){
 }
 
 void Engine::systemViewChanged(){
+    // framebuffers are recreated here, recording restarts in next draw
+    if (updateThreadRunning){
+        stopUpdateThread();
+        SystemRender::executeQueueResources();
+    }
+
     calculateCanvas();
 
     int screenWidth = System::instance().getScreenWidth();
@@ -561,15 +617,11 @@ void Engine::systemViewChanged(){
     onViewChanged.call();
 }
 
-void Engine::systemDraw(){
+void Engine::updateAndDraw(){
     //Deltatime in seconds
     deltatime = stm_sec(stm_laptime(&lastTime));
     framerate = 1 / deltatime;
 
-    drawSemaphore.acquire();
-
-    SystemRender::executeQueue();
-
     // avoid increment updateTimeCount after resume
     if (!paused) {
         int updateLoops = 0;
@@ -606,6 +658,95 @@ void Engine::systemDraw(){
     }
 
     SystemRender::commit();
+}
+
+void Engine::updateThreadLoop(){
+    asyncThread = true;
+    recordingThread = true;
+
+    while (true){
+        updateThreadSemaphore.acquire();
+
+        if (!updateThreadRunning)
+            break;
+
+        drawSemaphore.acquire();
+
+        updateAndDraw();
+
+        AudioSystem::checkActive();
+
+        drawSemaphore.release();
+
+        // waits render thread to finish previous frame
+        SystemRender::commitQueue();
+    }
+
+    recordingThread = false;
+    asyncThread = false;
+}
+
+void Engine::startUpdateThread(){
+    updateThreadFrame = false;
+    updateThreadRunning = true;
+
+    updateThread = std::thread(&Engine::updateThreadLoop);
+}
+
+void Engine::stopUpdateThread(){
+    updateThreadRunning = false;
+    updateThreadSemaphore.release();
+
+    updateThread.join();
+
+    updateThreadFrame = false;
+}
+
+void Engine::lockUpdateThread(){
+    // events from platform thread cannot run while scenes are updated
+    if (updateThreadRunning)
+        drawSemaphore.acquire();
+}
+
+void Engine::unlockUpdateThread(){
+    if (updateThreadRunning)
+        drawSemaphore.release();
+}
+
+void Engine::systemDraw(){
+    if (multithreadedRender && !updateThreadRunning){
+        startUpdateThread();
+    }
+
+    if (updateThreadRunning){
+        if (!multithreadedRender){
+            stopUpdateThread();
+            // last recorded frame, next one is drawn in this thread
+            SystemRender::executeQueue();
+            // commands added by other threads after last frame
+            SystemRender::commitQueue();
+            SystemRender::executeQueue();
+            return;
+        }
+
+        // update thread records next frame while this one is executed
+        updateThreadSemaphore.release();
+        SystemRender::executeQueue(true);
+
+        // first frame waits for its own recording, then next one starts
+        if (!updateThreadFrame){
+            updateThreadFrame = true;
+            updateThreadSemaphore.release();
+        }
+
+        return;
+    }
+
+    drawSemaphore.acquire();
+
+    SystemRender::executeQueue();
+
+    updateAndDraw();
 
     drawSemaphore.release();
 
@@ -613,6 +754,11 @@ void Engine::systemDraw(){
 }
 
 void Engine::systemViewDestroyed(){
+    if (updateThreadRunning){
+        stopUpdateThread();
+        SystemRender::executeQueueResources();
+    }
+
     drawSemaphore.acquire();
     
     viewLoaded = false;
@@ -642,15 +788,23 @@ void Engine::systemShutdown(){
 }
 
 void Engine::systemPause(){
+    lockUpdateThread();
+
     AudioSystem::pauseAll();
     Engine::onPause.call();
     paused = true;
+
+    unlockUpdateThread();
 }
 
 void Engine::systemResume(){
+    lockUpdateThread();
+
     AudioSystem::resumeAll();
     Engine::onResume.call();
     paused = false;
+
+    unlockUpdateThread();
 }
 
 bool Engine::transformCoordPos(float& x, float& y){
@@ -668,6 +822,8 @@ bool Engine::transformCoordPos(float& x, float& y){
 }
 
 void Engine::systemTouchStart(int pointer, float x, float y){
+    lockUpdateThread();
+
     if (transformCoordPos(x, y)){
         //-----------------
         Input::addTouch(pointer, x, y);
@@ -692,9 +848,13 @@ void Engine::systemTouchStart(int pointer, float x, float y){
         }
         uiEventReceived = false;
     }
+
+    unlockUpdateThread();
 }
 
 void Engine::systemTouchEnd(int pointer, float x, float y){
+    lockUpdateThread();
+
     if (transformCoordPos(x, y)){
         //-----------------
         Input::removeTouch(pointer);
@@ -719,9 +879,13 @@ void Engine::systemTouchEnd(int pointer, float x, float y){
         }
         uiEventReceived = false;
     }
+
+    unlockUpdateThread();
 }
 
 void Engine::systemTouchMove(int pointer, float x, float y){
+    lockUpdateThread();
+
     if (transformCoordPos(x, y)){
         //-----------------
         Input::setTouchPosition(pointer, x, y);
@@ -745,16 +909,24 @@ void Engine::systemTouchMove(int pointer, float x, float y){
         }
         uiEventReceived = false;
     }
+
+    unlockUpdateThread();
 }
 
 void Engine::systemTouchCancel(){
+    lockUpdateThread();
+
     //-----------------
     Input::clearTouches();
     Engine::onTouchCancel.call();
     //-----------------
+
+    unlockUpdateThread();
 }
 
 void Engine::systemMouseDown(int button, float x, float y, int mods){
+    lockUpdateThread();
+
     if (transformCoordPos(x, y)){
         //-----------------
         Input::addMousePressed(button);
@@ -782,8 +954,12 @@ void Engine::systemMouseDown(int button, float x, float y, int mods){
         }
         uiEventReceived = false;
     }
+
+    unlockUpdateThread();
 }
 void Engine::systemMouseUp(int button, float x, float y, int mods){
+    lockUpdateThread();
+
     if (transformCoordPos(x, y)){
         //-----------------
         Input::releaseMousePressed(button);
@@ -811,9 +987,13 @@ void Engine::systemMouseUp(int button, float x, float y, int mods){
         }
         uiEventReceived = false;
     }
+
+    unlockUpdateThread();
 }
 
 void Engine::systemMouseMove(float x, float y, int mods){
+    lockUpdateThread();
+
     if (transformCoordPos(x, y)){
         //-----------------
         Input::setMousePosition(x, y);
@@ -841,53 +1021,79 @@ void Engine::systemMouseMove(float x, float y, int mods){
         }
         uiEventReceived = false;
     }
+
+    unlockUpdateThread();
 }
 
 void Engine::systemMouseScroll(float xoffset, float yoffset, int mods){
+    lockUpdateThread();
+
     //-----------------
     Input::setMouseScroll(xoffset, yoffset);
     if (mods != 0)
         Input::setModifiers(mods);
     Engine::onMouseScroll.call(xoffset, yoffset, mods);
     //-----------------
+
+    unlockUpdateThread();
 }
 
 void Engine::systemMouseEnter(){
+    lockUpdateThread();
+
     //-----------------
     Input::addMouseEntered();
     Engine::onMouseEnter.call();
     //-----------------
+
+    unlockUpdateThread();
 }
 
 void Engine::systemMouseLeave(){
+    lockUpdateThread();
+
     //-----------------
     Input::releaseMouseEntered();
     Engine::onMouseLeave.call();
     //-----------------
+
+    unlockUpdateThread();
 }
 
 void Engine::systemKeyDown(int key, bool repeat, int mods){
+    lockUpdateThread();
+
     //-----------------
     Input::addKeyPressed(key);
     if (mods != 0)
         Input::setModifiers(mods);
     Engine::onKeyDown.call(key, repeat, mods);
     //-----------------
+
+    unlockUpdateThread();
 }
 
 void Engine::systemKeyUp(int key, bool repeat, int mods){
+    lockUpdateThread();
+
     //-----------------
     Input::releaseKeyPressed(key);
     Input::setModifiers(mods); // Now it can be 0
     Engine::onKeyUp.call(key, repeat, mods);
     //-----------------
+
+    unlockUpdateThread();
 }
 
 void Engine::systemCharInput(wchar_t codepoint){
+    lockUpdateThread();
+
     onCharInput.call(codepoint);
 
     for (int i = 0; i < scenes.size(); i++){
         if (scenes[i]->canReceiveUIEvents())
             scenes[i]->getSystem<UISystem>()->eventOnCharInput(codepoint);
     }
+
+    unlockUpdateThread();
 }
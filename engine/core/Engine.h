@@ -59,6 +59,7 @@
 #include "util/ThreadUtils.h"
 #include "texture/Framebuffer.h"
 #include <atomic>
+#include <thread>
 
 void init();
 
@@ -130,6 +131,10 @@ namespace Supernova {
         static bool callTouchInMouseEvent;
         static bool useDegrees;
         static bool automaticTransparency;
+        static bool automaticInstancing;
+        static bool automaticBatching;
+        static bool multithreadedRender;
+        static int maxShadowUpdates;
 
         static bool allowEventsOutCanvas;
 
@@ -154,13 +159,26 @@ namespace Supernova {
         static bool showCursor;
 
         thread_local static bool asyncThread;
+        thread_local static bool recordingThread;
 
         static Semaphore drawSemaphore;
 
+        static std::thread updateThread;
+        static Semaphore updateThreadSemaphore;
+        static std::atomic<bool> updateThreadRunning;
+        static bool updateThreadFrame;
+
         static Framebuffer* framebuffer;
         
         static bool transformCoordPos(float& x, float& y);
         static void calculateCanvas();
+
+        static void updateAndDraw();
+        static void updateThreadLoop();
+        static void startUpdateThread();
+        static void stopUpdateThread();
+        static void lockUpdateThread();
+        static void unlockUpdateThread();
         static void includeScene(size_t index, Scene* scene);
         
     public:
@@ -205,6 +223,22 @@ namespace Supernova {
         static void setAutomaticTransparency(bool automaticTransparency);
         static bool isAutomaticTransparency();
 
+        // needs instanced shaders for the grouped materials
+        static void setAutomaticInstancing(bool automaticInstancing);
+        static bool isAutomaticInstancing();
+
+        // UI objects sharing texture and shader are drawn together, disabled by default because draw order changes
+        static void setAutomaticBatching(bool automaticBatching);
+        static bool isAutomaticBatching();
+
+        // scenes are updated and recorded in other thread while render thread executes previous frame
+        static void setMultithreadedRender(bool multithreadedRender);
+        static bool isMultithreadedRender();
+
+        // shadow maps re-rendered per frame, 0 is unlimited, unchanged maps are always reused
+        static void setMaxShadowUpdates(int maxShadowUpdates);
+        static int getMaxShadowUpdates();
+
         static void setAllowEventsOutCanvas(bool allowEventsOutCanvas);
         static bool isAllowEventsOutCanvas();
 
@@ -238,6 +272,7 @@ namespace Supernova {
         static void commitThreadQueue();
         static void endAsyncThread();
         static bool isAsyncThread();
+        static bool isRecordingThread();
         static bool isViewLoaded();
 
         static void setFramebuffer(Framebuffer* framebuffer);
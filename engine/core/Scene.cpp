@@ -84,6 +84,8 @@ Scene::Scene(){
 	ambientFactor = 0.2;
 
 	enableUIEvents = true;
+
+	deferredHierarchySort = false;
 }
 
 Scene::~Scene(){
@@ -220,6 +222,8 @@ void Scene::destroy(){
 }
 
 void Scene::draw(){
+	sortPendingComponentsByTransform();
+
 	for (auto const& pair : systems){
 		pair.second->draw();
 	}
@@ -228,8 +232,13 @@ void Scene::draw(){
 
 void Scene::update(double dt){
 	for (auto const& pair : systems){
+		// hierarchy can be changed by previous system
+		sortPendingComponentsByTransform();
+
 		pair.second->update(dt);
 	}
+
+	sortPendingComponentsByTransform();
 }
 
 void Scene::updateSizeFromCamera(){
@@ -261,24 +270,18 @@ size_t Scene::findBranchLastIndex(Entity entity){
 	// will throw error if entity has not Transform
 	size_t index = transforms->getIndex(entity);
 
+	// branch is contiguous, next entity is inside while its parent is inside
 	size_t currentIndex = index + 1;
-	std::vector<Entity> entityList;
-	entityList.push_back(entity);
-
-	bool found = true;
-	while (found){
-		if (currentIndex < transforms.get()->size()){
-			Transform& transform = componentManager.getComponentFromIndex<Transform>(currentIndex);
-			//if not in list
-			if (std::find(entityList.begin(), entityList.end(),transform.parent)==entityList.end()) {
-				found = false;
-			}else{
-				entityList.push_back(transforms->getEntity(currentIndex));
-				currentIndex++;
-			}
-		} else {
-			found = false;
+	while (currentIndex < transforms->size()){
+		Transform& transform = transforms->getComponentFromIndex(currentIndex);
+		if (transform.parent == NULL_ENTITY || !transforms->contains(transform.parent)){
+			break;
 		}
+		size_t parentIndex = transforms->getIndex(transform.parent);
+		if (parentIndex < index || parentIndex >= currentIndex){
+			break;
+		}
+		currentIndex++;
 	}
 
 	currentIndex--;
@@ -364,67 +367,97 @@ void Scene::addEntityChild(Entity parent, Entity child, bool changeTransform){
 }
 
 void Scene::sortComponentsByTransform(Signature entitySignature){
+	if (deferredHierarchySort){
+		pendingSortSignature |= entitySignature;
+		return;
+	}
+
+	auto transforms = componentManager.getComponentArray<Transform>();
+
 	// Mesh component
 	if (entitySignature.test(getComponentId<MeshComponent>())){
 		auto meshes = componentManager.getComponentArray<MeshComponent>();
-		meshes->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		meshes->sortByComponent<Transform>(transforms);
 	}
 
 	// InstancedMesh component
 	if (entitySignature.test(getComponentId<InstancedMeshComponent>())){
 		auto instmeshes = componentManager.getComponentArray<InstancedMeshComponent>();
-		instmeshes->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		instmeshes->sortByComponent<Transform>(transforms);
 	}
 
 	// Model component
 	if (entitySignature.test(getComponentId<ModelComponent>())){
 		auto models = componentManager.getComponentArray<ModelComponent>();
-		models->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		models->sortByComponent<Transform>(transforms);
 	}
 
 	// Bone component
 	if (entitySignature.test(getComponentId<BoneComponent>())){
 		auto bones = componentManager.getComponentArray<BoneComponent>();
-		bones->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		bones->sortByComponent<Transform>(transforms);
 	}
 
 	// Polygon component
 	if (entitySignature.test(getComponentId<PolygonComponent>())){
 		auto polygons = componentManager.getComponentArray<PolygonComponent>();
-		polygons->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		polygons->sortByComponent<Transform>(transforms);
 	}
 
 	// UI layout component
 	if (entitySignature.test(getComponentId<UILayoutComponent>())){
 		auto layout = componentManager.getComponentArray<UILayoutComponent>();
-		layout->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		layout->sortByComponent<Transform>(transforms);
 	}
 
 	// UI component
 	if (entitySignature.test(getComponentId<UIComponent>())){
 		auto ui = componentManager.getComponentArray<UIComponent>();
-		ui->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		ui->sortByComponent<Transform>(transforms);
 	}
 
 	// Points component
 	if (entitySignature.test(getComponentId<PointsComponent>())){
 		auto points = componentManager.getComponentArray<PointsComponent>();
-		points->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		points->sortByComponent<Transform>(transforms);
 	}
 
 	// Lines component
-	if (entitySignature.test(getComponentId<PointsComponent>())){
-		auto points = componentManager.getComponentArray<PointsComponent>();
-		points->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+	if (entitySignature.test(getComponentId<LinesComponent>())){
+		auto lines = componentManager.getComponentArray<LinesComponent>();
+		lines->sortByComponent<Transform>(transforms);
 	}
 
 	// Audio component
 	if (entitySignature.test(getComponentId<AudioComponent>())){
 		auto audios = componentManager.getComponentArray<AudioComponent>();
-		audios->sortByComponent<Transform>(componentManager.getComponentArray<Transform>());
+		audios->sortByComponent<Transform>(transforms);
+	}
+}
+
+void Scene::sortPendingComponentsByTransform(){
+	if (pendingSortSignature.any()){
+		Signature signature = pendingSortSignature;
+		pendingSortSignature.reset();
+
+		bool deferred = deferredHierarchySort;
+		deferredHierarchySort = false;
+		sortComponentsByTransform(signature);
+		deferredHierarchySort = deferred;
 	}
 }
 
+void Scene::setDeferredHierarchySort(bool deferredHierarchySort){
+	this->deferredHierarchySort = deferredHierarchySort;
+	if (!deferredHierarchySort){
+		sortPendingComponentsByTransform();
+	}
+}
+
+bool Scene::isDeferredHierarchySort() const{
+	return this->deferredHierarchySort;
+}
+
 void Scene::moveChildAux(Entity entity, bool increase, bool stopIfFound){
 	Signature signature = entityManager.getSignature(entity);
 
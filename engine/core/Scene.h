@@ -76,12 +76,16 @@ namespace Supernova{
 
 		bool enableUIEvents;
 
+		bool deferredHierarchySort;
+		Signature pendingSortSignature;
+
 	    EntityManager entityManager;
 	    ComponentManager componentManager;
 		std::vector<std::pair<const char*, std::shared_ptr<SubSystem>>> systems;
 
 		Entity createDefaultCamera();
 		void sortComponentsByTransform(Signature entitySignature);
+		void sortPendingComponentsByTransform();
 		void moveChildAux(Entity entity, bool increase, bool stopIfFound);
 		
 	public:
@@ -123,6 +127,10 @@ namespace Supernova{
 		bool isEnableUIEvents() const;
 		void setEnableUIEvents(bool enableUIEvents);
 
+		// Many hierarchy changes in a frame sort component arrays once, before next system update or draw
+		void setDeferredHierarchySort(bool deferredHierarchySort);
+		bool isDeferredHierarchySort() const;
+
 		size_t findBranchLastIndex(Entity entity);
 	
 		//Entity methods
@@ -198,6 +206,12 @@ namespace Supernova{
 		std::shared_ptr<ComponentArray<T>> getComponentArray() {
 			return componentManager.getComponentArray<T>();
 		}
+
+		// Entities with all components, in order of first component array (use Transform first to follow hierarchy)
+		template<typename T, typename... Ts>
+		EntityView<T, Ts...> view() {
+			return componentManager.view<T, Ts...>();
+		}
 	
 		// System methods
 	
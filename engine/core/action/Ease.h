@@ -335,6 +335,45 @@ namespace Supernova {
 
             return Ease::linear;
         }
+
+        // same as getFunction without std::function call
+        static inline float evaluate(EaseType functionType, float time){
+            switch (functionType){
+                case EaseType::LINEAR: return Ease::linear(time);
+                case EaseType::QUAD_IN: return Ease::easeInQuad(time);
+                case EaseType::QUAD_OUT: return Ease::easeOutQuad(time);
+                case EaseType::QUAD_IN_OUT: return Ease::easeInOutQuad(time);
+                case EaseType::CUBIC_IN: return Ease::easeInCubic(time);
+                case EaseType::CUBIC_OUT: return Ease::easeOutCubic(time);
+                case EaseType::CUBIC_IN_OUT: return Ease::easeInOutCubic(time);
+                case EaseType::QUART_IN: return Ease::easeInQuart(time);
+                case EaseType::QUART_OUT: return Ease::easeOutQuart(time);
+                case EaseType::QUART_IN_OUT: return Ease::easeInOutQuart(time);
+                case EaseType::QUINT_IN: return Ease::easeInQuint(time);
+                case EaseType::QUINT_OUT: return Ease::easeOutQuint(time);
+                case EaseType::QUINT_IN_OUT: return Ease::easeInOutQuint(time);
+                case EaseType::SINE_IN: return Ease::easeInSine(time);
+                case EaseType::SINE_OUT: return Ease::easeOutSine(time);
+                case EaseType::SINE_IN_OUT: return Ease::easeInOutSine(time);
+                case EaseType::EXPO_IN: return Ease::easeInExpo(time);
+                case EaseType::EXPO_OUT: return Ease::easeOutExpo(time);
+                case EaseType::EXPO_IN_OUT: return Ease::easeInOutExpo(time);
+                case EaseType::CIRC_IN: return Ease::easeInCirc(time);
+                case EaseType::CIRC_OUT: return Ease::easeOutCirc(time);
+                case EaseType::CIRC_IN_OUT: return Ease::easeInOutCirc(time);
+                case EaseType::ELASTIC_IN: return Ease::easeInElastic(time);
+                case EaseType::ELASTIC_OUT: return Ease::easeOutElastic(time);
+                case EaseType::ELASTIC_IN_OUT: return Ease::easeInOutElastic(time);
+                case EaseType::BACK_IN: return Ease::easeInBack(time);
+                case EaseType::BACK_OUT: return Ease::easeOutBack(time);
+                case EaseType::BACK_IN_OUT: return Ease::easeInOutBack(time);
+                case EaseType::BOUNCE_IN: return Ease::easeInBounce(time);
+                case EaseType::BOUNCE_OUT: return Ease::easeOutBounce(time);
+                case EaseType::BOUNCE_IN_OUT: return Ease::easeInOutBounce(time);
+            }
+
+            return time;
+        }
     };
 }
 
@@ -111,7 +111,8 @@ void Particles::setPositionModifier(float fromTime, float toTime, Vector3 fromPo
     partAnim.positionModifier.toTime = toTime;
     partAnim.positionModifier.fromPosition = fromPosition;
     partAnim.positionModifier.toPosition = toPosition;
-    partAnim.positionModifier.function = Ease::getFunction(functionType);
+    partAnim.positionModifier.functionType = functionType;
+    partAnim.positionModifier.function.clear();
 }
 
 void Particles::setVelocityInitializer(Vector3 velocity){
@@ -136,7 +137,8 @@ void Particles::setVelocityModifier(float fromTime, float toTime, Vector3 fromVe
     partAnim.velocityModifier.toTime = toTime;
     partAnim.velocityModifier.fromVelocity = fromVelocity;
     partAnim.velocityModifier.toVelocity = toVelocity;
-    partAnim.velocityModifier.function = Ease::getFunction(functionType);
+    partAnim.velocityModifier.functionType = functionType;
+    partAnim.velocityModifier.function.clear();
 }
 
 void Particles::setAccelerationInitializer(Vector3 acceleration){
@@ -161,7 +163,8 @@ void Particles::setAccelerationModifier(float fromTime, float toTime, Vector3 fr
     partAnim.accelerationModifier.toTime = toTime;
     partAnim.accelerationModifier.fromAcceleration = fromAcceleration;
     partAnim.accelerationModifier.toAcceleration = toAcceleration;
-    partAnim.accelerationModifier.function = Ease::getFunction(functionType);
+    partAnim.accelerationModifier.functionType = functionType;
+    partAnim.accelerationModifier.function.clear();
 }
 
 void Particles::setColorInitializer(Vector3 color){
@@ -186,7 +189,8 @@ void Particles::setColorModifier(float fromTime, float toTime, Vector3 fromColor
     partAnim.colorModifier.toTime = toTime;
     partAnim.colorModifier.fromColor = fromColor;
     partAnim.colorModifier.toColor = toColor;
-    partAnim.colorModifier.function = Ease::getFunction(functionType);
+    partAnim.colorModifier.functionType = functionType;
+    partAnim.colorModifier.function.clear();
 }
 
 void Particles::setAlphaInitializer(float alpha){
@@ -211,7 +215,8 @@ void Particles::setAlphaModifier(float fromTime, float toTime, float fromAlpha,
     partAnim.alphaModifier.toTime = toTime;
     partAnim.alphaModifier.fromAlpha = fromAlpha;
     partAnim.alphaModifier.toAlpha = toAlpha;
-    partAnim.alphaModifier.function = Ease::getFunction(functionType);
+    partAnim.alphaModifier.functionType = functionType;
+    partAnim.alphaModifier.function.clear();
 }
 
 void Particles::setSizeInitializer(float size){
@@ -236,7 +241,8 @@ void Particles::setSizeModifier(float fromTime, float toTime, float fromSize, fl
     partAnim.sizeModifier.toTime = toTime;
     partAnim.sizeModifier.fromSize = fromSize;
     partAnim.sizeModifier.toSize = toSize;
-    partAnim.sizeModifier.function = Ease::getFunction(functionType);
+    partAnim.sizeModifier.functionType = functionType;
+    partAnim.sizeModifier.function.clear();
 }
 
 void Particles::setSpriteIntializer(std::vector<int> frames){
@@ -265,7 +271,8 @@ void Particles::setSpriteModifier(float fromTime, float toTime, std::vector<int>
     partAnim.spriteModifier.fromTime = fromTime;
     partAnim.spriteModifier.toTime = toTime;
     partAnim.spriteModifier.frames = frames;
-    partAnim.spriteModifier.function = Ease::getFunction(functionType);
+    partAnim.spriteModifier.functionType = functionType;
+    partAnim.spriteModifier.function.clear();
 }
 
 void Particles::setRotationInitializer(Quaternion rotation){
@@ -305,7 +312,8 @@ void Particles::setRotationModifier(float fromTime, float toTime, float fromRota
     partAnim.rotationModifier.toTime = toTime;
     partAnim.rotationModifier.fromRotation = Quaternion(0, 0, fromRotation);
     partAnim.rotationModifier.toRotation = Quaternion(0, 0, toRotation);;
-    partAnim.rotationModifier.function = Ease::getFunction(functionType);
+    partAnim.rotationModifier.functionType = functionType;
+    partAnim.rotationModifier.function.clear();
 }
 
 void Particles::setRotationModifier(float fromTime, float toTime, Quaternion fromRotation, Quaternion toRotation, EaseType functionType){
@@ -315,7 +323,8 @@ void Particles::setRotationModifier(float fromTime, float toTime, Quaternion fro
     partAnim.rotationModifier.toTime = toTime;
     partAnim.rotationModifier.fromRotation = fromRotation;
     partAnim.rotationModifier.toRotation = toRotation;
-    partAnim.rotationModifier.function = Ease::getFunction(functionType);
+    partAnim.rotationModifier.functionType = functionType;
+    partAnim.rotationModifier.function.clear();
 }
 
 void Particles::setScaleInitializer(float scale){
@@ -355,6 +364,7 @@ void Particles::setScaleModifier(float fromTime, float toTime, Vector3 fromScale
     partAnim.scaleModifier.toTime = toTime;
     partAnim.scaleModifier.fromScale = fromScale;
     partAnim.scaleModifier.toScale = toScale;
-    partAnim.scaleModifier.function = Ease::getFunction(functionType);
+    partAnim.scaleModifier.functionType = functionType;
+    partAnim.scaleModifier.function.clear();
 }
 
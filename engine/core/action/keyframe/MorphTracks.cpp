@@ -22,9 +22,7 @@ MorphTracks::MorphTracks(Scene* scene, std::vector<float> times, std::vector<std
 
     keyframe.times = times;
 
-    MorphTracksComponent& morphtracks = getComponent<MorphTracksComponent>();
-
-    morphtracks.values = values;
+    setValues(values);
 }
 
 void MorphTracks::setTimes(std::vector<float> times){
@@ -36,5 +34,17 @@ void MorphTracks::setTimes(std::vector<float> times){
 void MorphTracks::setValues(std::vector<std::vector<float>> values){
     MorphTracksComponent& morphtracks = getComponent<MorphTracksComponent>();
 
-    morphtracks.values = values;
+    morphtracks.count = (values.size() > 0) ? values[0].size() : 0;
+    morphtracks.values.clear();
+    morphtracks.values.reserve(values.size() * morphtracks.count);
+
+    for (size_t i = 0; i < values.size(); i++){
+        if (values[i].size() != morphtracks.count){
+            Log::error("MorphTrack of index %i is different size than index 0", (int)i);
+            morphtracks.values.clear();
+            morphtracks.count = 0;
+            return;
+        }
+        morphtracks.values.insert(morphtracks.values.end(), values[i].begin(), values[i].end());
+    }
 }
\ No newline at end of file
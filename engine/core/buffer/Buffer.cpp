@@ -21,6 +21,9 @@ Buffer::Buffer(){
 
     renderAttributes = true;
     instanceBuffer = false;
+
+    dirtyBegin = 0;
+    dirtyEnd = 0;
 }
 
 Buffer::~Buffer(){
@@ -39,6 +42,9 @@ Buffer::Buffer(const Buffer& rhs){
     renderAttributes = rhs.renderAttributes;
     instanceBuffer = rhs.instanceBuffer;
 
+    dirtyBegin = rhs.dirtyBegin;
+    dirtyEnd = rhs.dirtyEnd;
+
     render = rhs.render;
 }
 
@@ -55,6 +61,9 @@ Buffer& Buffer::operator=(const Buffer& rhs){
     renderAttributes = rhs.renderAttributes;
     instanceBuffer = rhs.instanceBuffer;
 
+    dirtyBegin = rhs.dirtyBegin;
+    dirtyEnd = rhs.dirtyEnd;
+
     render = rhs.render;
 
     return *this;
@@ -228,11 +237,13 @@ void Buffer::setValues(unsigned int index, Attribute* attribute, unsigned int nu
             attribute->count = newCount;
 
         unsigned pos = (index * stride) + attribute->offset;
+        size_t length = numValues * typesize;
+        size_t oldSize = size;
 
-        if (resize(pos + (numValues * typesize))) {
-            for (int i = 0; i < numValues; i++) {
-                memcpy(&data[pos], &vector[i*typesize], typesize);
-                pos += typesize;
+        if (resize(pos + length)) {
+            if (pos + length > oldSize || memcmp(&data[pos], vector, length) != 0){
+                memcpy(&data[pos], vector, length);
+                markDirty(pos, pos + length);
             }
 
             if (attribute->count > count)
@@ -365,6 +376,41 @@ size_t Buffer::getSize(){
     return size;
 }
 
+void Buffer::markDirty(size_t begin, size_t end){
+    if (dirtyBegin == dirtyEnd){
+        dirtyBegin = begin;
+        dirtyEnd = end;
+    }else{
+        if (begin < dirtyBegin)
+            dirtyBegin = begin;
+        if (end > dirtyEnd)
+            dirtyEnd = end;
+    }
+}
+
+bool Buffer::isDirty() const{
+    return dirtyBegin != dirtyEnd;
+}
+
+void Buffer::clearDirty(){
+    dirtyBegin = 0;
+    dirtyEnd = 0;
+}
+
+bool Buffer::updateRender(size_t size){
+    if (!isDirty() && render.isUploaded()){
+        return true;
+    }
+
+    // sokol cycles buffer slots on each update, so the whole used range is sent
+    if (!render.updateBuffer(size, data)){
+        return false;
+    }
+    clearDirty();
+
+    return true;
+}
+
 void Buffer::setStride(unsigned int stride){
     this->stride = stride;
 }
@@ -33,8 +33,14 @@ namespace Supernova {
         bool renderAttributes;
         bool instanceBuffer;
 
+        // bytes changed since last upload, writes of equal values are ignored
+        size_t dirtyBegin;
+        size_t dirtyEnd;
+
         BufferRender render;
 
+        void markDirty(size_t begin, size_t end);
+
     public:
         Buffer();
         virtual ~Buffer();
@@ -113,6 +119,13 @@ namespace Supernova {
 
         bool isInstanceBuffer() const;
         void setInstanceBuffer(bool instanceBuffer);
+
+        bool isDirty() const;
+        void clearDirty();
+
+        // uploads to render buffer only when data changed or render buffer is new
+        // returns false if upload was dropped, data stays dirty to be sent again
+        bool updateRender(size_t size);
     };
 
 }
@@ -8,6 +8,7 @@ using namespace Supernova;
 
 ExternalBuffer::ExternalBuffer(): Buffer(){
     name = "";
+    dataHash = 0;
 }
 
 ExternalBuffer::~ExternalBuffer(){
@@ -16,19 +17,39 @@ ExternalBuffer::~ExternalBuffer(){
 
 ExternalBuffer::ExternalBuffer(const ExternalBuffer& rhs): Buffer(rhs){
     name = rhs.name;
+    dataHash = rhs.dataHash;
 }
 
 ExternalBuffer& ExternalBuffer::operator=(const ExternalBuffer& rhs){
     Buffer::operator =(rhs);
 
     name = rhs.name;
+    dataHash = rhs.dataHash;
 
     return *this;
 }
 
+uint64_t ExternalBuffer::hashData(const unsigned char* data, size_t size){
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++){
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 void ExternalBuffer::setData(unsigned char* data, size_t size){
+    uint64_t hash = (data) ? hashData(data, size) : 0;
+
+    // data is owned outside, so changes are only known by content
+    if (this->data != data || this->size != size || dataHash != hash){
+        markDirty(0, size);
+    }
+
     this->data = data;
     this->size = size;
+    this->dataHash = hash;
 }
 
 void ExternalBuffer::setName(std::string name){
@@ -7,6 +7,7 @@
 
 #include "buffer/Buffer.h"
 #include <string>
+#include <stdint.h>
 
 namespace Supernova {
 
@@ -14,6 +15,9 @@ namespace Supernova {
 
     protected:
         std::string name;
+        uint64_t dataHash;
+
+        static uint64_t hashData(const unsigned char* data, size_t size);
 
     public:
         ExternalBuffer();
@@ -15,6 +15,33 @@ namespace Supernova{
         Entity action = NULL_ENTITY;
     };
 
+    enum class AnimationChannelType{
+        TRANSLATE,
+        ROTATE,
+        SCALE
+    };
+
+    struct AnimationChannel{
+        Entity action = NULL_ENTITY;
+        Entity target = NULL_ENTITY;
+        AnimationChannelType type = AnimationChannelType::TRANSLATE;
+        uint32_t firstKey = 0; // in times
+        uint32_t keyCount = 0;
+        uint32_t firstValue = 0; // in values
+        int cursor = 0;
+        float time = 0;
+        bool active = false; // sampled in current update
+    };
+
+    // keyframe channels packed in flat arrays, sampled together
+    struct AnimationClipData{
+        std::vector<float> times;
+        std::vector<float> values; // 3 floats for translation and scale, 4 for rotation
+        std::vector<AnimationChannel> channels;
+        std::vector<int> actionChannels; // channel of each action frame, -1 is not packed
+        bool packed = false;
+    };
+
     struct AnimationComponent{
         std::vector<ActionFrame> actions;
         bool ownedActions = false;
@@ -23,6 +50,8 @@ namespace Supernova{
         std::string name;
 
         float duration = -1; // -1 is infinite
+
+        AnimationClipData clip; // built when animation starts
     };
 
     
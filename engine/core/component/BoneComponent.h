@@ -13,6 +13,7 @@ namespace Supernova{
         Entity model = NULL_ENTITY;
 
         int index;
+        int depth = 0; // from skeleton root
 
         Vector3 bindPosition;
         Quaternion bindRotation;
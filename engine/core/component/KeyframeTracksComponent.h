@@ -11,8 +11,10 @@ namespace Supernova{
 
     struct KeyframeTracksComponent{
         std::vector<float> times;
-        int index = 0;
+        int index = 0; // cursor kept between updates, first key not before current time
         float interpolation = 0;
+        bool skipUpdate = false; // set by animation level of detail, cleared when update reads it
+        bool packed = false; // sampled by its animation clip
     };
 
 }
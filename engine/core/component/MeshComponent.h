@@ -56,6 +56,7 @@ namespace Supernova{
 
         PrimitiveType primitiveType = PrimitiveType::TRIANGLES;
         unsigned int vertexCount = 0;
+        unsigned int baseElement = 0;
 
         bool enableFaceCulling = true;
         
@@ -22,10 +22,27 @@ namespace Supernova{
 
         std::map<std::string, Entity> bonesNameMapping;
         std::map<int, Entity> bonesIdMapping;
+        std::vector<Entity> bones; // skin joints, position is BoneComponent::index
+        std::vector<Matrix4> bonesOffsetMatrix; // BoneComponent::offsetMatrix of each joint, filled with bones
+        std::vector<size_t> bonesTransformIndex; // joint transforms in Transform array, rebuilt when its version changes
+        uint64_t bonesTransformVersion = 0;
 
         std::map<std::string, int> morphNameMapping;
 
         std::vector<Entity> animations;
+
+        // animation level of detail, disabled with zero distances
+        float animationLodDistance = 0; // each multiple of this distance skips one more frame
+        int animationLodMaxInterval = 4;
+        float reducedBonesDistance = 0; // beyond it only bones until reducedBonesDepth are sampled
+        int reducedBonesDepth = 4;
+        bool pauseAnimationOffscreen = false; // not for models casting shadows
+
+        // set every frame by ActionSystem
+        bool animationSkipUpdate = false;
+        bool animationReducedBones = false;
+        bool animationOffscreen = false;
+        bool needUpdateSkinning = true; // all bones, after palette was paused
     };
 
 }
@@ -10,7 +10,8 @@
 namespace Supernova{
 
     struct MorphTracksComponent{
-        std::vector<std::vector<float>> values;
+        std::vector<float> values; // weights of each key packed together
+        unsigned int count = 0; // weights per key
     };
 
 }
@@ -10,6 +10,7 @@
 #include "util/SpriteFrameData.h"
 #include "Engine.h"
 #include "buffer/ExternalBuffer.h"
+#include "action/Ease.h"
 
 namespace Supernova{
 
@@ -30,7 +31,8 @@ namespace Supernova{
         Vector3 fromPosition = Vector3(0,0,0);
         Vector3 toPosition = Vector3(0,0,0);
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
     };
 
     struct ParticleVelocityInitializer{
@@ -45,7 +47,8 @@ namespace Supernova{
         Vector3 fromVelocity = Vector3(0,0,0);
         Vector3 toVelocity = Vector3(0,0,0);
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
     };
 
     struct ParticleAccelerationInitializer{
@@ -60,7 +63,8 @@ namespace Supernova{
         Vector3 fromAcceleration = Vector3(0,0,0);
         Vector3 toAcceleration = Vector3(0,0,0);
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
     };
 
     struct ParticleColorInitializer{
@@ -77,7 +81,8 @@ namespace Supernova{
         Vector3 fromColor = Vector3(0,0,0);
         Vector3 toColor = Vector3(0,0,0);
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
 
         bool useSRGB = true;
     };
@@ -94,7 +99,8 @@ namespace Supernova{
         float fromAlpha = 0;
         float toAlpha= 0;
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
     };
 
     struct ParticleSizeInitializer{
@@ -109,7 +115,8 @@ namespace Supernova{
         float fromSize = 0;
         float toSize = 0;
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
     };
 
     struct ParticleSpriteInitializer{
@@ -122,7 +129,8 @@ namespace Supernova{
 
         std::vector<int> frames;
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
     };
 
     struct ParticleRotationInitializer{
@@ -139,7 +147,8 @@ namespace Supernova{
         Quaternion fromRotation;
         Quaternion toRotation;
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
 
         bool shortestPath = false;
     };
@@ -158,25 +167,46 @@ namespace Supernova{
         Vector3 fromScale = Vector3(1,1,1);
         Vector3 toScale = Vector3(1,1,1);
 
-        FunctionSubscribe<float(float)> function = std::function<float(float)>(Ease::linear);
+        EaseType functionType = EaseType::LINEAR;
+        FunctionSubscribe<float(float)> function; // replaces functionType when set
     };
 
-    struct ParticleData{
-        float life = 1;
-        Vector3 velocity = Vector3(0,0,0);
-        Vector3 acceleration = Vector3(0,0,0);
+    // one array for each value, sized in blocks of 4 particles
+    struct ParticlesData{
+        std::vector<float> life;
+        std::vector<float> time;
 
-        float time = 0;
+        std::vector<float> positionX;
+        std::vector<float> positionY;
+        std::vector<float> positionZ;
+
+        std::vector<float> velocityX;
+        std::vector<float> velocityY;
+        std::vector<float> velocityZ;
+
+        std::vector<float> accelerationX;
+        std::vector<float> accelerationY;
+        std::vector<float> accelerationZ;
+
+        // bits of particles alive before last step, one byte for each block
+        std::vector<uint8_t> alive;
+
+        // dead particles ready to be emitted again, last is used first
+        std::vector<uint32_t> freeSlots;
+
+        uint64_t random = 1;
     };
 
     struct ParticlesComponent{
-        std::vector<ParticleData> particles;
+        ParticlesData particles;
 
         unsigned int maxParticles = 100;
+        unsigned int seed = 0; // random stream of emitter, 0 is based on entity
 
         // animation
         float newParticlesCount = 0;
         int lastUsedParticle = 0;
+        unsigned int emittedParticles = 0; // non-loop emitter stops at maxParticles
         bool emitter = false;
 
         bool loop = true;
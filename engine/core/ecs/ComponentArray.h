@@ -7,7 +7,8 @@
     
 #include <array>
 #include <cassert>
-#include <unordered_map>
+#include <cstdint>
+#include <limits>
 #include <vector>
 #include <algorithm>
 #include <functional>
@@ -28,34 +29,90 @@ namespace Supernova {
 	template<typename T>
 	class ComponentArray : public ComponentArrayBase{
 	private:
+		// Sparse set: dense arrays keep hierarchy order and sparse pages map entity to dense index
+		static constexpr size_t SPARSE_PAGE_SIZE = 4096;
+		static constexpr size_t INVALID_INDEX = std::numeric_limits<size_t>::max();
+
 		std::vector<T> componentArray{};
-		std::unordered_map<Entity, size_t> entityToIndexMap{};
-		std::unordered_map<size_t, Entity> indexToEntityMap{};
+		std::vector<Entity> indexToEntity{};
+		std::vector<std::unique_ptr<size_t[]>> entityToIndexPages{};
+		// Changed on every insert, remove or reorder, used to invalidate cached views
+		uint64_t version = 0;
+
+		size_t findSlotIndex(Entity entity) const{
+			size_t page = getEntityIndex(entity) / SPARSE_PAGE_SIZE;
+			if (page >= entityToIndexPages.size() || !entityToIndexPages[page]){
+				return INVALID_INDEX;
+			}
+			return entityToIndexPages[page][getEntityIndex(entity) % SPARSE_PAGE_SIZE];
+		}
 
-		void moveRange(size_t start, size_t length, size_t dst){
-    		typename std::vector<T>::iterator first, middle, last;
+		// also rejects stale handles of a recycled entity index
+		size_t findIndex(Entity entity) const{
+			size_t index = findSlotIndex(entity);
+			if (index == INVALID_INDEX || indexToEntity[index] != entity){
+				return INVALID_INDEX;
+			}
+			return index;
+		}
+
+		void setIndex(Entity entity, size_t index){
+			size_t page = getEntityIndex(entity) / SPARSE_PAGE_SIZE;
+			if (page >= entityToIndexPages.size()){
+				entityToIndexPages.resize(page + 1);
+			}
+			if (!entityToIndexPages[page]){
+				entityToIndexPages[page].reset(new size_t[SPARSE_PAGE_SIZE]);
+				std::fill_n(entityToIndexPages[page].get(), SPARSE_PAGE_SIZE, INVALID_INDEX);
+			}
+			entityToIndexPages[page][getEntityIndex(entity) % SPARSE_PAGE_SIZE] = index;
+		}
+
+		void updateIndexes(size_t first, size_t last){
+			for (size_t i = first; i < last; i++){
+				setIndex(indexToEntity[i], i);
+			}
+		}
+
+		template<typename V>
+		static void moveRange(std::vector<V>& vec, size_t start, size_t length, size_t dst){
+    		typename std::vector<V>::iterator first, middle, last;
     		if (start < dst){
-        		first  = componentArray.begin() + start;
+        		first  = vec.begin() + start;
         		middle = first + length;
-        		last   = componentArray.begin() + dst + length;
+        		last   = vec.begin() + dst + length;
     		}else{
-        		first  = componentArray.begin() + dst;
-        		middle = componentArray.begin() + start;
+        		first  = vec.begin() + dst;
+        		middle = vec.begin() + start;
         		last   = middle + length;
     		}
     		std::rotate(first, middle, last);
 		}
 
+		void moveRange(size_t start, size_t length, size_t dst){
+			moveRange(componentArray, start, length, dst);
+			moveRange(indexToEntity, start, length, dst);
+
+			updateIndexes(std::min(start, dst), std::max(start, dst) + length);
+
+			version++;
+		}
+
+		template<typename C>
+		friend class ComponentArray;
+
 	public:
 		void insert(Entity entity, T component) {
-			if (entityToIndexMap.find(entity) == entityToIndexMap.end()){
+			if (findSlotIndex(entity) == INVALID_INDEX){
 
 				size_t newIndex = componentArray.size();
 
-				entityToIndexMap[entity] = newIndex;
-				indexToEntityMap[newIndex] = entity;
-
 				componentArray.push_back(component);
+				indexToEntity.push_back(entity);
+
+				setIndex(entity, newIndex);
+
+				version++;
 
 			} else {
 				Log::error("Component added to same entity more than once");
@@ -63,23 +120,18 @@ namespace Supernova {
 		}
 
 		void remove(Entity entity) {
+			size_t indexOfRemovedEntity = findIndex(entity);
 
-			if (entityToIndexMap.find(entity) != entityToIndexMap.end()){
-
-				// Remove component
-				size_t indexOfRemovedEntity = entityToIndexMap[entity];
-				componentArray.erase(componentArray. begin() + indexOfRemovedEntity);
-				size_t componentSize = componentArray.size();
-                
-                // Update maps
-                for (size_t i = indexOfRemovedEntity; i < componentSize; i++){
-                    Entity temp = indexToEntityMap[i+1];
-                    entityToIndexMap[temp] = i;
-                    indexToEntityMap[i] = temp;
-                }
-                
-                entityToIndexMap.erase(entity);
-                indexToEntityMap.erase(componentSize);
+			if (indexOfRemovedEntity != INVALID_INDEX){
+
+				// Erase keeping order, components are sorted by hierarchy
+				componentArray.erase(componentArray.begin() + indexOfRemovedEntity);
+				indexToEntity.erase(indexToEntity.begin() + indexOfRemovedEntity);
+
+				setIndex(entity, INVALID_INDEX);
+				updateIndexes(indexOfRemovedEntity, indexToEntity.size());
+
+				version++;
 
 			} else {
 				Log::error("Removing non-existent component");
@@ -88,110 +140,84 @@ namespace Supernova {
 
 		void moveEntityRangeToIndex(Entity start, Entity end, size_t newIndex){
 
-			size_t startIndex = entityToIndexMap[start];
-			size_t endIndex = entityToIndexMap[end];
+			size_t startIndex = getIndex(start);
+			size_t endIndex = getIndex(end);
 			size_t length = endIndex - startIndex + 1;
-			size_t oldIndex = startIndex;
 
-			if (newIndex < 0 || (newIndex + length) > componentArray.size()){
+			if ((newIndex + length) > componentArray.size()){
 				Log::error("Cannot move entity range out of array");
 				return;
 			}
 
-			std::vector<Entity> tmp(length);
-			for (int i = 0; i < length; i++){
-				tmp[i] = indexToEntityMap[oldIndex+i];
-			}
-
-			if (oldIndex > newIndex){
-				for (size_t i = oldIndex+length-1; i > newIndex+length-1; i--){
-					Entity moved = indexToEntityMap[i-length];
-					entityToIndexMap[moved] = i;
-					indexToEntityMap[i] = moved;
-				}
-			}else{
-				for (size_t i = oldIndex; i < newIndex; i++){
-					Entity moved = indexToEntityMap[i+length];
-					entityToIndexMap[moved] = i;
-					indexToEntityMap[i] = moved;
-				}
-			}
-
-			for (int i = 0; i < tmp.size(); i++){
-				entityToIndexMap[tmp[i]] = newIndex+i;
-				indexToEntityMap[newIndex+i] = tmp[i];
-			}
-
-			moveRange(oldIndex, length, newIndex);
+			moveRange(startIndex, length, newIndex);
 		}
 
 		void moveEntityToIndex(Entity entity, size_t newIndex){
 
-			size_t oldIndex = entityToIndexMap[entity];
+			size_t oldIndex = getIndex(entity);
 
-			if (oldIndex > newIndex){
-				for (size_t i = oldIndex; i >= newIndex+1; i--){
-					Entity moved = indexToEntityMap[i-1];
-					entityToIndexMap[moved] = i;
-					indexToEntityMap[i] = moved;
-				}
-			}else{
-				for (size_t i = oldIndex; i <= newIndex-1; i++){
-					Entity moved = indexToEntityMap[i+1];
-					entityToIndexMap[moved] = i;
-					indexToEntityMap[i] = moved;
-				}
+			if (newIndex >= componentArray.size()){
+				Log::error("Cannot move entity out of array");
+				return;
 			}
 
-			entityToIndexMap[entity] = newIndex;
-			indexToEntityMap[newIndex] = entity;
-
 			moveRange(oldIndex, 1, newIndex);
 		}
 
+		// Stable reorder following other array order, entities not found there go to the end
 		template<typename C>
 		void sortByComponent(std::shared_ptr<ComponentArray<C>> otherComponent){
-			if (size() > 1){
-				for (int i = 1; i < size(); i++){
-					Entity entity1 = indexToEntityMap[i];
-					size_t indexC1 = otherComponent->getIndex(entity1);
+			size_t count = size();
+			if (count < 2){
+				return;
+			}
+
+			std::vector<std::pair<size_t, size_t>> order(count);
+			for (size_t i = 0; i < count; i++){
+				order[i] = {otherComponent->findIndex(indexToEntity[i]), i};
+			}
+
+			auto lessOther = [](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b){ return a.first < b.first; };
 
-					for (int j = 0; j < i; j++){
-						Entity entity2 = indexToEntityMap[j];
-						size_t indexC2 = otherComponent->getIndex(entity2);
+			if (std::is_sorted(order.begin(), order.end(), lessOther)){
+				return;
+			}
 
-						if (indexC1 < indexC2){
-							moveEntityToIndex(entity1, j);
-							break;
-						}
-					}
-				}
+			std::stable_sort(order.begin(), order.end(), lessOther);
+
+			std::vector<T> sortedComponents;
+			std::vector<Entity> sortedEntities;
+			sortedComponents.reserve(count);
+			sortedEntities.reserve(count);
+			for (size_t i = 0; i < count; i++){
+				sortedComponents.push_back(std::move(componentArray[order[i].second]));
+				sortedEntities.push_back(indexToEntity[order[i].second]);
 			}
+
+			componentArray.swap(sortedComponents);
+			indexToEntity.swap(sortedEntities);
+
+			updateIndexes(0, count);
+
+			version++;
 		}
 
 		T* findComponent(Entity entity) {
-			auto it = entityToIndexMap.find(entity);
+			size_t index = findIndex(entity);
 
-			if (it == entityToIndexMap.end()) {
+			if (index == INVALID_INDEX) {
 				 return NULL;
 			}
 
-			return &componentArray[it->second];
+			return &componentArray[index];
 		}
 
 		T& getComponent(Entity entity) {
-			try{
-
-				return componentArray[entityToIndexMap.at(entity)];
-
-			}catch (const std::out_of_range& e){
-				Log::error("Retrieving non-existent component: %s", e.what());
-				throw;
-			}
+			return componentArray[getIndex(entity)];
 		}
 
 		T* findComponentFromIndex(size_t index) {
-			if (index < 0 || index >= componentArray.size()){
+			if (index >= componentArray.size()){
 				return NULL;
 			}
 
@@ -210,31 +236,39 @@ namespace Supernova {
 		}
 
 		size_t getIndex(Entity entity){
-			try{
-
-				return entityToIndexMap.at(entity);
+			size_t index = findIndex(entity);
 
-			}catch (const std::out_of_range& e){
-				Log::error("Retrieving non-existent component: %s", e.what());
-				throw;
+			if (index == INVALID_INDEX){
+				Log::error("Retrieving non-existent component: entity %u", entity);
+				throw std::out_of_range("ComponentArray::getIndex");
 			}
+
+			return index;
 		}
 
 		Entity getEntity(size_t index){
-			if (indexToEntityMap.find(index) == indexToEntityMap.end()){
+			if (index >= indexToEntity.size()){
 				Log::error("Entity not found");
 				return NULL_ENTITY;
 			}
 
-			return indexToEntityMap[index];
+			return indexToEntity[index];
+		}
+
+		bool contains(Entity entity) const{
+			return findIndex(entity) != INVALID_INDEX;
 		}
 
 		size_t size(){
 			return componentArray.size();
 		}
 
+		uint64_t getVersion() const{
+			return version;
+		}
+
 		void entityDestroyed(Entity entity) override {
-			if (entityToIndexMap.find(entity) != entityToIndexMap.end()) {
+			if (findIndex(entity) != INVALID_INDEX) {
 				remove(entity);
 			}
 		}
@@ -6,33 +6,69 @@
 #define COMPONENTMANAGER_H
 
 #include <any>
+#include <array>
+#include <atomic>
+#include <map>
 #include <memory>
-#include <unordered_map>
 #include "ComponentArray.h"
+#include "EntityView.h"
 #include "Log.h"
 
 namespace Supernova {
 
 	using ComponentId = unsigned char;
 
+	// Must fit in Signature bits
+	#define MAX_COMPONENTS 64
+
+
+	class ComponentType {
+	private:
+		static ComponentId nextId() {
+			static std::atomic<unsigned> counter{0};
+
+			unsigned id = counter++;
+			if (id >= MAX_COMPONENTS){
+				Log::error("Component types exceeded MAX_COMPONENTS (%i)", MAX_COMPONENTS);
+				throw std::out_of_range("Component types exceeded MAX_COMPONENTS");
+			}
+
+			return (ComponentId)id;
+		}
+
+	public:
+		// Assigned once per type on first use, same value for all scenes
+		template<typename T>
+		static ComponentId id() {
+			static const ComponentId typeId = nextId();
+			return typeId;
+		}
+	};
+
 
 	class ComponentManager {
 	private:
-		std::unordered_map<const char*, ComponentId> componentTypeIds{};
-		std::unordered_map<const char*, std::shared_ptr<ComponentArrayBase>> componentArrays{};
-		ComponentId nextComponentIdId{};
+		std::array<std::shared_ptr<ComponentArrayBase>, MAX_COMPONENTS> componentArrays{};
+		std::map<std::vector<ComponentId>, EntityViewCache> viewCaches{};
+
+		template<typename T>
+		ComponentArray<T>* getComponentArrayPtr() {
+			ComponentArrayBase* componentArray = componentArrays[ComponentType::id<T>()].get();
+
+			if (!componentArray)
+				Log::error("Component not registered before use");
+
+			return static_cast<ComponentArray<T>*>(componentArray);
+		}
 
 	public:
 		template<typename T>
 		void registerComponent() {
-			const char* typeName = typeid(T).name();
-
-			if (componentTypeIds.find(typeName) == componentTypeIds.end()){
+			ComponentId componentId = ComponentType::id<T>();
 
-				componentTypeIds.insert({typeName, nextComponentIdId});
-				componentArrays.insert({typeName, std::make_shared<ComponentArray<T>>()});
+			if (!componentArrays[componentId]){
 
-				++nextComponentIdId;
+				componentArrays[componentId] = std::make_shared<ComponentArray<T>>();
 
 			} else {
 				Log::error("Registering component type more than once");
@@ -42,57 +78,78 @@ namespace Supernova {
 
 		template<typename T>
 		ComponentId getComponentId() {
-			const char* typeName = typeid(T).name();
-
-			if (componentTypeIds.find(typeName) == componentTypeIds.end())
-				Log::error("Component not registered before use");
-
-			return componentTypeIds[typeName];
+			return ComponentType::id<T>();
 		}
 
 		template<typename T>
 		std::shared_ptr<ComponentArray<T>> getComponentArray() {
-			const char* typeName = typeid(T).name();
-
-			if (componentTypeIds.find(typeName) == componentTypeIds.end())
+			if (!componentArrays[ComponentType::id<T>()])
 				Log::error("Component not registered before use");
 
-			return std::static_pointer_cast<ComponentArray<T>>(componentArrays[typeName]);
+			return std::static_pointer_cast<ComponentArray<T>>(componentArrays[ComponentType::id<T>()]);
 		}
 
 		template<typename T>
 		void addComponent(Entity entity, T component) {
-			getComponentArray<T>()->insert(entity, component);
+			getComponentArrayPtr<T>()->insert(entity, component);
 		}
 
 		template<typename T>
 		void removeComponent(Entity entity) {
-			getComponentArray<T>()->remove(entity);
+			getComponentArrayPtr<T>()->remove(entity);
 		}
 
 		template<typename T>
 		T* findComponent(Entity entity) {
-			return getComponentArray<T>()->findComponent(entity);
+			return getComponentArrayPtr<T>()->findComponent(entity);
 		}
 
 		template<typename T>
 		T& getComponent(Entity entity) {
-			return getComponentArray<T>()->getComponent(entity);
+			return getComponentArrayPtr<T>()->getComponent(entity);
 		}
 
 		template<typename T>
 	    T* findComponentFromIndex(size_t index) {
-		    return getComponentArray<T>()->findComponentFromIndex(index);
+		    return getComponentArrayPtr<T>()->findComponentFromIndex(index);
 	    }
 
 		template<typename T>
 	    T& getComponentFromIndex(size_t index) {
-		    return getComponentArray<T>()->getComponentFromIndex(index);
+		    return getComponentArrayPtr<T>()->getComponentFromIndex(index);
 	    }
 
+		template<typename T, typename... Ts>
+		EntityView<T, Ts...> view() {
+			typename EntityView<T, Ts...>::Arrays arrays{getComponentArrayPtr<T>(), getComponentArrayPtr<Ts>()...};
+			std::vector<uint64_t> versions = std::apply([](auto*... array){ return std::vector<uint64_t>{array->getVersion()...}; }, arrays);
+
+			EntityViewCache& cache = viewCaches[{getComponentId<T>(), getComponentId<Ts>()...}];
+
+			if (!cache.entities || cache.versions != versions){
+				ComponentArray<T>* first = std::get<0>(arrays);
+
+				auto entities = std::make_shared<std::vector<Entity>>();
+				entities->reserve(first->size());
+				for (size_t i = 0; i < first->size(); i++){
+					Entity entity = first->getEntity(i);
+					if (std::apply([entity](auto*... array){ return (array->contains(entity) && ...); }, arrays)){
+						entities->push_back(entity);
+					}
+				}
+
+				cache.entities = entities;
+				cache.versions = versions;
+			}
+
+			return EntityView<T, Ts...>(arrays, cache.entities);
+		}
+
 		void entityDestroyed(Entity entity) {
-			for (auto const& pair : componentArrays) {
-				pair.second->entityDestroyed(entity);
+			for (auto const& componentArray : componentArrays) {
+				if (componentArray){
+					componentArray->entityDestroyed(entity);
+				}
 			}
 		}
 	};
@@ -7,10 +7,27 @@
 
 #define NULL_ENTITY 0
 
+// Entity handle bits: lower part is a recycled index, upper part is a generation to detect stale handles
+#define ENTITY_INDEX_BITS 20
+#define ENTITY_INDEX_MASK ((1u << ENTITY_INDEX_BITS) - 1)
+#define ENTITY_GENERATION_MASK ((1u << (32 - ENTITY_INDEX_BITS)) - 1)
+
 namespace Supernova{
 
     using Entity = unsigned;
 
+    inline unsigned getEntityIndex(Entity entity){
+        return entity & ENTITY_INDEX_MASK;
+    }
+
+    inline unsigned getEntityGeneration(Entity entity){
+        return (entity >> ENTITY_INDEX_BITS) & ENTITY_GENERATION_MASK;
+    }
+
+    inline Entity makeEntity(unsigned index, unsigned generation){
+        return (index & ENTITY_INDEX_MASK) | ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS);
+    }
+
 }
 
-#endif //ENTITY_H
\ No newline at end of file
+#endif //ENTITY_H
@@ -5,7 +5,9 @@
 #ifndef ENTITYMANAGER_H
 #define ENTITYMANAGER_H
 
-#include <map>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include "Entity.h"
 #include "Signature.h"
@@ -13,78 +15,163 @@
 
 namespace Supernova{
 
-    struct EntityMetadata{
-        std::string name;
+    struct EntitySlot{
         Signature signature;
+        unsigned generation = 0;
+        bool alive = false;
     };
 
     class EntityManager {
     private:
-        unsigned lastEntity = 0;
-        std::map<Entity, EntityMetadata> metadata;
+        // indexed by entity index, slot 0 is reserved for NULL_ENTITY
+        std::vector<EntitySlot> slots = std::vector<EntitySlot>(1);
+        std::vector<unsigned> freeIndexes;
+        // names are rare, kept apart from signatures
+        std::unordered_map<Entity, std::string> names;
+
+        EntitySlot* findSlot(Entity entity){
+            unsigned index = getEntityIndex(entity);
+            if (index == NULL_ENTITY || index >= slots.size()){
+                return NULL;
+            }
+
+            EntitySlot& slot = slots[index];
+            if (!slot.alive || slot.generation != getEntityGeneration(entity)){
+                return NULL;
+            }
+
+            return &slot;
+        }
+
+        const EntitySlot* findSlot(Entity entity) const{
+            return const_cast<EntityManager*>(this)->findSlot(entity);
+        }
 
     public:
 
         Entity createEntity() {
-            lastEntity++;
-            metadata[lastEntity];
+            unsigned index;
+            if (!freeIndexes.empty()){
+                index = freeIndexes.back();
+                freeIndexes.pop_back();
+            }else{
+                index = slots.size();
+                if (index > ENTITY_INDEX_MASK){
+                    Log::error("Maximum number of entities reached");
+                    return NULL_ENTITY;
+                }
+                slots.emplace_back();
+            }
+
+            EntitySlot& slot = slots[index];
+            slot.alive = true;
+            slot.signature.reset();
 
-            return lastEntity;
+            return makeEntity(index, slot.generation);
         }
 
         Entity createEntityInternal(Entity entity) { // for internal editor use only
-            metadata[entity];
+            unsigned index = getEntityIndex(entity);
+            if (index == NULL_ENTITY){
+                Log::error("Cannot create null entity");
+                return NULL_ENTITY;
+            }
+
+            if (index >= slots.size()){
+                for (unsigned i = slots.size(); i < index; i++){
+                    freeIndexes.push_back(i);
+                }
+                slots.resize(index + 1);
+            }else{
+                auto it = std::find(freeIndexes.begin(), freeIndexes.end(), index);
+                if (it != freeIndexes.end()){
+                    freeIndexes.erase(it);
+                }
+            }
+
+            EntitySlot& slot = slots[index];
+            slot.alive = true;
+            slot.generation = getEntityGeneration(entity);
 
             return entity;
         }
 
         void destroy(Entity entity) {
-            metadata.erase(entity);
+            EntitySlot* slot = findSlot(entity);
+            if (!slot){
+                return;
+            }
+
+            slot->alive = false;
+            slot->signature.reset();
+            slot->generation = (slot->generation + 1) & ENTITY_GENERATION_MASK;
+
+            freeIndexes.push_back(getEntityIndex(entity));
+            names.erase(entity);
+        }
+
+        bool isValid(Entity entity) const{
+            return findSlot(entity) != NULL;
         }
 
         std::vector<Entity> getEntityList(){
             std::vector<Entity> list;
-            for (auto const& [key, val] : metadata){
-                list.push_back(key);
+            for (unsigned i = 1; i < slots.size(); i++){
+                if (slots[i].alive){
+                    list.push_back(makeEntity(i, slots[i].generation));
+                }
             }
             return list;
         }
 
         void setSignature(Entity entity, Signature signature) {
-            if (metadata.count(entity)==0){
+            EntitySlot* slot = findSlot(entity);
+            if (!slot){
                 Log::error("Entity does not exist to set signature");
+                return;
             }
 
-            metadata[entity].signature = signature;
+            slot->signature = signature;
         }
 
         Signature getSignature(Entity entity) const{
-            if (metadata.count(entity)==0){
+            const EntitySlot* slot = findSlot(entity);
+            if (!slot){
                  Log::error("Entity does not exist to get signature");
                  return Signature();
             }
 
-            return metadata.at(entity).signature;
+            return slot->signature;
         }
 
         void setName(Entity entity, std::string name) {
-            if (metadata.count(entity)==0){
+            if (!findSlot(entity)){
                 Log::error("Entity does not exist to set name");
+                return;
             }
 
-            metadata[entity].name = name;
+            if (name.empty()){
+                names.erase(entity);
+            }else{
+                names[entity] = name;
+            }
         }
 
         std::string getName(Entity entity) const{
-            if (metadata.count(entity)==0){
+            if (!findSlot(entity)){
                  Log::error("Entity does not exist to get name");
                  return std::string();
             }
 
-            return metadata.at(entity).name;
+            auto it = names.find(entity);
+            if (it == names.end()){
+                return std::string();
+            }
+
+            return it->second;
         }
     };
 
 }
 
-#endif //ENTITYMANAGER_H
\ No newline at end of file
+#endif //ENTITYMANAGER_H
@@ -0,0 +1,106 @@
+//
+// (c) 2024 Eduardo Doria.
+//
+
+#ifndef ENTITYVIEW_H
+#define ENTITYVIEW_H
+
+#include <memory>
+#include <tuple>
+#include <vector>
+#include "Entity.h"
+#include "ComponentArray.h"
+
+namespace Supernova {
+
+	// Entities matching a set of components, ordered like the first component array
+	struct EntityViewCache{
+		std::shared_ptr<std::vector<Entity>> entities;
+		std::vector<uint64_t> versions;
+	};
+
+	template<typename... Ts>
+	class EntityView{
+	public:
+		using Arrays = std::tuple<ComponentArray<Ts>*...>;
+		using Value = std::tuple<Entity, Ts&...>;
+
+		class Iterator{
+		private:
+			const EntityView* view;
+			size_t index;
+
+			// entities destroyed or changed while iterating are skipped
+			void skipInvalid(){
+				while (index < view->size() && !view->isValid(index)){
+					index++;
+				}
+			}
+
+		public:
+			Iterator(const EntityView* view, size_t index): view(view), index(index){
+				skipInvalid();
+			}
+
+			Value operator*() const{
+				return (*view)[index];
+			}
+
+			Iterator& operator++(){
+				index++;
+				skipInvalid();
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const{
+				return index == other.index;
+			}
+
+			bool operator!=(const Iterator& other) const{
+				return index != other.index;
+			}
+		};
+
+	private:
+		Arrays arrays;
+		// shared with cache, a rebuild while iterating does not invalidate this list
+		std::shared_ptr<std::vector<Entity>> entities;
+
+	public:
+		EntityView(Arrays arrays, std::shared_ptr<std::vector<Entity>> entities): arrays(arrays), entities(entities){
+		}
+
+		Iterator begin() const{
+			return Iterator(this, 0);
+		}
+
+		Iterator end() const{
+			return Iterator(this, size());
+		}
+
+		size_t size() const{
+			return entities->size();
+		}
+
+		bool empty() const{
+			return entities->empty();
+		}
+
+		Entity getEntity(size_t index) const{
+			return (*entities)[index];
+		}
+
+		bool isValid(size_t index) const{
+			Entity entity = (*entities)[index];
+			return std::apply([entity](auto*... array){ return (array->contains(entity) && ...); }, arrays);
+		}
+
+		Value operator[](size_t index) const{
+			Entity entity = (*entities)[index];
+			return std::apply([entity](auto*... array){ return Value(entity, array->getComponent(entity)...); }, arrays);
+		}
+	};
+
+}
+
+#endif //ENTITYVIEW_H
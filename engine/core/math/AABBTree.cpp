@@ -0,0 +1,528 @@
+#include "AABBTree.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Supernova;
+
+AABBTree::AABBTree(): AABBTree(0.1f){
+}
+
+AABBTree::AABBTree(float margin){
+    this->margin = margin;
+
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    leafCount = 0;
+}
+
+void AABBTree::clear(){
+    nodes.clear();
+
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    leafCount = 0;
+}
+
+void AABBTree::setMargin(float margin){
+    this->margin = margin;
+}
+
+float AABBTree::getMargin() const{
+    return margin;
+}
+
+float AABBTree::surfaceArea(const Vector3& min, const Vector3& max){
+    Vector3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+int32_t AABBTree::allocateNode(){
+    int32_t nodeId;
+    if (freeList == NULL_NODE){
+        nodeId = (int32_t)nodes.size();
+        nodes.emplace_back();
+    }else{
+        nodeId = freeList;
+        freeList = nodes[nodeId].parent;
+    }
+
+    Node& node = nodes[nodeId];
+    node.parent = NULL_NODE;
+    node.child1 = NULL_NODE;
+    node.child2 = NULL_NODE;
+    node.height = 0;
+    node.entity = NULL_ENTITY;
+    node.data = 0;
+
+    return nodeId;
+}
+
+void AABBTree::freeNode(int32_t nodeId){
+    nodes[nodeId].parent = freeList;
+    nodes[nodeId].height = -1;
+    freeList = nodeId;
+}
+
+int32_t AABBTree::createProxy(const AABB& box, Entity entity, uint32_t data){
+    if (box.isNull() || box.isInfinite()){
+        return NULL_NODE;
+    }
+
+    int32_t proxy = allocateNode();
+
+    Vector3 extension = box.getSize() * margin;
+
+    Node& node = nodes[proxy];
+    node.min = box.getMinimum() - extension;
+    node.max = box.getMaximum() + extension;
+    node.entity = entity;
+    node.data = data;
+
+    insertLeaf(proxy);
+    leafCount++;
+
+    return proxy;
+}
+
+void AABBTree::destroyProxy(int32_t proxy){
+    if (proxy < 0 || proxy >= (int32_t)nodes.size() || !nodes[proxy].isLeaf() || nodes[proxy].height < 0){
+        return;
+    }
+
+    removeLeaf(proxy);
+    freeNode(proxy);
+    leafCount--;
+}
+
+bool AABBTree::moveProxy(int32_t proxy, const AABB& box){
+    if (box.isNull() || box.isInfinite()){
+        return false;
+    }
+
+    Node& node = nodes[proxy];
+
+    const Vector3& min = box.getMinimum();
+    const Vector3& max = box.getMaximum();
+
+    if (node.min.x <= min.x && node.min.y <= min.y && node.min.z <= min.z &&
+        max.x <= node.max.x && max.y <= node.max.y && max.z <= node.max.z){
+        // still inside enlarged box, but shrink if it became too large
+        Vector3 extension = box.getSize() * (margin * 4.0f);
+        Vector3 bigMin = min - extension;
+        Vector3 bigMax = max + extension;
+        if (bigMin.x <= node.min.x && bigMin.y <= node.min.y && bigMin.z <= node.min.z &&
+            node.max.x <= bigMax.x && node.max.y <= bigMax.y && node.max.z <= bigMax.z){
+            return false;
+        }
+    }
+
+    removeLeaf(proxy);
+
+    Vector3 extension = box.getSize() * margin;
+    nodes[proxy].min = min - extension;
+    nodes[proxy].max = max + extension;
+
+    insertLeaf(proxy);
+
+    return true;
+}
+
+Entity AABBTree::getEntity(int32_t proxy) const{
+    return nodes[proxy].entity;
+}
+
+uint32_t AABBTree::getData(int32_t proxy) const{
+    return nodes[proxy].data;
+}
+
+void AABBTree::setData(int32_t proxy, uint32_t data){
+    nodes[proxy].data = data;
+}
+
+AABB AABBTree::getFatAABB(int32_t proxy) const{
+    return AABB(nodes[proxy].min, nodes[proxy].max);
+}
+
+size_t AABBTree::size() const{
+    return leafCount;
+}
+
+int32_t AABBTree::getHeight() const{
+    if (root == NULL_NODE){
+        return 0;
+    }
+    return nodes[root].height;
+}
+
+void AABBTree::insertLeaf(int32_t leaf){
+    if (root == NULL_NODE){
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    Vector3 leafMin = nodes[leaf].min;
+    Vector3 leafMax = nodes[leaf].max;
+
+    // find the best sibling by surface area heuristic
+    int32_t index = root;
+    while (!nodes[index].isLeaf()){
+        int32_t child1 = nodes[index].child1;
+        int32_t child2 = nodes[index].child2;
+
+        float area = surfaceArea(nodes[index].min, nodes[index].max);
+
+        Vector3 combinedMin = Vector3(std::min(nodes[index].min.x, leafMin.x), std::min(nodes[index].min.y, leafMin.y), std::min(nodes[index].min.z, leafMin.z));
+        Vector3 combinedMax = Vector3(std::max(nodes[index].max.x, leafMax.x), std::max(nodes[index].max.y, leafMax.y), std::max(nodes[index].max.z, leafMax.z));
+        float combinedArea = surfaceArea(combinedMin, combinedMax);
+
+        // cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combinedArea;
+
+        // minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float childCost[2];
+        int32_t children[2] = {child1, child2};
+        for (int c = 0; c < 2; c++){
+            const Node& child = nodes[children[c]];
+            Vector3 cMin = Vector3(std::min(child.min.x, leafMin.x), std::min(child.min.y, leafMin.y), std::min(child.min.z, leafMin.z));
+            Vector3 cMax = Vector3(std::max(child.max.x, leafMax.x), std::max(child.max.y, leafMax.y), std::max(child.max.z, leafMax.z));
+            if (child.isLeaf()){
+                childCost[c] = surfaceArea(cMin, cMax) + inheritanceCost;
+            }else{
+                childCost[c] = (surfaceArea(cMin, cMax) - surfaceArea(child.min, child.max)) + inheritanceCost;
+            }
+        }
+
+        if (cost < childCost[0] && cost < childCost[1]){
+            break;
+        }
+
+        index = (childCost[0] < childCost[1]) ? child1 : child2;
+    }
+
+    int32_t sibling = index;
+
+    int32_t oldParent = nodes[sibling].parent;
+    int32_t newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].min = Vector3(std::min(nodes[sibling].min.x, leafMin.x), std::min(nodes[sibling].min.y, leafMin.y), std::min(nodes[sibling].min.z, leafMin.z));
+    nodes[newParent].max = Vector3(std::max(nodes[sibling].max.x, leafMax.x), std::max(nodes[sibling].max.y, leafMax.y), std::max(nodes[sibling].max.z, leafMax.z));
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+
+    if (oldParent != NULL_NODE){
+        if (nodes[oldParent].child1 == sibling){
+            nodes[oldParent].child1 = newParent;
+        }else{
+            nodes[oldParent].child2 = newParent;
+        }
+    }else{
+        root = newParent;
+    }
+
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    fixUpwards(nodes[leaf].parent);
+}
+
+void AABBTree::removeLeaf(int32_t leaf){
+    if (leaf == root){
+        root = NULL_NODE;
+        return;
+    }
+
+    int32_t parent = nodes[leaf].parent;
+    int32_t grandParent = nodes[parent].parent;
+    int32_t sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent != NULL_NODE){
+        if (nodes[grandParent].child1 == parent){
+            nodes[grandParent].child1 = sibling;
+        }else{
+            nodes[grandParent].child2 = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        fixUpwards(grandParent);
+    }else{
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+    }
+}
+
+void AABBTree::fixUpwards(int32_t index){
+    while (index != NULL_NODE){
+        index = balance(index);
+
+        Node& node = nodes[index];
+        const Node& child1 = nodes[node.child1];
+        const Node& child2 = nodes[node.child2];
+
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.min = Vector3(std::min(child1.min.x, child2.min.x), std::min(child1.min.y, child2.min.y), std::min(child1.min.z, child2.min.z));
+        node.max = Vector3(std::max(child1.max.x, child2.max.x), std::max(child1.max.y, child2.max.y), std::max(child1.max.z, child2.max.z));
+
+        index = node.parent;
+    }
+}
+
+// rotates A if its subtrees are unbalanced, returns the new subtree root
+int32_t AABBTree::balance(int32_t iA){
+    Node* A = &nodes[iA];
+    if (A->isLeaf() || A->height < 2){
+        return iA;
+    }
+
+    int32_t iB = A->child1;
+    int32_t iC = A->child2;
+    int32_t balanceFactor = nodes[iC].height - nodes[iB].height;
+
+    auto refit = [this](int32_t i){
+        Node& n = nodes[i];
+        const Node& c1 = nodes[n.child1];
+        const Node& c2 = nodes[n.child2];
+        n.min = Vector3(std::min(c1.min.x, c2.min.x), std::min(c1.min.y, c2.min.y), std::min(c1.min.z, c2.min.z));
+        n.max = Vector3(std::max(c1.max.x, c2.max.x), std::max(c1.max.y, c2.max.y), std::max(c1.max.z, c2.max.z));
+        n.height = 1 + std::max(c1.height, c2.height);
+    };
+
+    if (balanceFactor > 1 || balanceFactor < -1){
+        // rotate the taller child up
+        bool rotateC = balanceFactor > 1;
+        int32_t iUp = rotateC ? iC : iB;
+        Node* Up = &nodes[iUp];
+
+        int32_t iF = Up->child1;
+        int32_t iG = Up->child2;
+
+        Up->child1 = iA;
+        Up->parent = A->parent;
+        A->parent = iUp;
+
+        if (Up->parent != NULL_NODE){
+            if (nodes[Up->parent].child1 == iA){
+                nodes[Up->parent].child1 = iUp;
+            }else{
+                nodes[Up->parent].child2 = iUp;
+            }
+        }else{
+            root = iUp;
+        }
+
+        int32_t iKeep = iF;
+        int32_t iMove = iG;
+        if (nodes[iF].height < nodes[iG].height){
+            iKeep = iG;
+            iMove = iF;
+        }
+
+        Up->child2 = iKeep;
+        if (rotateC){
+            A->child2 = iMove;
+        }else{
+            A->child1 = iMove;
+        }
+        nodes[iMove].parent = iA;
+
+        refit(iA);
+        refit(iUp);
+
+        return iUp;
+    }
+
+    return iA;
+}
+
+void AABBTree::collectLeaves(int32_t nodeId, std::vector<int32_t>& stack, std::vector<int32_t>& proxies) const{
+    size_t base = stack.size();
+    stack.push_back(nodeId);
+    while (stack.size() > base){
+        int32_t id = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[id];
+        if (node.isLeaf()){
+            proxies.push_back(id);
+        }else{
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void AABBTree::queryAABB(const AABB& box, std::vector<Entity>& result) const{
+    if (root == NULL_NODE || box.isNull()){
+        return;
+    }
+
+    const Vector3& min = box.getMinimum();
+    const Vector3& max = box.getMaximum();
+    bool infinite = box.isInfinite();
+
+    std::vector<int32_t> stack;
+    stack.push_back(root);
+    while (!stack.empty()){
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (!infinite && (node.max.x < min.x || node.min.x > max.x || node.max.y < min.y || node.min.y > max.y || node.max.z < min.z || node.min.z > max.z)){
+            continue;
+        }
+
+        if (node.isLeaf()){
+            result.push_back(node.entity);
+        }else{
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void AABBTree::querySphere(const Sphere& sphere, std::vector<Entity>& result) const{
+    if (root == NULL_NODE){
+        return;
+    }
+
+    float radiusSq = sphere.radius * sphere.radius;
+
+    std::vector<int32_t> stack;
+    stack.push_back(root);
+    while (!stack.empty()){
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        // squared distance from sphere center to box
+        float distSq = 0;
+        for (int a = 0; a < 3; a++){
+            float c = sphere.center[a];
+            if (c < node.min[a]){
+                distSq += (node.min[a] - c) * (node.min[a] - c);
+            }else if (c > node.max[a]){
+                distSq += (c - node.max[a]) * (c - node.max[a]);
+            }
+        }
+
+        if (distSq > radiusSq){
+            continue;
+        }
+
+        if (node.isLeaf()){
+            result.push_back(node.entity);
+        }else{
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void AABBTree::queryFrustum(const Plane* planes, int numPlanes, std::vector<int32_t>& proxies) const{
+    if (root == NULL_NODE){
+        return;
+    }
+
+    std::vector<int32_t> stack;
+    stack.push_back(root);
+    while (!stack.empty()){
+        int32_t id = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[id];
+
+        Vector3 center = (node.min + node.max) * 0.5f;
+        Vector3 halfSize = (node.max - node.min) * 0.5f;
+
+        bool outside = false;
+        bool inside = true;
+        for (int p = 0; p < numPlanes; p++){
+            float dist = planes[p].getDistance(center);
+            float maxAbsDist = planes[p].normal.absDotProduct(halfSize);
+
+            if (dist < -maxAbsDist){
+                outside = true;
+                break;
+            }
+            if (dist < maxAbsDist){
+                inside = false;
+            }
+        }
+
+        if (outside){
+            continue;
+        }
+
+        if (inside || node.isLeaf()){
+            // whole subtree is inside, no more plane tests
+            collectLeaves(id, stack, proxies);
+        }else{
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void AABBTree::queryFrustum(const Plane* planes, int numPlanes, std::vector<Entity>& result) const{
+    std::vector<int32_t> proxies;
+    queryFrustum(planes, numPlanes, proxies);
+
+    for (int32_t proxy : proxies){
+        result.push_back(nodes[proxy].entity);
+    }
+}
+
+void AABBTree::queryRay(const Vector3& origin, const Vector3& direction, std::vector<Entity>& result) const{
+    if (root == NULL_NODE){
+        return;
+    }
+
+    Vector3 invDir;
+    for (int a = 0; a < 3; a++){
+        invDir[a] = (direction[a] != 0) ? 1.0f / direction[a] : INFINITY;
+    }
+
+    std::vector<int32_t> stack;
+    stack.push_back(root);
+    while (!stack.empty()){
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        // slab test on segment [0, 1]
+        float tmin = 0.0f;
+        float tmax = 1.0f;
+        bool miss = false;
+        for (int a = 0; a < 3; a++){
+            if (direction[a] == 0){
+                if (origin[a] < node.min[a] || origin[a] > node.max[a]){
+                    miss = true;
+                    break;
+                }
+            }else{
+                float t1 = (node.min[a] - origin[a]) * invDir[a];
+                float t2 = (node.max[a] - origin[a]) * invDir[a];
+                tmin = std::max(tmin, std::min(t1, t2));
+                tmax = std::min(tmax, std::max(t1, t2));
+                if (tmin > tmax){
+                    miss = true;
+                    break;
+                }
+            }
+        }
+
+        if (miss){
+            continue;
+        }
+
+        if (node.isLeaf()){
+            result.push_back(node.entity);
+        }else{
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef AABBTree_h
+#define AABBTree_h
+
+#include "Vector3.h"
+#include "AABB.h"
+#include "Plane.h"
+#include "Sphere.h"
+#include "Entity.h"
+#include <vector>
+#include <stdint.h>
+
+namespace Supernova{
+
+    // Dynamic bounding volume hierarchy, leaves keep enlarged boxes so small moves do not touch the tree
+    class AABBTree{
+
+    public:
+
+        static const int32_t NULL_NODE = -1;
+
+    private:
+
+        struct Node{
+            Vector3 min;
+            Vector3 max;
+            int32_t parent; // next free node when not used
+            int32_t child1;
+            int32_t child2;
+            int32_t height; // leaf is 0, free node is -1
+            Entity entity;
+            uint32_t data;
+
+            bool isLeaf() const{
+                return child1 == NULL_NODE;
+            }
+        };
+
+        std::vector<Node> nodes;
+        int32_t root;
+        int32_t freeList;
+        size_t leafCount;
+
+        float margin;
+
+        int32_t allocateNode();
+        void freeNode(int32_t nodeId);
+
+        void insertLeaf(int32_t leaf);
+        void removeLeaf(int32_t leaf);
+        int32_t balance(int32_t iA);
+        void fixUpwards(int32_t index);
+
+        void collectLeaves(int32_t nodeId, std::vector<int32_t>& stack, std::vector<int32_t>& proxies) const;
+
+        static float surfaceArea(const Vector3& min, const Vector3& max);
+
+    public:
+
+        AABBTree();
+        AABBTree(float margin);
+
+        void clear();
+
+        // margin is a fraction of the box size added to each side
+        void setMargin(float margin);
+        float getMargin() const;
+
+        int32_t createProxy(const AABB& box, Entity entity, uint32_t data = 0);
+        void destroyProxy(int32_t proxy);
+        // returns true if the leaf was reinserted
+        bool moveProxy(int32_t proxy, const AABB& box);
+
+        Entity getEntity(int32_t proxy) const;
+        uint32_t getData(int32_t proxy) const;
+        void setData(int32_t proxy, uint32_t data);
+        AABB getFatAABB(int32_t proxy) const;
+
+        size_t size() const;
+        int32_t getHeight() const;
+
+        // results are enlarged box candidates, test exact bounds when needed
+        void queryAABB(const AABB& box, std::vector<Entity>& result) const;
+        void querySphere(const Sphere& sphere, std::vector<Entity>& result) const;
+        void queryFrustum(const Plane* planes, int numPlanes, std::vector<Entity>& result) const;
+        void queryFrustum(const Plane* planes, int numPlanes, std::vector<int32_t>& proxies) const;
+        // segment from origin to origin + direction, same as Ray
+        void queryRay(const Vector3& origin, const Vector3& direction, std::vector<Entity>& result) const;
+    };
+
+}
+
+#endif /* AABBTree_h */
@@ -0,0 +1,151 @@
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUMCULLER_SSE
+#endif
+
+using namespace Supernova;
+
+FrustumCuller::FrustumCuller(){
+    count = 0;
+}
+
+void FrustumCuller::clear(){
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    halfX.clear();
+    halfY.clear();
+    halfZ.clear();
+    alwaysVisible.clear();
+    neverVisible.clear();
+
+    count = 0;
+}
+
+void FrustumCuller::reserve(size_t size){
+    size = (size + 3) & ~(size_t)3;
+
+    centerX.reserve(size);
+    centerY.reserve(size);
+    centerZ.reserve(size);
+    halfX.reserve(size);
+    halfY.reserve(size);
+    halfZ.reserve(size);
+    alwaysVisible.reserve((size + 63) / 64);
+    neverVisible.reserve((size + 63) / 64);
+}
+
+size_t FrustumCuller::add(const AABB& box){
+    size_t index = count++;
+
+    // arrays always padded to blocks of 4 boxes
+    if ((index & 3) == 0){
+        centerX.resize(index + 4, 0);
+        centerY.resize(index + 4, 0);
+        centerZ.resize(index + 4, 0);
+        halfX.resize(index + 4, 0);
+        halfY.resize(index + 4, 0);
+        halfZ.resize(index + 4, 0);
+    }
+    if ((index & 63) == 0){
+        alwaysVisible.push_back(0);
+        neverVisible.push_back(0);
+    }
+
+    if (box == AABB::ZERO){
+        alwaysVisible[index / 64] |= ((uint64_t)1 << (index % 64));
+    }else if (box.isNull() || box.isInfinite()){
+        neverVisible[index / 64] |= ((uint64_t)1 << (index % 64));
+    }else{
+        Vector3 center = box.getCenter();
+        Vector3 halfSize = box.getHalfSize();
+
+        centerX[index] = center.x;
+        centerY[index] = center.y;
+        centerZ[index] = center.z;
+        halfX[index] = halfSize.x;
+        halfY[index] = halfSize.y;
+        halfZ[index] = halfSize.z;
+    }
+
+    return index;
+}
+
+size_t FrustumCuller::size() const{
+    return count;
+}
+
+size_t FrustumCuller::cull(const Plane* planes, int numPlanes, std::vector<uint64_t>& visible) const{
+    visible.assign((count + 63) / 64, 0);
+
+    for (size_t i = 0; i < count; i += 4){
+        unsigned int mask = 0xF;
+
+#ifdef FRUSTUMCULLER_SSE
+        __m128 cx = _mm_loadu_ps(&centerX[i]);
+        __m128 cy = _mm_loadu_ps(&centerY[i]);
+        __m128 cz = _mm_loadu_ps(&centerZ[i]);
+        __m128 hx = _mm_loadu_ps(&halfX[i]);
+        __m128 hy = _mm_loadu_ps(&halfY[i]);
+        __m128 hz = _mm_loadu_ps(&halfZ[i]);
+
+        __m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+        for (int p = 0; p < numPlanes; p++){
+            const Plane& plane = planes[p];
+
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.x), cx), _mm_mul_ps(_mm_set1_ps(plane.normal.y), cy)),
+                                     _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.z), cz), _mm_set1_ps(plane.d)));
+            __m128 maxAbsDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.normal.x)), hx), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.normal.y)), hy)),
+                                           _mm_mul_ps(_mm_set1_ps(std::fabs(plane.normal.z)), hz));
+
+            // same as Plane::getSide, outside when dist < -maxAbsDist
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, maxAbsDist), _mm_setzero_ps()));
+        }
+        mask = _mm_movemask_ps(inside);
+#else
+        for (int p = 0; p < numPlanes; p++){
+            const Plane& plane = planes[p];
+            float ax = std::fabs(plane.normal.x);
+            float ay = std::fabs(plane.normal.y);
+            float az = std::fabs(plane.normal.z);
+
+            for (int l = 0; l < 4; l++){
+                float dist = plane.normal.x * centerX[i+l] + plane.normal.y * centerY[i+l] + plane.normal.z * centerZ[i+l] + plane.d;
+                float maxAbsDist = ax * halfX[i+l] + ay * halfY[i+l] + az * halfZ[i+l];
+
+                if (dist + maxAbsDist < 0){
+                    mask &= ~(1u << l);
+                }
+            }
+        }
+#endif
+
+        visible[i / 64] |= (uint64_t)mask << (i % 64);
+    }
+
+    size_t numVisible = 0;
+    for (size_t w = 0; w < visible.size(); w++){
+        visible[w] = (visible[w] | alwaysVisible[w]) & ~neverVisible[w];
+
+        // padding boxes past count are not visible
+        if (w == visible.size() - 1 && (count % 64) != 0){
+            visible[w] &= ((uint64_t)1 << (count % 64)) - 1;
+        }
+
+        uint64_t bits = visible[w];
+        while (bits){
+            bits &= bits - 1;
+            numVisible++;
+        }
+    }
+
+    return numVisible;
+}
+
+bool FrustumCuller::isVisible(const std::vector<uint64_t>& visible, size_t index){
+    return (visible[index / 64] >> (index % 64)) & 1;
+}
@@ -0,0 +1,48 @@
+#ifndef FrustumCuller_h
+#define FrustumCuller_h
+
+#include "AABB.h"
+#include "Plane.h"
+#include <vector>
+#include <stdint.h>
+
+namespace Supernova{
+
+    // Boxes stored as SoA centers and half sizes, tested 4 at a time against frustum planes
+    class FrustumCuller{
+
+    private:
+
+        std::vector<float> centerX;
+        std::vector<float> centerY;
+        std::vector<float> centerZ;
+        std::vector<float> halfX;
+        std::vector<float> halfY;
+        std::vector<float> halfZ;
+
+        // boxes that skip the plane test
+        std::vector<uint64_t> alwaysVisible;
+        std::vector<uint64_t> neverVisible;
+
+        size_t count;
+
+    public:
+
+        FrustumCuller();
+
+        void clear();
+        void reserve(size_t size);
+
+        // AABB::ZERO is always visible, null and infinite boxes are never visible
+        size_t add(const AABB& box);
+        size_t size() const;
+
+        // writes one bit per box, returns number of visible boxes
+        size_t cull(const Plane* planes, int numPlanes, std::vector<uint64_t>& visible) const;
+
+        static bool isVisible(const std::vector<uint64_t>& visible, size_t index);
+    };
+
+}
+
+#endif /* FrustumCuller_h */
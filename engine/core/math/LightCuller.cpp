@@ -0,0 +1,192 @@
+#include "LightCuller.h"
+
+#include "Vector4.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+using namespace Supernova;
+
+LightCuller::LightCuller(){
+    stamp = 0;
+    minDepth = 0;
+    maxDepth = 0;
+    built = false;
+}
+
+void LightCuller::clear(){
+    centers.clear();
+    radius.clear();
+    globals.clear();
+    clusterOffsets.clear();
+    clusterIndices.clear();
+
+    built = false;
+}
+
+void LightCuller::reserve(size_t size){
+    centers.reserve(size);
+    radius.reserve(size);
+}
+
+size_t LightCuller::add(const Vector3& center, float radius){
+    size_t index = centers.size();
+
+    centers.push_back(center);
+    this->radius.push_back(radius);
+
+    if (radius <= 0){
+        globals.push_back((uint32_t)index);
+    }
+
+    built = false;
+
+    return index;
+}
+
+size_t LightCuller::size() const{
+    return centers.size();
+}
+
+LightCuller::Range LightCuller::getRange(const Vector3& min, const Vector3& max) const{
+    Range range = {0, CLUSTERS_X - 1, 0, CLUSTERS_Y - 1, 0, CLUSTERS_Z - 1};
+
+    float ndcMinX = FLT_MAX, ndcMaxX = -FLT_MAX;
+    float ndcMinY = FLT_MAX, ndcMaxY = -FLT_MAX;
+    float depthMin = FLT_MAX, depthMax = -FLT_MAX;
+    bool behind = false;
+
+    for (int i = 0; i < 8; i++){
+        Vector4 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0);
+
+        // camera looks to -Z
+        float depth = -(viewMatrix * corner).z;
+        depthMin = std::min(depthMin, depth);
+        depthMax = std::max(depthMax, depth);
+
+        Vector4 clip = viewProjectionMatrix * corner;
+        if (clip.w <= 1e-5){
+            behind = true;
+        }else{
+            float x = clip.x / clip.w;
+            float y = clip.y / clip.w;
+            ndcMinX = std::min(ndcMinX, x);
+            ndcMaxX = std::max(ndcMaxX, x);
+            ndcMinY = std::min(ndcMinY, y);
+            ndcMaxY = std::max(ndcMaxY, y);
+        }
+    }
+
+    // projection and clamp keep order, so boxes that overlap always share a cluster
+    if (!behind){
+        range.minX = std::clamp((int)std::floor((ndcMinX * 0.5f + 0.5f) * CLUSTERS_X), 0, CLUSTERS_X - 1);
+        range.maxX = std::clamp((int)std::floor((ndcMaxX * 0.5f + 0.5f) * CLUSTERS_X), 0, CLUSTERS_X - 1);
+        range.minY = std::clamp((int)std::floor((ndcMinY * 0.5f + 0.5f) * CLUSTERS_Y), 0, CLUSTERS_Y - 1);
+        range.maxY = std::clamp((int)std::floor((ndcMaxY * 0.5f + 0.5f) * CLUSTERS_Y), 0, CLUSTERS_Y - 1);
+    }
+
+    // slices cover depth of lights, works for perspective and orthographic cameras
+    float depthScale = (maxDepth > minDepth) ? (CLUSTERS_Z / (maxDepth - minDepth)) : 0;
+    range.minZ = std::clamp((int)std::floor((depthMin - minDepth) * depthScale), 0, CLUSTERS_Z - 1);
+    range.maxZ = std::clamp((int)std::floor((depthMax - minDepth) * depthScale), 0, CLUSTERS_Z - 1);
+
+    return range;
+}
+
+void LightCuller::build(const Matrix4& viewMatrix, const Matrix4& viewProjectionMatrix){
+    this->viewMatrix = viewMatrix;
+    this->viewProjectionMatrix = viewProjectionMatrix;
+
+    const size_t numClusters = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+    clusterOffsets.assign(numClusters + 1, 0);
+    clusterIndices.clear();
+
+    minDepth = FLT_MAX;
+    maxDepth = -FLT_MAX;
+    for (size_t i = 0; i < centers.size(); i++){
+        if (radius[i] > 0){
+            float depth = -(viewMatrix * Vector4(centers[i].x, centers[i].y, centers[i].z, 1.0)).z;
+            minDepth = std::min(minDepth, depth - radius[i]);
+            maxDepth = std::max(maxDepth, depth + radius[i]);
+        }
+    }
+
+    std::vector<Range> ranges(centers.size());
+
+    // count lights of each cluster
+    for (size_t i = 0; i < centers.size(); i++){
+        if (radius[i] > 0){
+            Vector3 extent(radius[i], radius[i], radius[i]);
+            ranges[i] = getRange(centers[i] - extent, centers[i] + extent);
+
+            for (int z = ranges[i].minZ; z <= ranges[i].maxZ; z++){
+                for (int y = ranges[i].minY; y <= ranges[i].maxY; y++){
+                    for (int x = ranges[i].minX; x <= ranges[i].maxX; x++){
+                        clusterOffsets[(z * CLUSTERS_Y + y) * CLUSTERS_X + x + 1]++;
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t c = 0; c < numClusters; c++){
+        clusterOffsets[c + 1] += clusterOffsets[c];
+    }
+
+    clusterIndices.resize(clusterOffsets[numClusters]);
+
+    // fill using a moving offset for each cluster
+    std::vector<uint32_t> fill(clusterOffsets.begin(), clusterOffsets.end() - 1);
+    for (size_t i = 0; i < centers.size(); i++){
+        if (radius[i] > 0){
+            for (int z = ranges[i].minZ; z <= ranges[i].maxZ; z++){
+                for (int y = ranges[i].minY; y <= ranges[i].maxY; y++){
+                    for (int x = ranges[i].minX; x <= ranges[i].maxX; x++){
+                        clusterIndices[fill[(z * CLUSTERS_Y + y) * CLUSTERS_X + x]++] = (uint32_t)i;
+                    }
+                }
+            }
+        }
+    }
+
+    stamps.assign(centers.size(), 0);
+    stamp = 0;
+
+    built = true;
+}
+
+void LightCuller::query(const AABB& box, std::vector<uint32_t>& result){
+    result.clear();
+
+    if (!built || box.isNull() || box.isInfinite() || box == AABB::ZERO){
+        for (size_t i = 0; i < centers.size(); i++){
+            result.push_back((uint32_t)i);
+        }
+        return;
+    }
+
+    result.insert(result.end(), globals.begin(), globals.end());
+
+    if (++stamp == 0){
+        std::fill(stamps.begin(), stamps.end(), 0);
+        stamp = 1;
+    }
+
+    Range range = getRange(box.getMinimum(), box.getMaximum());
+
+    for (int z = range.minZ; z <= range.maxZ; z++){
+        for (int y = range.minY; y <= range.maxY; y++){
+            for (int x = range.minX; x <= range.maxX; x++){
+                size_t cluster = (z * CLUSTERS_Y + y) * CLUSTERS_X + x;
+                for (uint32_t i = clusterOffsets[cluster]; i < clusterOffsets[cluster + 1]; i++){
+                    uint32_t light = clusterIndices[i];
+                    if (stamps[light] != stamp){
+                        stamps[light] = stamp;
+                        result.push_back(light);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef LightCuller_h
+#define LightCuller_h
+
+#include "Vector3.h"
+#include "Matrix4.h"
+#include "AABB.h"
+#include <vector>
+#include <stdint.h>
+
+namespace Supernova{
+
+    // Light spheres assigned to a grid of view space clusters, so an object only tests lights from clusters it touches
+    class LightCuller{
+
+    public:
+
+        static const int CLUSTERS_X = 16;
+        static const int CLUSTERS_Y = 8;
+        static const int CLUSTERS_Z = 16;
+
+    private:
+
+        struct Range{
+            int minX, maxX;
+            int minY, maxY;
+            int minZ, maxZ;
+        };
+
+        std::vector<Vector3> centers;
+        std::vector<float> radius;
+
+        // lights without range affect every cluster
+        std::vector<uint32_t> globals;
+
+        // lights of cluster i are clusterIndices[clusterOffsets[i]] to clusterIndices[clusterOffsets[i+1]]
+        std::vector<uint32_t> clusterOffsets;
+        std::vector<uint32_t> clusterIndices;
+
+        std::vector<uint32_t> stamps;
+        uint32_t stamp;
+
+        Matrix4 viewMatrix;
+        Matrix4 viewProjectionMatrix;
+        float minDepth;
+        float maxDepth;
+        bool built;
+
+        Range getRange(const Vector3& min, const Vector3& max) const;
+
+    public:
+
+        LightCuller();
+
+        void clear();
+        void reserve(size_t size);
+
+        // radius less or equal to zero is unlimited
+        size_t add(const Vector3& center, float radius);
+        size_t size() const;
+
+        // matrices of any camera, the grid only changes how tight the results are
+        void build(const Matrix4& viewMatrix, const Matrix4& viewProjectionMatrix);
+
+        // results are candidates, test exact bounds when needed
+        void query(const AABB& box, std::vector<uint32_t>& result);
+    };
+
+}
+
+#endif /* LightCuller_h */
@@ -6,6 +6,7 @@
 
 #include "util/Box2DAux.h"
 #include "util/JoltPhysicsAux.h"
+#include "subsystem/RenderSystem.h"
 #include <stdlib.h>
 
 using namespace Supernova;
@@ -377,6 +378,25 @@ RayReturn Ray::intersects(Scene* scene, RayFilter raytest, bool onlyStatic, uint
             return {true, closestFraction, point, normal, entity, shapeIndex};
         }
 
+    }else if (raytest == RayFilter::MESH){
+
+        std::vector<Entity> candidates;
+        scene->getSystem<RenderSystem>()->findMeshes(origin, direction, candidates);
+
+        RayReturn closest = NO_HIT;
+        for (Entity entity : candidates){
+            MeshComponent* mesh = scene->findComponent<MeshComponent>(entity);
+            if (mesh){
+                RayReturn ret = intersects(mesh->worldAABB);
+                if (ret && (!closest || ret.distance < closest.distance)){
+                    closest = ret;
+                    closest.body = entity;
+                }
+            }
+        }
+
+        return closest;
+
     }else if (raytest == RayFilter::BODY_3D){
 
         JPH::PhysicsSystem* world = scene->getSystem<PhysicsSystem>()->getWorld3D();
@@ -12,7 +12,8 @@ namespace Supernova {
 
     enum class RayFilter{
         BODY_2D,
-        BODY_3D
+        BODY_3D,
+        MESH // world bounds of meshes, body is the mesh entity
     };
 
     struct RayReturn{
@@ -158,4 +158,64 @@ void Model::setMorphWeight(int id, float value){
     }else{
         Log::error("Retrieving non-existent morph weight '%i'", id);
     }
+}
+
+void Model::setAnimationLodDistance(float animationLodDistance){
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    model.animationLodDistance = animationLodDistance;
+}
+
+float Model::getAnimationLodDistance() const{
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    return model.animationLodDistance;
+}
+
+void Model::setAnimationLodMaxInterval(int animationLodMaxInterval){
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    model.animationLodMaxInterval = animationLodMaxInterval;
+}
+
+int Model::getAnimationLodMaxInterval() const{
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    return model.animationLodMaxInterval;
+}
+
+void Model::setReducedBonesDistance(float reducedBonesDistance){
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    model.reducedBonesDistance = reducedBonesDistance;
+}
+
+float Model::getReducedBonesDistance() const{
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    return model.reducedBonesDistance;
+}
+
+void Model::setReducedBonesDepth(int reducedBonesDepth){
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    model.reducedBonesDepth = reducedBonesDepth;
+}
+
+int Model::getReducedBonesDepth() const{
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    return model.reducedBonesDepth;
+}
+
+void Model::setPauseAnimationOffscreen(bool pauseAnimationOffscreen){
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    model.pauseAnimationOffscreen = pauseAnimationOffscreen;
+}
+
+bool Model::isPauseAnimationOffscreen() const{
+    ModelComponent& model = getComponent<ModelComponent>();
+
+    return model.pauseAnimationOffscreen;
 }
\ No newline at end of file
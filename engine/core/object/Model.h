@@ -32,6 +32,22 @@ namespace Supernova{
         float getMorphWeight(int id);
         void setMorphWeight(std::string name, float value);
         void setMorphWeight(int id, float value);
+
+        // animation level of detail, zero distances disable it
+        void setAnimationLodDistance(float animationLodDistance);
+        float getAnimationLodDistance() const;
+
+        void setAnimationLodMaxInterval(int animationLodMaxInterval);
+        int getAnimationLodMaxInterval() const;
+
+        void setReducedBonesDistance(float reducedBonesDistance);
+        float getReducedBonesDistance() const;
+
+        void setReducedBonesDepth(int reducedBonesDepth);
+        int getReducedBonesDepth() const;
+
+        void setPauseAnimationOffscreen(bool pauseAnimationOffscreen);
+        bool isPauseAnimationOffscreen() const;
     };
 }
 
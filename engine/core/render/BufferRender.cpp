@@ -27,10 +27,14 @@ bool BufferRender::createBuffer(unsigned int size, void* data, BufferType type,
         return false;
 }
 
-void BufferRender::updateBuffer(unsigned int size, void* data){
-    backend.updateBuffer(size, data);
+bool BufferRender::updateBuffer(unsigned int size, void* data){
+    return backend.updateBuffer(size, data);
 }
 
 void BufferRender::destroyBuffer(){
     backend.destroyBuffer();
+}
+
+bool BufferRender::isUploaded() const{
+    return backend.isUploaded();
 }
\ No newline at end of file
@@ -22,8 +22,10 @@ namespace Supernova{
         virtual ~BufferRender();
 
         bool createBuffer(unsigned int size, void* data, BufferType type, BufferUsage usage);
-        void updateBuffer(unsigned int size, void* data);
+        bool updateBuffer(unsigned int size, void* data);
         void destroyBuffer();
+
+        bool isUploaded() const;
     };
 }
 
@@ -55,11 +55,35 @@ void ObjectRender::applyUniformBlock(int slot, ShaderStageType stage, unsigned i
     backend.applyUniformBlock(slot, stage, count, data);
 }
 
+void ObjectRender::applyUniformBlock(int slot, ShaderStageType stage, unsigned int count, void* data, uint64_t hash){
+    backend.applyUniformBlock(slot, stage, count, data, hash);
+}
+
 void ObjectRender::draw(unsigned int vertexCount, unsigned int instanceCount){
     backend.draw(vertexCount, instanceCount);
 }
 
+void ObjectRender::draw(unsigned int baseElement, unsigned int vertexCount, unsigned int instanceCount){
+    backend.draw(baseElement, vertexCount, instanceCount);
+}
+
+uint32_t ObjectRender::getPipelineId(PipelineType pipType) const{
+    return backend.getPipelineId(pipType);
+}
+
+uint32_t ObjectRender::getTextureId() const{
+    return backend.getTextureId();
+}
+
+uint64_t ObjectRender::getTexturesHash() const{
+    return backend.getTexturesHash();
+}
+
 void ObjectRender::destroy(){
     backend.destroy();
 
+}
+
+uint64_t ObjectRender::getUniformHash(const void* data, size_t count){
+    return SokolObject::getUniformHash(data, count);
 }
\ No newline at end of file
@@ -35,9 +35,19 @@ namespace Supernova {
 
         bool beginDraw(PipelineType pipType);
         void applyUniformBlock(int slot, ShaderStageType stage, unsigned int count, void* data);
+        // hash computed by caller, useful for blocks shared by many objects
+        void applyUniformBlock(int slot, ShaderStageType stage, unsigned int count, void* data, uint64_t hash);
         void draw(unsigned int vertexCount, unsigned int instanceCount);
+        // draws a range of a shared buffer
+        void draw(unsigned int baseElement, unsigned int vertexCount, unsigned int instanceCount);
+
+        uint32_t getPipelineId(PipelineType pipType) const;
+        uint32_t getTextureId() const;
+        uint64_t getTexturesHash() const;
 
         void destroy();
+
+        static uint64_t getUniformHash(const void* data, size_t count);
     };
 }
 
@@ -17,8 +17,12 @@ void SystemRender::commitQueue(){
     SokolSystem::commitQueue();
 }
 
-void SystemRender::executeQueue(){
-    SokolSystem::executeQueue();
+void SystemRender::executeQueue(bool waitCommit){
+    SokolSystem::executeQueue(waitCommit);
+}
+
+void SystemRender::executeQueueResources(){
+    SokolSystem::executeQueueResources();
 }
 
 void SystemRender::commit(){
@@ -38,9 +42,30 @@ void SystemRender::scheduleCleanup(void (*cleanupFunc)(void* cleanupData), void*
 }
 
 void SystemRender::addQueueCommand(void (*custom_cb)(void* custom_data), void* custom_data){
-    if (Engine::isAsyncThread()){
+    // recorded frames already have resource commands before the draws using them
+    if (Engine::isAsyncThread() && !Engine::isRecordingThread()){
         SokolSystem::addQueueCommand(custom_cb, custom_data);
     }else{
         custom_cb(custom_data);
     }
+}
+
+uint32_t SystemRender::getDrawCalls(){
+    return SokolSystem::getDrawCalls();
+}
+
+uint32_t SystemRender::getStateChanges(){
+    return SokolSystem::getStateChanges();
+}
+
+uint32_t SystemRender::getSkippedStateChanges(){
+    return SokolSystem::getSkippedStateChanges();
+}
+
+uint32_t SystemRender::getUniformBytes(){
+    return SokolSystem::getUniformBytes();
+}
+
+uint32_t SystemRender::getBufferUploadBytes(){
+    return SokolSystem::getBufferUploadBytes();
 }
\ No newline at end of file
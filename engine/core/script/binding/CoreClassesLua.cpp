@@ -169,6 +169,10 @@ void LuaBinding::registerCoreClasses(lua_State *L){
         .addStaticFunction("setCallTouchInMouseEvent", &Engine::setCallTouchInMouseEvent)
         .addStaticProperty("useDegrees", &Engine::isUseDegrees, &Engine::setUseDegrees)
         .addStaticProperty("automaticTransparency", &Engine::isAutomaticTransparency, &Engine::setAutomaticTransparency)
+        .addStaticProperty("automaticInstancing", &Engine::isAutomaticInstancing, &Engine::setAutomaticInstancing)
+        .addStaticProperty("automaticBatching", &Engine::isAutomaticBatching, &Engine::setAutomaticBatching)
+        .addStaticProperty("multithreadedRender", &Engine::isMultithreadedRender, &Engine::setMultithreadedRender)
+        .addStaticProperty("maxShadowUpdates", &Engine::getMaxShadowUpdates, &Engine::setMaxShadowUpdates)
         .addStaticProperty("allowEventsOutCanvas", &Engine::isAllowEventsOutCanvas, &Engine::setAllowEventsOutCanvas)
         .addStaticProperty("ignoreEventsHandledByUI", &Engine::isIgnoreEventsHandledByUI, &Engine::setIgnoreEventsHandledByUI)
         .addStaticFunction("isUIEventReceived", &Engine::isUIEventReceived)
@@ -186,6 +190,7 @@ void LuaBinding::registerCoreClasses(lua_State *L){
         .addStaticFunction("commitThreadQueue", &Engine::commitThreadQueue)
         .addStaticFunction("endAsyncThread", &Engine::endAsyncThread)
         .addStaticFunction("isAsyncThread", &Engine::isAsyncThread)
+        .addStaticFunction("isRecordingThread", &Engine::isRecordingThread)
         .addStaticFunction("isViewLoaded", &Engine::isViewLoaded)
         .addStaticProperty("framebuffer", &Engine::getFramebuffer, &Engine::setFramebuffer)
 
@@ -427,6 +432,7 @@ void LuaBinding::registerCoreClasses(lua_State *L){
         .addProperty("sceneAmbientLightEnabled", &Scene::isSceneAmbientLightEnabled, &Scene::setSceneAmbientLightEnabled)
         .addFunction("canReceiveUIEvents", &Scene::canReceiveUIEvents)
         .addProperty("enableUIEvents", &Scene::isEnableUIEvents, &Scene::setEnableUIEvents)
+        .addProperty("deferredHierarchySort", &Scene::isDeferredHierarchySort, &Scene::setDeferredHierarchySort)
         .addFunction("findBranchLastIndex", &Scene::findBranchLastIndex)
         .addFunction("createEntity", &Scene::createEntity)
         .addFunction("destroyEntity", &Scene::destroyEntity)
@@ -252,6 +252,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addFunction("getSignature", &EntityManager::getSignature)
         .addFunction("setName", &EntityManager::setName)
         .addFunction("getName", &EntityManager::getName)
+        .addFunction("isValid", &EntityManager::isValid)
         .endClass();
 
     luabridge::getGlobalNamespace(L)
@@ -412,6 +413,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("toTime", &ParticlePositionModifier::toTime)
         .addProperty("fromPosition", &ParticlePositionModifier::fromPosition)
         .addProperty("toPosition", &ParticlePositionModifier::toPosition)
+        .addProperty("functionType", &ParticlePositionModifier::functionType)
         .addProperty("function", [] (ParticlePositionModifier* self, lua_State* L) { return &self->function; }, [] (ParticlePositionModifier* self, lua_State* L) { self->function = L; })
         .endClass();
 
@@ -427,6 +429,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("toTime", &ParticleVelocityModifier::toTime)
         .addProperty("fromVelocity", &ParticleVelocityModifier::fromVelocity)
         .addProperty("toVelocity", &ParticleVelocityModifier::toVelocity)
+        .addProperty("functionType", &ParticleVelocityModifier::functionType)
         .addProperty("function", [] (ParticleVelocityModifier* self, lua_State* L) { return &self->function; }, [] (ParticleVelocityModifier* self, lua_State* L) { self->function = L; })
         .endClass();
 
@@ -442,6 +445,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("toTime", &ParticleAccelerationModifier::toTime)
         .addProperty("fromAcceleration", &ParticleAccelerationModifier::fromAcceleration)
         .addProperty("toAcceleration", &ParticleAccelerationModifier::toAcceleration)
+        .addProperty("functionType", &ParticleAccelerationModifier::functionType)
         .addProperty("function", [] (ParticleAccelerationModifier* self, lua_State* L) { return &self->function; }, [] (ParticleAccelerationModifier* self, lua_State* L) { self->function = L; })
         .endClass();
 
@@ -458,6 +462,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("toTime", &ParticleColorModifier::toTime)
         .addProperty("fromColor", &ParticleColorModifier::fromColor)
         .addProperty("toColor", &ParticleColorModifier::toColor)
+        .addProperty("functionType", &ParticleColorModifier::functionType)
         .addProperty("function", [] (ParticleColorModifier* self, lua_State* L) { return &self->function; }, [] (ParticleColorModifier* self, lua_State* L) { self->function = L; })
         .addProperty("useSRGB", &ParticleColorModifier::useSRGB)
         .endClass();
@@ -474,6 +479,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("toTime", &ParticleAlphaModifier::toTime)
         .addProperty("fromAlpha", &ParticleAlphaModifier::fromAlpha)
         .addProperty("toAlpha", &ParticleAlphaModifier::toAlpha)
+        .addProperty("functionType", &ParticleAlphaModifier::functionType)
         .addProperty("function", [] (ParticleAlphaModifier* self, lua_State* L) { return &self->function; }, [] (ParticleAlphaModifier* self, lua_State* L) { self->function = L; })
         .endClass();
 
@@ -489,6 +495,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("toTime", &ParticleSizeModifier::toTime)
         .addProperty("fromSize", &ParticleSizeModifier::fromSize)
         .addProperty("toSize", &ParticleSizeModifier::toSize)
+        .addProperty("functionType", &ParticleSizeModifier::functionType)
         .addProperty("function", [] (ParticleSizeModifier* self, lua_State* L) { return &self->function; }, [] (ParticleSizeModifier* self, lua_State* L) { self->function = L; })
         .endClass();
 
@@ -502,6 +509,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("fromTime", &ParticleSpriteModifier::fromTime)
         .addProperty("toTime", &ParticleSpriteModifier::toTime)
         .addProperty("frames", &ParticleSpriteModifier::frames)
+        .addProperty("functionType", &ParticleSpriteModifier::functionType)
         .addProperty("function", [] (ParticleSpriteModifier* self, lua_State* L) { return &self->function; }, [] (ParticleSpriteModifier* self, lua_State* L) { self->function = L; })
         .endClass();
 
@@ -518,6 +526,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("toTime", &ParticleRotationModifier::toTime)
         .addProperty("fromRotation", &ParticleRotationModifier::fromRotation)
         .addProperty("toRotation", &ParticleRotationModifier::toRotation)
+        .addProperty("functionType", &ParticleRotationModifier::functionType)
         .addProperty("function", [] (ParticleRotationModifier* self, lua_State* L) { return &self->function; }, [] (ParticleRotationModifier* self, lua_State* L) { self->function = L; })
         .addProperty("shortestPath", &ParticleRotationModifier::shortestPath)
         .endClass();
@@ -534,6 +543,7 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .addProperty("toTime", &ParticleScaleModifier::toTime)
         .addProperty("fromScale", &ParticleScaleModifier::fromScale)
         .addProperty("toScale", &ParticleScaleModifier::toScale)
+        .addProperty("functionType", &ParticleScaleModifier::functionType)
         .addProperty("function", [] (ParticleScaleModifier* self, lua_State* L) { return &self->function; }, [] (ParticleScaleModifier* self, lua_State* L) { self->function = L; })
         .endClass();
 
@@ -541,9 +551,11 @@ void LuaBinding::registerECSClasses(lua_State *L){
         .beginClass<ParticlesComponent>("ParticlesComponent")
         .addProperty("newParticlesCount", &ParticlesComponent::newParticlesCount)
         .addProperty("lastUsedParticle", &ParticlesComponent::lastUsedParticle)
+        .addProperty("emittedParticles", &ParticlesComponent::emittedParticles)
         .addProperty("emitter", &ParticlesComponent::emitter)
         .addProperty("loop", &ParticlesComponent::loop)
         .addProperty("rate", &ParticlesComponent::rate)
+        .addProperty("seed", &ParticlesComponent::seed)
         .addProperty("lifeInitializer", &ParticlesComponent::lifeInitializer)
         .addProperty("lifeInitializer", &ParticlesComponent::lifeInitializer)
         .addProperty("positionInitializer", &ParticlesComponent::positionInitializer)
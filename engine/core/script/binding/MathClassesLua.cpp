@@ -448,6 +448,7 @@ void LuaBinding::registerMathClasses(lua_State *L){
         .beginNamespace("RayFilter")
         .addVariable("BODY_2D", RayFilter::BODY_2D)
         .addVariable("BODY_3D", RayFilter::BODY_3D)
+        .addVariable("MESH", RayFilter::MESH)
         .endNamespace();
 
     luabridge::getGlobalNamespace(L)
@@ -462,6 +462,11 @@ void LuaBinding::registerObjectClasses(lua_State *L){
         .addFunction("setMorphWeight", 
             luabridge::overload<int, float>(&Model::setMorphWeight),
             luabridge::overload<std::string, float>(&Model::setMorphWeight))
+        .addProperty("animationLodDistance", &Model::getAnimationLodDistance, &Model::setAnimationLodDistance)
+        .addProperty("animationLodMaxInterval", &Model::getAnimationLodMaxInterval, &Model::setAnimationLodMaxInterval)
+        .addProperty("reducedBonesDistance", &Model::getReducedBonesDistance, &Model::setReducedBonesDistance)
+        .addProperty("reducedBonesDepth", &Model::getReducedBonesDepth, &Model::setReducedBonesDepth)
+        .addProperty("pauseAnimationOffscreen", &Model::isPauseAnimationOffscreen, &Model::setPauseAnimationOffscreen)
         .endClass();
 
     luabridge::getGlobalNamespace(L)
@@ -8,12 +8,24 @@
 #include "util/Color.h"
 #include "util/Angle.h"
 #include "subsystem/MeshSystem.h"
+#include "subsystem/RenderSystem.h"
+#include "util/ThreadPool.h"
+#include <unordered_set>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define ACTIONSYSTEM_SSE
+#endif
 
 using namespace Supernova;
 
 
 ActionSystem::ActionSystem(Scene* scene): SubSystem(scene){
     signature.set(scene->getComponentId<ActionComponent>());
+
+    animationLodFrame = 0;
+    skippedAnimationSamples = 0;
 }
 
 void ActionSystem::actionStart(Entity entity){
@@ -22,6 +34,10 @@ void ActionSystem::actionStart(Entity entity){
 
     actionComponentStart(action);
 
+    if (signature.test(scene->getComponentId<AnimationComponent>())){
+        animationPackClip(scene->getComponent<AnimationComponent>(entity));
+    }
+
     if (action.target != NULL_ENTITY){
         Signature targetSignature = scene->getSignature(action.target);
 
@@ -50,12 +66,12 @@ void ActionSystem::actionStart(Entity entity){
 
                 InstancedMeshComponent& instmesh = scene->getComponent<InstancedMeshComponent>(action.target);
 
-                particleActionStart(particles, instmesh, mesh);
+                particleActionStart(entity, particles, instmesh, mesh);
             }
             if (targetSignature.test(scene->getComponentId<PointsComponent>()) ){
                 PointsComponent& points = scene->getComponent<PointsComponent>(action.target);
 
-                particleActionStart(particles, points);
+                particleActionStart(entity, particles, points);
 
             }
         }
@@ -81,6 +97,10 @@ void ActionSystem::actionStop(Entity entity){
         timedActionStop(timedaction);
     }
 
+    if (signature.test(scene->getComponentId<AnimationComponent>())){
+        animationUnpackClip(scene->getComponent<AnimationComponent>(entity));
+    }
+
     if (action.target != NULL_ENTITY){
         Signature targetSignature = scene->getSignature(action.target);
 
@@ -130,13 +150,82 @@ void ActionSystem::actionDestroy(ActionComponent& action){
     }
 }
 
+void ActionSystem::animationLodUpdate(){
+    animationLodFrame++;
+
+    Entity cameraEntity = scene->getCamera();
+    Transform* cameraTransform = scene->findComponent<Transform>(cameraEntity);
+
+    lodCameras.clear();
+    for (auto [entity, camera] : scene->view<CameraComponent>()){
+        if (entity == cameraEntity || camera.renderToTexture){
+            lodCameras.push_back(&camera);
+        }
+    }
+
+    RenderSystem* render = scene->getSystem<RenderSystem>().get();
+
+    for (auto [entity, transform, model, mesh] : scene->view<Transform, ModelComponent, MeshComponent>()){
+        model.animationSkipUpdate = false;
+        model.animationReducedBones = false;
+        model.animationOffscreen = false;
+
+        // shadow casters can be seen through their shadows from outside the view
+        if (model.pauseAnimationOffscreen && !mesh.castShadows && !mesh.worldAABB.isNull() && !mesh.worldAABB.isInfinite()){
+            model.animationOffscreen = true;
+            for (CameraComponent* camera : lodCameras){
+                if (render->isInsideCamera(*camera, mesh.worldAABB)){
+                    model.animationOffscreen = false;
+                    break;
+                }
+            }
+        }
+
+        if (cameraTransform && (model.animationLodDistance > 0 || model.reducedBonesDistance > 0)){
+            float distance = transform.worldPosition.distance(cameraTransform->worldPosition);
+
+            if (model.animationLodDistance > 0){
+                int interval = std::min(1 + (int)(distance / model.animationLodDistance), std::max(model.animationLodMaxInterval, 1));
+                // entity spreads updates of models with same interval across frames
+                model.animationSkipUpdate = ((animationLodFrame + entity) % interval) != 0;
+            }
+
+            model.animationReducedBones = (model.reducedBonesDistance > 0 && distance > model.reducedBonesDistance);
+        }
+
+        if (model.animationOffscreen){
+            model.animationSkipUpdate = true;
+        }
+    }
+}
+
 void ActionSystem::animationUpdate(double dt, Entity entity, ActionComponent& action, AnimationComponent& animcomp){
     int totalActionsPassed = 0;
 
+    ModelComponent* model = scene->findComponent<ModelComponent>(action.target);
+
+    AnimationClipData& clip = animcomp.clip;
+    if (clip.packed){
+        bool changed = (clip.actionChannels.size() != animcomp.actions.size());
+        for (size_t i = 0; !changed && i < animcomp.actions.size(); i++){
+            int c = clip.actionChannels[i];
+            changed = (c >= 0 && clip.channels[c].action != animcomp.actions[i].action);
+        }
+        if (changed){
+            animationPackClip(animcomp);
+        }
+    }
+
     for (int i = 0; i < animcomp.actions.size(); i++){
 
         float timeDiff = action.timecount - animcomp.actions[i].startTime;
 
+        AnimationChannel* channel = nullptr;
+        if (clip.packed && clip.actionChannels[i] >= 0){
+            channel = &clip.channels[clip.actionChannels[i]];
+            channel->active = false;
+        }
+
         Signature isignature = scene->getSignature(animcomp.actions[i].action);
 
         if (isignature.test(scene->getComponentId<ActionComponent>())){
@@ -150,6 +239,29 @@ void ActionSystem::animationUpdate(double dt, Entity entity, ActionComponent& ac
 
                 iaction.timecount = timeDiff * iaction.speed;
 
+                if (model && isignature.test(scene->getComponentId<KeyframeTracksComponent>())){
+                    KeyframeTracksComponent& keyframe = scene->getComponent<KeyframeTracksComponent>(animcomp.actions[i].action);
+                    keyframe.skipUpdate = model->animationSkipUpdate;
+                    if (!keyframe.skipUpdate && model->animationReducedBones){
+                        BoneComponent* bone = scene->findComponent<BoneComponent>(iaction.target);
+                        keyframe.skipUpdate = (bone && bone->depth > model->reducedBonesDepth);
+                    }
+                }
+
+                if (channel && iaction.state == ActionState::Running){
+                    KeyframeTracksComponent& keyframe = scene->getComponent<KeyframeTracksComponent>(animcomp.actions[i].action);
+                    bool skipUpdate = keyframe.skipUpdate;
+                    keyframe.skipUpdate = false;
+
+                    if (skipUpdate){
+                        skippedAnimationSamples++;
+                    }else{
+                        channel->target = iaction.target;
+                        channel->time = iaction.timecount;
+                        channel->active = true;
+                    }
+                }
+
                 if (timeDiff > (animcomp.actions[i].duration / iaction.speed)) {
                     totalActionsPassed++;
                 }
@@ -159,6 +271,10 @@ void ActionSystem::animationUpdate(double dt, Entity entity, ActionComponent& ac
 
     }
 
+    if (clip.packed){
+        animationClipUpdate(clip);
+    }
+
     if (totalActionsPassed == animcomp.actions.size() || (animcomp.duration >= 0 && action.timecount >= (animcomp.duration / action.speed))) {
         if (!animcomp.loop) {
             actionStop(entity);
@@ -170,6 +286,8 @@ void ActionSystem::animationUpdate(double dt, Entity entity, ActionComponent& ac
 }
 
 void ActionSystem::animationDestroy(AnimationComponent& animcomp){
+    animationUnpackClip(animcomp);
+
     if (animcomp.ownedActions){
         for (int i = 0; i < animcomp.actions.size(); i++){
             scene->destroyEntity(animcomp.actions[i].action);
@@ -177,6 +295,132 @@ void ActionSystem::animationDestroy(AnimationComponent& animcomp){
     }
 }
 
+void ActionSystem::animationPackClip(AnimationComponent& animcomp){
+    AnimationClipData& clip = animcomp.clip;
+
+    animationUnpackClip(animcomp);
+
+    clip.actionChannels.assign(animcomp.actions.size(), -1);
+
+    for (size_t i = 0; i < animcomp.actions.size(); i++){
+        Entity track = animcomp.actions[i].action;
+
+        ActionComponent* action = scene->findComponent<ActionComponent>(track);
+        KeyframeTracksComponent* keyframe = scene->findComponent<KeyframeTracksComponent>(track);
+        if (!action || !keyframe || keyframe->packed || keyframe->times.empty()){
+            continue;
+        }
+
+        TranslateTracksComponent* translatetracks = scene->findComponent<TranslateTracksComponent>(track);
+        RotateTracksComponent* rotatetracks = scene->findComponent<RotateTracksComponent>(track);
+        ScaleTracksComponent* scaletracks = scene->findComponent<ScaleTracksComponent>(track);
+
+        // morph weights and tracks with more than one value keep their own update
+        int numTracks = (translatetracks ? 1 : 0) + (rotatetracks ? 1 : 0) + (scaletracks ? 1 : 0);
+        if (numTracks != 1 || scene->findComponent<MorphTracksComponent>(track)){
+            continue;
+        }
+
+        size_t keys = keyframe->times.size();
+
+        AnimationChannel channel;
+        channel.action = track;
+        channel.target = action->target;
+        channel.firstKey = (uint32_t)clip.times.size();
+        channel.keyCount = (uint32_t)keys;
+        channel.firstValue = (uint32_t)clip.values.size();
+
+        if (translatetracks){
+            if (translatetracks->values.size() != keys)
+                continue;
+
+            channel.type = AnimationChannelType::TRANSLATE;
+            for (const Vector3& value : translatetracks->values){
+                clip.values.insert(clip.values.end(), {value.x, value.y, value.z});
+            }
+        }else if (rotatetracks){
+            if (rotatetracks->values.size() != keys)
+                continue;
+
+            channel.type = AnimationChannelType::ROTATE;
+            for (const Quaternion& value : rotatetracks->values){
+                clip.values.insert(clip.values.end(), {value.w, value.x, value.y, value.z});
+            }
+        }else{
+            if (scaletracks->values.size() != keys)
+                continue;
+
+            channel.type = AnimationChannelType::SCALE;
+            for (const Vector3& value : scaletracks->values){
+                clip.values.insert(clip.values.end(), {value.x, value.y, value.z});
+            }
+        }
+
+        clip.times.insert(clip.times.end(), keyframe->times.begin(), keyframe->times.end());
+
+        keyframe->packed = true;
+        clip.actionChannels[i] = (int)clip.channels.size();
+        clip.channels.push_back(channel);
+    }
+
+    clip.packed = true;
+}
+
+void ActionSystem::animationUnpackClip(AnimationComponent& animcomp){
+    AnimationClipData& clip = animcomp.clip;
+
+    for (AnimationChannel& channel : clip.channels){
+        if (KeyframeTracksComponent* keyframe = scene->findComponent<KeyframeTracksComponent>(channel.action)){
+            keyframe->packed = false;
+        }
+    }
+
+    clip.times.clear();
+    clip.values.clear();
+    clip.channels.clear();
+    clip.actionChannels.clear();
+    clip.packed = false;
+}
+
+void ActionSystem::animationClipUpdate(AnimationClipData& clip){
+    auto transforms = scene->getComponentArray<Transform>();
+
+    for (AnimationChannel& channel : clip.channels){
+        if (!channel.active)
+            continue;
+
+        Transform* transform = transforms->findComponent(channel.target);
+        if (!transform)
+            continue;
+
+        const float* times = &clip.times[channel.firstKey];
+        int index = findKeyframe(times, (int)channel.keyCount - 1, channel.cursor, channel.time);
+        float interpolation = getKeyframeInterpolation(times, index, channel.time);
+        channel.cursor = index;
+
+        if (channel.type == AnimationChannelType::ROTATE){
+            const float* next = &clip.values[channel.firstValue + (index * 4)];
+            const float* previous = (index > 0) ? (next - 4) : next;
+
+            transform->rotation = Quaternion::slerp(interpolation, Quaternion(previous[0], previous[1], previous[2], previous[3]), Quaternion(next[0], next[1], next[2], next[3]));
+        }else{
+            const float* next = &clip.values[channel.firstValue + (index * 3)];
+            const float* previous = (index > 0) ? (next - 3) : next;
+
+            Vector3 value(previous[0] + interpolation * (next[0] - previous[0]),
+                          previous[1] + interpolation * (next[1] - previous[1]),
+                          previous[2] + interpolation * (next[2] - previous[2]));
+
+            if (channel.type == AnimationChannelType::TRANSLATE){
+                transform->position = value;
+            }else{
+                transform->scale = value;
+            }
+        }
+        transform->needUpdate = true;
+    }
+}
+
 void ActionSystem::setSpriteTextureRect(MeshComponent& mesh, SpriteComponent& sprite, SpriteAnimationComponent& spriteanim){
     if (spriteanim.frameIndex < MAX_SPRITE_FRAMES){
         SpriteFrameData frameData = sprite.framesRect[spriteanim.frames[spriteanim.frameIndex]];
@@ -299,41 +543,43 @@ void ActionSystem::alphaActionUIUpdate(double dt, ActionComponent& action, Timed
 }
 
 int ActionSystem::findUnusedParticle(ParticlesComponent& particles){
+    std::vector<uint32_t>& freeSlots = particles.particles.freeSlots;
 
-    for (int i=particles.lastUsedParticle; i<particles.particles.size(); i++){
-        if (particles.particles[i].life <= particles.particles[i].time){
-            particles.lastUsedParticle = i;
-            return i;
-        }
+    if (freeSlots.empty()){
+        return -1;
     }
 
-    if (particles.loop){
-        for (int i=0; i<particles.lastUsedParticle; i++){
-            if (particles.particles[i].life <= particles.particles[i].time){
-                particles.lastUsedParticle = i;
-                return i;
-            }
-        }
-    }
+    int i = freeSlots.back();
+    freeSlots.pop_back();
 
-    return -1;
+    particles.lastUsedParticle = i;
+    return i;
 }
 
-float ActionSystem::getFloatInitializerValue(float& min, float& max){
+float ActionSystem::getParticleRandom(uint64_t& random){
+    // xorshift64*, each emitter has its own stream
+    random ^= random >> 12;
+    random ^= random << 25;
+    random ^= random >> 27;
+
+    return (float)((random * 0x2545F4914F6CDD1DULL) >> 40) / 16777216.0f;
+}
+
+float ActionSystem::getFloatInitializerValue(uint64_t& random, float& min, float& max){
     if (min != max) {
-        return min + ((max - min) * (float) rand() / (float) RAND_MAX);
+        return min + ((max - min) * getParticleRandom(random));
     }
     return max;
 }
 
-Vector3 ActionSystem::getVector3InitializerValue(Vector3& min, Vector3& max, bool linearSort){
+Vector3 ActionSystem::getVector3InitializerValue(uint64_t& random, Vector3& min, Vector3& max, bool linearSort){
     if (min != max) {
         if (!linearSort){
-            return Vector3( min.x + ((max.x - min.x) * (float) rand() / (float) RAND_MAX),
-                            min.y + ((max.y - min.y) * (float) rand() / (float) RAND_MAX),
-                            min.z + ((max.z - min.z) * (float) rand() / (float) RAND_MAX));
+            return Vector3( min.x + ((max.x - min.x) * getParticleRandom(random)),
+                            min.y + ((max.y - min.y) * getParticleRandom(random)),
+                            min.z + ((max.z - min.z) * getParticleRandom(random)));
         }else{
-            float factor = (float) rand() / (float) RAND_MAX;
+            float factor = getParticleRandom(random);
 
             return Vector3( min.x + ((max.x - min.x) * factor),
                             min.y + ((max.y - min.y) * factor),
@@ -343,16 +589,16 @@ Vector3 ActionSystem::getVector3InitializerValue(Vector3& min, Vector3& max, boo
     return max;
 }
 
-Quaternion ActionSystem::getQuaternionInitializerValue(Quaternion& min, Quaternion& max, bool shortestPath){
+Quaternion ActionSystem::getQuaternionInitializerValue(uint64_t& random, Quaternion& min, Quaternion& max, bool shortestPath){
     if (min != max) {
-        return Quaternion::slerp((float) rand() / (float) RAND_MAX, min, max, shortestPath);
+        return Quaternion::slerp(getParticleRandom(random), min, max, shortestPath);
     }
     return max;
 }
 
-Rect ActionSystem::getSpriteInitializerValue(std::vector<int>& frames, SpriteComponent& sprite){
+Rect ActionSystem::getSpriteInitializerValue(uint64_t& random, std::vector<int>& frames, SpriteComponent& sprite){
     if (frames.size() > 0){
-        int id = frames[int(frames.size()*rand()/(RAND_MAX + 1.0))];
+        int id = frames[std::min((size_t)(frames.size() * getParticleRandom(random)), frames.size() - 1)];
 
         if (id >= 0 && id < MAX_SPRITE_FRAMES && sprite.framesRect[id].active){
             return sprite.framesRect[id].rect;
@@ -362,9 +608,9 @@ Rect ActionSystem::getSpriteInitializerValue(std::vector<int>& frames, SpriteCom
     return Rect(0,0,1,1);
 }
 
-Rect ActionSystem::getSpriteInitializerValue(std::vector<int>& frames, PointsComponent& points){
+Rect ActionSystem::getSpriteInitializerValue(uint64_t& random, std::vector<int>& frames, PointsComponent& points){
     if (frames.size() > 0){
-        int id = frames[int(frames.size()*rand()/(RAND_MAX + 1.0))];
+        int id = frames[std::min((size_t)(frames.size() * getParticleRandom(random)), frames.size() - 1)];
 
         if (id >= 0 && id < MAX_SPRITE_FRAMES && points.framesRect[id].active){
             return points.framesRect[id].rect;
@@ -375,82 +621,150 @@ Rect ActionSystem::getSpriteInitializerValue(std::vector<int>& frames, PointsCom
 }
 
 void ActionSystem::applyParticleInitializers(size_t idx, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite){
+    uint64_t& random = particles.particles.random;
+
     ParticleLifeInitializer& lifeInit = particles.lifeInitializer;
-    particles.particles[idx].life = getFloatInitializerValue(lifeInit.minLife, lifeInit.maxLife);
+    particles.particles.life[idx] = getFloatInitializerValue(random, lifeInit.minLife, lifeInit.maxLife);
 
     ParticlePositionInitializer& posInit = particles.positionInitializer;
-    instmesh.instances[idx].position = getVector3InitializerValue(posInit.minPosition, posInit.maxPosition, false);
+    Vector3 position = getVector3InitializerValue(random, posInit.minPosition, posInit.maxPosition, false);
+    particles.particles.positionX[idx] = position.x;
+    particles.particles.positionY[idx] = position.y;
+    particles.particles.positionZ[idx] = position.z;
 
     ParticleVelocityInitializer& velInit = particles.velocityInitializer;
-    particles.particles[idx].velocity = getVector3InitializerValue(velInit.minVelocity, velInit.maxVelocity, false);
+    Vector3 velocity = getVector3InitializerValue(random, velInit.minVelocity, velInit.maxVelocity, false);
+    particles.particles.velocityX[idx] = velocity.x;
+    particles.particles.velocityY[idx] = velocity.y;
+    particles.particles.velocityZ[idx] = velocity.z;
 
     ParticleAccelerationInitializer& accInit = particles.accelerationInitializer;
-    particles.particles[idx].acceleration = getVector3InitializerValue(accInit.minAcceleration, accInit.maxAcceleration, false);
+    Vector3 acceleration = getVector3InitializerValue(random, accInit.minAcceleration, accInit.maxAcceleration, false);
+    particles.particles.accelerationX[idx] = acceleration.x;
+    particles.particles.accelerationY[idx] = acceleration.y;
+    particles.particles.accelerationZ[idx] = acceleration.z;
 
     ParticleColorInitializer& colInit = particles.colorInitializer;
-    instmesh.instances[idx].color = getVector3InitializerValue(colInit.minColor, colInit.maxColor, false);
+    instmesh.instances[idx].color = getVector3InitializerValue(random, colInit.minColor, colInit.maxColor, false);
     if (colInit.useSRGB){
         instmesh.instances[idx].color = Color::sRGBToLinear(instmesh.instances[idx].color);
     }
 
     ParticleAlphaInitializer& alpInit = particles.alphaInitializer;
-    instmesh.instances[idx].color.w = getFloatInitializerValue(alpInit.minAlpha, alpInit.maxAlpha);
+    instmesh.instances[idx].color.w = getFloatInitializerValue(random, alpInit.minAlpha, alpInit.maxAlpha);
 
     // size initializer is not applicable to instanced meshes
 
     if (sprite){
         ParticleSpriteInitializer& spriteInit = particles.spriteInitializer;
-        instmesh.instances[idx].textureRect = getSpriteInitializerValue(spriteInit.frames, *sprite);
+        instmesh.instances[idx].textureRect = getSpriteInitializerValue(random, spriteInit.frames, *sprite);
     }
 
     ParticleRotationInitializer& rotInit = particles.rotationInitializer;
-    instmesh.instances[idx].rotation = getQuaternionInitializerValue(rotInit.minRotation, rotInit.maxRotation, rotInit.shortestPath);
+    instmesh.instances[idx].rotation = getQuaternionInitializerValue(random, rotInit.minRotation, rotInit.maxRotation, rotInit.shortestPath);
 
     ParticleScaleInitializer& scaInit = particles.scaleInitializer;
-    instmesh.instances[idx].scale = getVector3InitializerValue(scaInit.minScale, scaInit.maxScale, scaInit.linearSort);
+    instmesh.instances[idx].scale = getVector3InitializerValue(random, scaInit.minScale, scaInit.maxScale, scaInit.linearSort);
 
 }
 
 void ActionSystem::applyParticleInitializers(size_t idx, ParticlesComponent& particles, PointsComponent& points){
+    uint64_t& random = particles.particles.random;
+
     ParticleLifeInitializer& lifeInit = particles.lifeInitializer;
-    particles.particles[idx].life = getFloatInitializerValue(lifeInit.minLife, lifeInit.maxLife);
+    particles.particles.life[idx] = getFloatInitializerValue(random, lifeInit.minLife, lifeInit.maxLife);
 
     ParticlePositionInitializer& posInit = particles.positionInitializer;
-    points.points[idx].position = getVector3InitializerValue(posInit.minPosition, posInit.maxPosition, false);
+    Vector3 position = getVector3InitializerValue(random, posInit.minPosition, posInit.maxPosition, false);
+    particles.particles.positionX[idx] = position.x;
+    particles.particles.positionY[idx] = position.y;
+    particles.particles.positionZ[idx] = position.z;
 
     ParticleVelocityInitializer& velInit = particles.velocityInitializer;
-    particles.particles[idx].velocity = getVector3InitializerValue(velInit.minVelocity, velInit.maxVelocity, false);
+    Vector3 velocity = getVector3InitializerValue(random, velInit.minVelocity, velInit.maxVelocity, false);
+    particles.particles.velocityX[idx] = velocity.x;
+    particles.particles.velocityY[idx] = velocity.y;
+    particles.particles.velocityZ[idx] = velocity.z;
 
     ParticleAccelerationInitializer& accInit = particles.accelerationInitializer;
-    particles.particles[idx].acceleration = getVector3InitializerValue(accInit.minAcceleration, accInit.maxAcceleration, false);
+    Vector3 acceleration = getVector3InitializerValue(random, accInit.minAcceleration, accInit.maxAcceleration, false);
+    particles.particles.accelerationX[idx] = acceleration.x;
+    particles.particles.accelerationY[idx] = acceleration.y;
+    particles.particles.accelerationZ[idx] = acceleration.z;
 
     ParticleColorInitializer& colInit = particles.colorInitializer;
-    points.points[idx].color = getVector3InitializerValue(colInit.minColor, colInit.maxColor, false);
+    points.points[idx].color = getVector3InitializerValue(random, colInit.minColor, colInit.maxColor, false);
     if (colInit.useSRGB){
         points.points[idx].color = Color::sRGBToLinear(points.points[idx].color);
     }
 
     ParticleAlphaInitializer& alpInit = particles.alphaInitializer;
-    points.points[idx].color.w = getFloatInitializerValue(alpInit.minAlpha, alpInit.maxAlpha);
+    points.points[idx].color.w = getFloatInitializerValue(random, alpInit.minAlpha, alpInit.maxAlpha);
 
     ParticleSizeInitializer& sizeInit = particles.sizeInitializer;
-    points.points[idx].size = getFloatInitializerValue(sizeInit.minSize, sizeInit.maxSize);
+    points.points[idx].size = getFloatInitializerValue(random, sizeInit.minSize, sizeInit.maxSize);
 
     ParticleSpriteInitializer& spriteInit = particles.spriteInitializer;
-    points.points[idx].textureRect = getSpriteInitializerValue(spriteInit.frames, points);
+    points.points[idx].textureRect = getSpriteInitializerValue(random, spriteInit.frames, points);
 
     ParticleRotationInitializer& rotInit = particles.rotationInitializer;
-    points.points[idx].rotation = Angle::defaultToRad(getQuaternionInitializerValue(rotInit.minRotation, rotInit.maxRotation, rotInit.shortestPath).getRoll());
+    points.points[idx].rotation = Angle::defaultToRad(getQuaternionInitializerValue(random, rotInit.minRotation, rotInit.maxRotation, rotInit.shortestPath).getRoll());
 
     // scale initializer is not applicable to points
 }
 
-float ActionSystem::getTimeFromParticleTime(float& time, float& fromTime, float& toTime){
-    if ((fromTime != toTime) && (time >= fromTime) && (time <= toTime)) {
-        return (time - fromTime) / (toTime - fromTime);
+bool ActionSystem::setupParticleModifier(ParticleModifierData& data, float fromTime, float toTime, EaseType functionType, FunctionSubscribe<float(float)>& function){
+    data.fromTime = fromTime;
+    data.toTime = toTime;
+    data.invDuration = (fromTime != toTime) ? (1.0f / (toTime - fromTime)) : 0;
+    data.functionType = functionType;
+    data.function = function.empty() ? nullptr : &function;
+
+    // particles out of modifier time are eased from -1, same value for all of them
+    data.outsideValue = data.function ? data.function->call(-1) : Ease::evaluate(functionType, -1);
+
+    data.active = (fromTime != toTime) || (data.outsideValue >= 0 && data.outsideValue <= 1);
+
+    return data.active;
+}
+
+bool ActionSystem::hasCustomParticleModifier(const ParticleModifiersData& mods){
+    const ParticleModifierData* all[] = {&mods.position, &mods.velocity, &mods.acceleration, &mods.color, &mods.alpha, &mods.size, &mods.sprite, &mods.rotation, &mods.scale};
+
+    for (const ParticleModifierData* data : all){
+        if (data->active && data->function){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ActionSystem::setupParticleModifiers(ParticleModifiersData& mods, ParticlesComponent& particles){
+    bool active = false;
+
+    active |= setupParticleModifier(mods.position, particles.positionModifier.fromTime, particles.positionModifier.toTime, particles.positionModifier.functionType, particles.positionModifier.function);
+    active |= setupParticleModifier(mods.velocity, particles.velocityModifier.fromTime, particles.velocityModifier.toTime, particles.velocityModifier.functionType, particles.velocityModifier.function);
+    active |= setupParticleModifier(mods.acceleration, particles.accelerationModifier.fromTime, particles.accelerationModifier.toTime, particles.accelerationModifier.functionType, particles.accelerationModifier.function);
+    active |= setupParticleModifier(mods.color, particles.colorModifier.fromTime, particles.colorModifier.toTime, particles.colorModifier.functionType, particles.colorModifier.function);
+    active |= setupParticleModifier(mods.alpha, particles.alphaModifier.fromTime, particles.alphaModifier.toTime, particles.alphaModifier.functionType, particles.alphaModifier.function);
+    active |= setupParticleModifier(mods.size, particles.sizeModifier.fromTime, particles.sizeModifier.toTime, particles.sizeModifier.functionType, particles.sizeModifier.function);
+    active |= setupParticleModifier(mods.sprite, particles.spriteModifier.fromTime, particles.spriteModifier.toTime, particles.spriteModifier.functionType, particles.spriteModifier.function);
+    active |= setupParticleModifier(mods.rotation, particles.rotationModifier.fromTime, particles.rotationModifier.toTime, particles.rotationModifier.functionType, particles.rotationModifier.function);
+    active |= setupParticleModifier(mods.scale, particles.scaleModifier.fromTime, particles.scaleModifier.toTime, particles.scaleModifier.functionType, particles.scaleModifier.function);
+
+    mods.active = active;
+
+    return active;
+}
+
+float ActionSystem::getParticleModifierValue(const ParticleModifierData& data, float time){
+    if ((data.fromTime != data.toTime) && (time >= data.fromTime) && (time <= data.toTime)) {
+        float value = (time - data.fromTime) * data.invDuration;
+        return data.function ? data.function->call(value) : Ease::evaluate(data.functionType, value);
     }
 
-    return -1;
+    return data.outsideValue;
 }
 
 float ActionSystem::getFloatModifierValue(float& value, float& fromValue, float& toValue){
@@ -489,152 +803,266 @@ Rect ActionSystem::getSpriteModifierValue(float& value, std::vector<int>& frames
     return Rect(0,0,1,1);
 }
 
-void ActionSystem::applyParticleModifiers(size_t idx, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite){
-    float particleTime = particles.particles[idx].time;
+void ActionSystem::applyParticleModifiers(size_t idx, const ParticleModifiersData& mods, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite){
+    ParticlesData& data = particles.particles;
+    float particleTime = data.time[idx];
     float value;
-    float time;
 
-    ParticlePositionModifier& posMod = particles.positionModifier;
-    time = getTimeFromParticleTime(particleTime, posMod.fromTime, posMod.toTime);
-    value = posMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        instmesh.instances[idx].position = getVector3ModifierValue(value, posMod.fromPosition, posMod.toPosition);
+    if (mods.position.active){
+        ParticlePositionModifier& posMod = particles.positionModifier;
+        value = getParticleModifierValue(mods.position, particleTime);
+        if (value >= 0 && value <= 1){
+            Vector3 position = getVector3ModifierValue(value, posMod.fromPosition, posMod.toPosition);
+            data.positionX[idx] = position.x;
+            data.positionY[idx] = position.y;
+            data.positionZ[idx] = position.z;
+        }
     }
 
-    ParticleVelocityModifier& velMod = particles.velocityModifier;
-    time = getTimeFromParticleTime(particleTime, velMod.fromTime, velMod.toTime);
-    value = velMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        particles.particles[idx].velocity = getVector3ModifierValue(value, velMod.fromVelocity, velMod.toVelocity);
+    if (mods.velocity.active){
+        ParticleVelocityModifier& velMod = particles.velocityModifier;
+        value = getParticleModifierValue(mods.velocity, particleTime);
+        if (value >= 0 && value <= 1){
+            Vector3 velocity = getVector3ModifierValue(value, velMod.fromVelocity, velMod.toVelocity);
+            data.velocityX[idx] = velocity.x;
+            data.velocityY[idx] = velocity.y;
+            data.velocityZ[idx] = velocity.z;
+        }
     }
 
-    ParticleAccelerationModifier& accMod = particles.accelerationModifier;
-    time = getTimeFromParticleTime(particleTime, accMod.fromTime, accMod.toTime);
-    value = accMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        particles.particles[idx].acceleration = getVector3ModifierValue(value, accMod.fromAcceleration, accMod.toAcceleration);
+    if (mods.acceleration.active){
+        ParticleAccelerationModifier& accMod = particles.accelerationModifier;
+        value = getParticleModifierValue(mods.acceleration, particleTime);
+        if (value >= 0 && value <= 1){
+            Vector3 acceleration = getVector3ModifierValue(value, accMod.fromAcceleration, accMod.toAcceleration);
+            data.accelerationX[idx] = acceleration.x;
+            data.accelerationY[idx] = acceleration.y;
+            data.accelerationZ[idx] = acceleration.z;
+        }
     }
 
-    ParticleColorModifier& colMod = particles.colorModifier;
-    time = getTimeFromParticleTime(particleTime, colMod.fromTime, colMod.toTime);
-    value = colMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        instmesh.instances[idx].color = getVector3ModifierValue(value, colMod.fromColor, colMod.toColor);
-        if (colMod.useSRGB){
-            instmesh.instances[idx].color = Color::sRGBToLinear(instmesh.instances[idx].color);
+    if (mods.color.active){
+        ParticleColorModifier& colMod = particles.colorModifier;
+        value = getParticleModifierValue(mods.color, particleTime);
+        if (value >= 0 && value <= 1){
+            instmesh.instances[idx].color = getVector3ModifierValue(value, colMod.fromColor, colMod.toColor);
+            if (colMod.useSRGB){
+                instmesh.instances[idx].color = Color::sRGBToLinear(instmesh.instances[idx].color);
+            }
         }
     }
 
-    ParticleAlphaModifier& alpMod = particles.alphaModifier;
-    time = getTimeFromParticleTime(particleTime, alpMod.fromTime, alpMod.toTime);
-    value = alpMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        instmesh.instances[idx].color.w = getFloatModifierValue(value, alpMod.fromAlpha, alpMod.toAlpha);
+    if (mods.alpha.active){
+        ParticleAlphaModifier& alpMod = particles.alphaModifier;
+        value = getParticleModifierValue(mods.alpha, particleTime);
+        if (value >= 0 && value <= 1){
+            instmesh.instances[idx].color.w = getFloatModifierValue(value, alpMod.fromAlpha, alpMod.toAlpha);
+        }
     }
 
     // size modifier is not applicable to instanced meshes
 
-    if (sprite){
+    if (sprite && mods.sprite.active){
         ParticleSpriteModifier& spriteMod = particles.spriteModifier;
-        time = getTimeFromParticleTime(particleTime, spriteMod.fromTime, spriteMod.toTime);
-        value = spriteMod.function.call(time);
+        value = getParticleModifierValue(mods.sprite, particleTime);
         if (value >= 0 && value <= 1){
             instmesh.instances[idx].textureRect = getSpriteModifierValue(value, spriteMod.frames, *sprite);
         }
     }
 
-    ParticleRotationModifier& rotMod = particles.rotationModifier;
-    time = getTimeFromParticleTime(particleTime, rotMod.fromTime, rotMod.toTime);
-    value = rotMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        instmesh.instances[idx].rotation = getQuaternionModifierValue(value, rotMod.fromRotation, rotMod.toRotation, rotMod.shortestPath);
+    if (mods.rotation.active){
+        ParticleRotationModifier& rotMod = particles.rotationModifier;
+        value = getParticleModifierValue(mods.rotation, particleTime);
+        if (value >= 0 && value <= 1){
+            instmesh.instances[idx].rotation = getQuaternionModifierValue(value, rotMod.fromRotation, rotMod.toRotation, rotMod.shortestPath);
+        }
     }
 
-    ParticleScaleModifier& scaMod = particles.scaleModifier;
-    time = getTimeFromParticleTime(particleTime, scaMod.fromTime, scaMod.toTime);
-    value = scaMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        instmesh.instances[idx].scale = getVector3ModifierValue(value, scaMod.fromScale, scaMod.toScale);
+    if (mods.scale.active){
+        ParticleScaleModifier& scaMod = particles.scaleModifier;
+        value = getParticleModifierValue(mods.scale, particleTime);
+        if (value >= 0 && value <= 1){
+            instmesh.instances[idx].scale = getVector3ModifierValue(value, scaMod.fromScale, scaMod.toScale);
+        }
     }
 
 }
 
-void ActionSystem::applyParticleModifiers(size_t idx, ParticlesComponent& particles, PointsComponent& points){
-    float particleTime = particles.particles[idx].time;
+void ActionSystem::applyParticleModifiers(size_t idx, const ParticleModifiersData& mods, ParticlesComponent& particles, PointsComponent& points){
+    ParticlesData& data = particles.particles;
+    float particleTime = data.time[idx];
     float value;
-    float time;
 
-    ParticlePositionModifier& posMod = particles.positionModifier;
-    time = getTimeFromParticleTime(particleTime, posMod.fromTime, posMod.toTime);
-    value = posMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        points.points[idx].position = getVector3ModifierValue(value, posMod.fromPosition, posMod.toPosition);
+    if (mods.position.active){
+        ParticlePositionModifier& posMod = particles.positionModifier;
+        value = getParticleModifierValue(mods.position, particleTime);
+        if (value >= 0 && value <= 1){
+            Vector3 position = getVector3ModifierValue(value, posMod.fromPosition, posMod.toPosition);
+            data.positionX[idx] = position.x;
+            data.positionY[idx] = position.y;
+            data.positionZ[idx] = position.z;
+        }
     }
 
-    ParticleVelocityModifier& velMod = particles.velocityModifier;
-    time = getTimeFromParticleTime(particleTime, velMod.fromTime, velMod.toTime);
-    value = velMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        particles.particles[idx].velocity = getVector3ModifierValue(value, velMod.fromVelocity, velMod.toVelocity);
+    if (mods.velocity.active){
+        ParticleVelocityModifier& velMod = particles.velocityModifier;
+        value = getParticleModifierValue(mods.velocity, particleTime);
+        if (value >= 0 && value <= 1){
+            Vector3 velocity = getVector3ModifierValue(value, velMod.fromVelocity, velMod.toVelocity);
+            data.velocityX[idx] = velocity.x;
+            data.velocityY[idx] = velocity.y;
+            data.velocityZ[idx] = velocity.z;
+        }
     }
 
-    ParticleAccelerationModifier& accMod = particles.accelerationModifier;
-    time = getTimeFromParticleTime(particleTime, accMod.fromTime, accMod.toTime);
-    value = accMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        particles.particles[idx].acceleration = getVector3ModifierValue(value, accMod.fromAcceleration, accMod.toAcceleration);
+    if (mods.acceleration.active){
+        ParticleAccelerationModifier& accMod = particles.accelerationModifier;
+        value = getParticleModifierValue(mods.acceleration, particleTime);
+        if (value >= 0 && value <= 1){
+            Vector3 acceleration = getVector3ModifierValue(value, accMod.fromAcceleration, accMod.toAcceleration);
+            data.accelerationX[idx] = acceleration.x;
+            data.accelerationY[idx] = acceleration.y;
+            data.accelerationZ[idx] = acceleration.z;
+        }
     }
 
-    ParticleColorModifier& colMod = particles.colorModifier;
-    time = getTimeFromParticleTime(particleTime, colMod.fromTime, colMod.toTime);
-    value = colMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        points.points[idx].color = getVector3ModifierValue(value, colMod.fromColor, colMod.toColor);
-        if (colMod.useSRGB){
-            points.points[idx].color = Color::sRGBToLinear(points.points[idx].color);
+    if (mods.color.active){
+        ParticleColorModifier& colMod = particles.colorModifier;
+        value = getParticleModifierValue(mods.color, particleTime);
+        if (value >= 0 && value <= 1){
+            points.points[idx].color = getVector3ModifierValue(value, colMod.fromColor, colMod.toColor);
+            if (colMod.useSRGB){
+                points.points[idx].color = Color::sRGBToLinear(points.points[idx].color);
+            }
         }
     }
 
-    ParticleAlphaModifier& alpMod = particles.alphaModifier;
-    time = getTimeFromParticleTime(particleTime, alpMod.fromTime, alpMod.toTime);
-    value = alpMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        points.points[idx].color.w = getFloatModifierValue(value, alpMod.fromAlpha, alpMod.toAlpha);
+    if (mods.alpha.active){
+        ParticleAlphaModifier& alpMod = particles.alphaModifier;
+        value = getParticleModifierValue(mods.alpha, particleTime);
+        if (value >= 0 && value <= 1){
+            points.points[idx].color.w = getFloatModifierValue(value, alpMod.fromAlpha, alpMod.toAlpha);
+        }
     }
 
-    ParticleSizeModifier& sizeMod = particles.sizeModifier;
-    time = getTimeFromParticleTime(particleTime, sizeMod.fromTime, sizeMod.toTime);
-    value = sizeMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        points.points[idx].size = getFloatModifierValue(value, sizeMod.fromSize, sizeMod.toSize);
+    if (mods.size.active){
+        ParticleSizeModifier& sizeMod = particles.sizeModifier;
+        value = getParticleModifierValue(mods.size, particleTime);
+        if (value >= 0 && value <= 1){
+            points.points[idx].size = getFloatModifierValue(value, sizeMod.fromSize, sizeMod.toSize);
+        }
     }
 
-    ParticleSpriteModifier& spriteMod = particles.spriteModifier;
-    time = getTimeFromParticleTime(particleTime, spriteMod.fromTime, spriteMod.toTime);
-    value = spriteMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        points.points[idx].textureRect = getSpriteModifierValue(value, spriteMod.frames, points);
+    if (mods.sprite.active){
+        ParticleSpriteModifier& spriteMod = particles.spriteModifier;
+        value = getParticleModifierValue(mods.sprite, particleTime);
+        if (value >= 0 && value <= 1){
+            points.points[idx].textureRect = getSpriteModifierValue(value, spriteMod.frames, points);
+        }
     }
 
-    ParticleRotationModifier& rotMod = particles.rotationModifier;
-    time = getTimeFromParticleTime(particleTime, rotMod.fromTime, rotMod.toTime);
-    value = rotMod.function.call(time);
-    if (value >= 0 && value <= 1){
-        points.points[idx].rotation = Angle::defaultToRad(getQuaternionModifierValue(value, rotMod.fromRotation, rotMod.toRotation, rotMod.shortestPath).getRoll());
+    if (mods.rotation.active){
+        ParticleRotationModifier& rotMod = particles.rotationModifier;
+        value = getParticleModifierValue(mods.rotation, particleTime);
+        if (value >= 0 && value <= 1){
+            points.points[idx].rotation = Angle::defaultToRad(getQuaternionModifierValue(value, rotMod.fromRotation, rotMod.toRotation, rotMod.shortestPath).getRoll());
+        }
     }
 
     // scale modifier is not applicable to points
 }
 
-void ActionSystem::particleActionStart(ParticlesComponent& particles, InstancedMeshComponent& instmesh, MeshComponent& mesh){
+void ActionSystem::createParticles(ParticlesComponent& particles, Entity entity){
+    ParticlesData& data = particles.particles;
+
+    size_t size = (particles.maxParticles + 3) & ~(size_t)3;
+
+    data.life.assign(size, 0);
+    data.time.assign(size, 0);
+    data.positionX.assign(size, 0);
+    data.positionY.assign(size, 0);
+    data.positionZ.assign(size, 0);
+    data.velocityX.assign(size, 0);
+    data.velocityY.assign(size, 0);
+    data.velocityZ.assign(size, 0);
+    data.accelerationX.assign(size, 0);
+    data.accelerationY.assign(size, 0);
+    data.accelerationZ.assign(size, 0);
+    data.alive.assign(size / 4, 0);
+
+    // first slots are emitted first
+    data.freeSlots.clear();
+    data.freeSlots.reserve(particles.maxParticles);
+    for (int i = (int)particles.maxParticles - 1; i >= 0; i--){
+        data.freeSlots.push_back(i);
+    }
+
+    // splitmix64, close seeds still give unrelated streams
+    uint64_t z = ((particles.seed != 0) ? (uint64_t)particles.seed : ((uint64_t)entity + 1)) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    data.random = (z != 0) ? z : 1;
+}
+
+void ActionSystem::integrateParticles(ParticlesData& data, float dt, size_t begin, size_t end){
+    const float halfDt = dt * 0.5f;
+
+    for (size_t i = begin; i < end; i += 4){
+#ifdef ACTIONSYSTEM_SSE
+        __m128 life = _mm_loadu_ps(&data.life[i]);
+        __m128 time = _mm_loadu_ps(&data.time[i]);
+        __m128 alive = _mm_cmpgt_ps(life, time);
+
+        data.alive[i / 4] = (uint8_t)_mm_movemask_ps(alive);
+        if (data.alive[i / 4] == 0)
+            continue;
+
+        __m128 vdt = _mm_and_ps(alive, _mm_set1_ps(dt));
+        __m128 vhalfdt = _mm_and_ps(alive, _mm_set1_ps(halfDt));
+
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(&data.velocityX[i]), _mm_mul_ps(_mm_loadu_ps(&data.accelerationX[i]), vhalfdt));
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(&data.velocityY[i]), _mm_mul_ps(_mm_loadu_ps(&data.accelerationY[i]), vhalfdt));
+        __m128 vz = _mm_add_ps(_mm_loadu_ps(&data.velocityZ[i]), _mm_mul_ps(_mm_loadu_ps(&data.accelerationZ[i]), vhalfdt));
+
+        _mm_storeu_ps(&data.velocityX[i], vx);
+        _mm_storeu_ps(&data.velocityY[i], vy);
+        _mm_storeu_ps(&data.velocityZ[i], vz);
+
+        _mm_storeu_ps(&data.positionX[i], _mm_add_ps(_mm_loadu_ps(&data.positionX[i]), _mm_mul_ps(vx, vdt)));
+        _mm_storeu_ps(&data.positionY[i], _mm_add_ps(_mm_loadu_ps(&data.positionY[i]), _mm_mul_ps(vy, vdt)));
+        _mm_storeu_ps(&data.positionZ[i], _mm_add_ps(_mm_loadu_ps(&data.positionZ[i]), _mm_mul_ps(vz, vdt)));
+
+        _mm_storeu_ps(&data.time[i], _mm_add_ps(time, vdt));
+#else
+        uint8_t mask = 0;
+        for (int l = 0; l < 4; l++){
+            size_t p = i + l;
+            if (data.life[p] > data.time[p]){
+                mask |= (1 << l);
+
+                data.velocityX[p] += data.accelerationX[p] * halfDt;
+                data.velocityY[p] += data.accelerationY[p] * halfDt;
+                data.velocityZ[p] += data.accelerationZ[p] * halfDt;
+
+                data.positionX[p] += data.velocityX[p] * dt;
+                data.positionY[p] += data.velocityY[p] * dt;
+                data.positionZ[p] += data.velocityZ[p] * dt;
+
+                data.time[p] += dt;
+            }
+        }
+        data.alive[i / 4] = mask;
+#endif
+    }
+}
+
+void ActionSystem::particleActionStart(Entity entity, ParticlesComponent& particles, InstancedMeshComponent& instmesh, MeshComponent& mesh){
     // Creating particles
-    particles.particles.clear();
+    createParticles(particles, entity);
+
     instmesh.instances.clear();
     for (int i = 0; i < particles.maxParticles; i++){
-        particles.particles.push_back({});
-        particles.particles.back().life = 0;
-        particles.particles.back().time = 0;
-
         instmesh.instances.push_back({});
         instmesh.instances.back().visible = false;
 
@@ -650,9 +1078,10 @@ void ActionSystem::particleActionStart(ParticlesComponent& particles, InstancedM
     particles.emitter = true;
     particles.newParticlesCount = 0;
     particles.lastUsedParticle = 0;
+    particles.emittedParticles = 0;
 }
 
-void ActionSystem::particleActionStart(ParticlesComponent& particles, PointsComponent& points){
+void ActionSystem::particleActionStart(Entity entity, ParticlesComponent& particles, PointsComponent& points){
     if (particles.sizeInitializer.minSize == 0 && particles.sizeInitializer.maxSize == 0){
         float size = std::max(points.texture.getWidth(), points.texture.getHeight());
         particles.sizeInitializer.minSize = size;
@@ -660,13 +1089,10 @@ void ActionSystem::particleActionStart(ParticlesComponent& particles, PointsComp
     }
 
     // Creating particles
-    particles.particles.clear();
+    createParticles(particles, entity);
+
     points.points.clear();
     for (int i = 0; i < particles.maxParticles; i++){
-        particles.particles.push_back({});
-        particles.particles.back().life = 0;
-        particles.particles.back().time = 0;
-
         points.points.push_back({});
         points.points.back().visible = false;
 
@@ -682,10 +1108,13 @@ void ActionSystem::particleActionStart(ParticlesComponent& particles, PointsComp
     particles.emitter = true;
     particles.newParticlesCount = 0;
     particles.lastUsedParticle = 0;
+    particles.emittedParticles = 0;
 }
 
-void ActionSystem::particlesActionUpdate(double dt, Entity entity, Entity target, ActionComponent& action, ParticlesComponent& particles, InstancedMeshComponent& instmesh){
-    SpriteComponent* sprite = scene->findComponent<SpriteComponent>(target);
+void ActionSystem::emitParticles(double dt, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite){
+    ParticlesData& data = particles.particles;
+
+    size_t count = std::min(data.life.size(), instmesh.instances.size());
 
     if (particles.emitter){
         particles.newParticlesCount += dt * particles.rate;
@@ -698,58 +1127,32 @@ void ActionSystem::particlesActionUpdate(double dt, Entity entity, Entity target
         for(int i=0; i<newparticles; i++){
             int particleIndex = findUnusedParticle(particles);
 
-            if (particleIndex >= 0){
-                particles.particles[particleIndex].time = 0;
+            if (particleIndex >= 0 && particleIndex < count){
+                data.time[particleIndex] = 0;
                 applyParticleInitializers(particleIndex, particles, instmesh, sprite);
                 instmesh.needUpdateInstances = true;
-            }else{
-                if (!particles.loop)
+
+                if (data.life[particleIndex] <= 0){
+                    data.freeSlots.push_back(particleIndex);
+                }
+
+                particles.emittedParticles++;
+                if (!particles.loop && particles.emittedParticles >= particles.maxParticles){
                     particles.emitter = false;
+                    break;
+                }
+            }else{
                 break;
             }
         }
     }
+}
 
-    bool existParticles = false;
-    for(int i=0; i<particles.particles.size(); i++){
-
-        float life = particles.particles[i].life;
-        float time = particles.particles[i].time;
-
-        if(life > time){
-
-            applyParticleModifiers(i, particles, instmesh, sprite);
-
-            Vector3 velocity = particles.particles[i].velocity;
-            Vector3 position = instmesh.instances[i].position;
-            Vector3 acceleration = particles.particles[i].acceleration;
-
-            velocity += acceleration * dt * 0.5f;
-            position += velocity * dt;
-            time += dt;
-
-            particles.particles[i].time = time;
-            particles.particles[i].velocity = velocity;
-            instmesh.instances[i].position = position;
-
-            existParticles = true;
-
-            instmesh.instances[i].visible = true;
-            instmesh.needUpdateInstances = true;
-
-            //printf("1.Particle %i life %f time %f position %f %f %f\n", i, life, time, position.x, position.y, position.z);
-        }else{
-            instmesh.instances[i].visible = false;
-        }
-    }
+void ActionSystem::emitParticles(double dt, ParticlesComponent& particles, PointsComponent& points){
+    ParticlesData& data = particles.particles;
 
-    if (!existParticles && !particles.emitter){
-        actionStop(entity);
-        //onFinish.call(object);
-    }
-}
+    size_t count = std::min(data.life.size(), points.points.size());
 
-void ActionSystem::particlesActionUpdate(double dt, Entity entity, Entity target, ActionComponent& action, ParticlesComponent& particles, PointsComponent& points){
     if (particles.emitter){
         particles.newParticlesCount += dt * particles.rate;
 
@@ -761,83 +1164,299 @@ void ActionSystem::particlesActionUpdate(double dt, Entity entity, Entity target
         for(int i=0; i<newparticles; i++){
             int particleIndex = findUnusedParticle(particles);
 
-            if (particleIndex >= 0){
-                particles.particles[particleIndex].time = 0;
+            if (particleIndex >= 0 && particleIndex < count){
+                data.time[particleIndex] = 0;
                 applyParticleInitializers(particleIndex, particles, points);
                 points.needUpdate = true;
-            }else{
-                if (!particles.loop)
+
+                if (data.life[particleIndex] <= 0){
+                    data.freeSlots.push_back(particleIndex);
+                }
+
+                particles.emittedParticles++;
+                if (!particles.loop && particles.emittedParticles >= particles.maxParticles){
                     particles.emitter = false;
+                    break;
+                }
+            }else{
                 break;
             }
         }
     }
+}
+
+bool ActionSystem::stepParticles(double dt, size_t begin, size_t end, const ParticleModifiersData& mods, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite, std::vector<uint32_t>& freed){
+    ParticlesData& data = particles.particles;
+
+    if (mods.active){
+        for (size_t i = begin; i < end; i++){
+            if (data.life[i] > data.time[i]){
+                applyParticleModifiers(i, mods, particles, instmesh, sprite);
+            }
+        }
+    }
+
+    integrateParticles(data, dt, begin, std::min((end + 3) & ~(size_t)3, data.life.size()));
 
     bool existParticles = false;
-    for(int i=0; i<particles.particles.size(); i++){
+    for (size_t i = begin; i < end; i++){
+        if ((data.alive[i / 4] >> (i % 4)) & 1){
+            instmesh.instances[i].position = Vector3(data.positionX[i], data.positionY[i], data.positionZ[i]);
+            instmesh.instances[i].visible = true;
 
-        float life = particles.particles[i].life;
-        float time = particles.particles[i].time;
+            // dead now, slot can be emitted again
+            if (data.life[i] <= data.time[i]){
+                freed.push_back(i);
+            }
 
-        if(life > time){
-            applyParticleModifiers(i, particles, points);
+            existParticles = true;
+        }else{
+            instmesh.instances[i].visible = false;
+        }
+    }
 
-            Vector3 velocity = particles.particles[i].velocity;
-            Vector3 position = points.points[i].position;
-            Vector3 acceleration = particles.particles[i].acceleration;
+    return existParticles;
+}
 
-            velocity += acceleration * dt * 0.5f;
-            position += velocity * dt;
-            time += dt;
+bool ActionSystem::stepParticles(double dt, size_t begin, size_t end, const ParticleModifiersData& mods, ParticlesComponent& particles, PointsComponent& points, std::vector<uint32_t>& freed){
+    ParticlesData& data = particles.particles;
 
-            particles.particles[i].time = time;
-            particles.particles[i].velocity = velocity;
-            points.points[i].position = position;
+    if (mods.active){
+        for (size_t i = begin; i < end; i++){
+            if (data.life[i] > data.time[i]){
+                applyParticleModifiers(i, mods, particles, points);
+            }
+        }
+    }
 
-            existParticles = true;
+    integrateParticles(data, dt, begin, std::min((end + 3) & ~(size_t)3, data.life.size()));
 
+    bool existParticles = false;
+    for (size_t i = begin; i < end; i++){
+        if ((data.alive[i / 4] >> (i % 4)) & 1){
+            points.points[i].position = Vector3(data.positionX[i], data.positionY[i], data.positionZ[i]);
             points.points[i].visible = true;
-            points.needUpdate = true;
 
-            //printf("1.Particle %i life %f time %f position %f %f %f\n", i, life, time, position.x, position.y, position.z);
+            // dead now, slot can be emitted again
+            if (data.life[i] <= data.time[i]){
+                freed.push_back(i);
+            }
+
+            existParticles = true;
         }else{
             points.points[i].visible = false;
         }
     }
 
-    if (!existParticles && !particles.emitter){
-        actionStop(entity);
-        //onFinish.call(object);
+    return existParticles;
+}
+
+void ActionSystem::particlesJobEmit(double dt, ParticlesJob& job){
+    if (job.instmesh){
+        emitParticles(dt, *job.particles, *job.instmesh, job.sprite);
+    }else{
+        emitParticles(dt, *job.particles, *job.points);
     }
 }
 
-void ActionSystem::keyframeUpdate(double dt, ActionComponent& action, KeyframeTracksComponent& keyframe){
-    if (keyframe.times.size() == 0)
+void ActionSystem::particlesJobStep(double dt, ParticlesChunk& chunk){
+    ParticlesJob& job = particlesJobs[chunk.job];
+
+    chunk.freed.clear();
+    if (job.instmesh){
+        chunk.exist = stepParticles(dt, chunk.begin, chunk.end, job.mods, *job.particles, *job.instmesh, job.sprite, chunk.freed);
+    }else{
+        chunk.exist = stepParticles(dt, chunk.begin, chunk.end, job.mods, *job.particles, *job.points, chunk.freed);
+    }
+}
+
+void ActionSystem::particlesUpdate(double dt){
+    // below this amount of particles threads cost more than they save
+    const size_t parallelMinParticles = 4096;
+    // multiple of 4, chunks start at SIMD blocks
+    const size_t chunkParticles = 8192;
+
+    if (particlesJobs.empty())
         return;
 
-    float currentTime = action.timecount;
+    auto actions = scene->getComponentArray<ActionComponent>();
+    auto particlesarr = scene->getComponentArray<ParticlesComponent>();
+    auto instmeshes = scene->getComponentArray<InstancedMeshComponent>();
+    auto allpoints = scene->getComponentArray<PointsComponent>();
+    auto sprites = scene->getComponentArray<SpriteComponent>();
+
+    size_t numJobs = 0;
+    for (ParticlesJob& job : particlesJobs){
+        ActionComponent* action = actions->findComponent(job.entity);
+
+        job.particles = particlesarr->findComponent(job.entity);
+        job.instmesh = (job.pointsTarget) ? nullptr : instmeshes->findComponent(job.target);
+        job.points = (job.pointsTarget) ? allpoints->findComponent(job.target) : nullptr;
+        job.sprite = (job.instmesh) ? sprites->findComponent(job.target) : nullptr;
+
+        if (action && action->state == ActionState::Running && job.particles && (job.instmesh || job.points)){
+            particlesJobs[numJobs++] = std::move(job);
+        }
+    }
+    particlesJobs.resize(numJobs);
+
+    size_t totalParticles = 0;
+    size_t numChunks = 0;
+    std::unordered_set<Entity> targets;
+    std::unordered_set<Entity> emitters;
+    for (ParticlesJob& job : particlesJobs){
+        // custom easing functions can be Lua and emitters sharing a target or particles write same data
+        bool newTarget = targets.insert(job.target).second;
+        bool newEmitter = emitters.insert(job.entity).second;
+        job.serial = !newTarget || !newEmitter;
+
+        if (job.instmesh){
+            job.count = std::min(job.particles->particles.life.size(), job.instmesh->instances.size());
+        }else{
+            job.count = std::min(job.particles->particles.life.size(), job.points->points.size());
+        }
+
+        totalParticles += job.count;
+        numChunks += (job.count + chunkParticles - 1) / chunkParticles;
+    }
+
+    bool parallel = (totalParticles >= parallelMinParticles) && (ThreadPool::instance().getNumWorkers() > 0);
+
+    // emission only uses the random stream of its own emitter, same results on any thread
+    if (parallel){
+        ThreadPool::instance().parallelFor(particlesJobs.size(), 1, [this, dt](size_t begin, size_t end){
+            for (size_t j = begin; j < end; j++){
+                if (!particlesJobs[j].serial){
+                    particlesJobEmit(dt, particlesJobs[j]);
+                }
+            }
+        });
+    }
+    for (ParticlesJob& job : particlesJobs){
+        if (!parallel || job.serial){
+            particlesJobEmit(dt, job);
+        }
+    }
+
+    particlesChunks.resize(numChunks);
+    size_t c = 0;
+    for (size_t j = 0; j < particlesJobs.size(); j++){
+        ParticlesJob& job = particlesJobs[j];
+
+        if (setupParticleModifiers(job.mods, *job.particles) && hasCustomParticleModifier(job.mods)){
+            job.serial = true;
+        }
+
+        for (size_t begin = 0; begin < job.count; begin += chunkParticles){
+            particlesChunks[c].job = j;
+            particlesChunks[c].begin = begin;
+            particlesChunks[c].end = std::min(begin + chunkParticles, job.count);
+            c++;
+        }
+    }
+
+    if (parallel){
+        ThreadPool::instance().parallelFor(particlesChunks.size(), 1, [this, dt](size_t begin, size_t end){
+            for (size_t k = begin; k < end; k++){
+                if (!particlesJobs[particlesChunks[k].job].serial){
+                    particlesJobStep(dt, particlesChunks[k]);
+                }
+            }
+        });
+    }
+    for (ParticlesChunk& chunk : particlesChunks){
+        if (!parallel || particlesJobs[chunk.job].serial){
+            particlesJobStep(dt, chunk);
+        }
+    }
+
+    // chunks merged in order, free slots do not depend on threads
+    std::vector<Entity> finished;
+    size_t k = 0;
+    for (size_t j = 0; j < particlesJobs.size(); j++){
+        ParticlesJob& job = particlesJobs[j];
+
+        bool existParticles = false;
+        for (; k < particlesChunks.size() && particlesChunks[k].job == j; k++){
+            existParticles = existParticles || particlesChunks[k].exist;
+            job.particles->particles.freeSlots.insert(job.particles->particles.freeSlots.end(), particlesChunks[k].freed.begin(), particlesChunks[k].freed.end());
+        }
+
+        if (existParticles){
+            if (job.instmesh){
+                job.instmesh->needUpdateInstances = true;
+            }else{
+                job.points->needUpdate = true;
+            }
+        }
+
+        if (!existParticles && !job.particles->emitter){
+            finished.push_back(job.entity);
+        }
+    }
 
-    keyframe.interpolation = 0;
+    particlesJobs.clear();
 
-    keyframe.index = 0;
-    while (keyframe.index < (keyframe.times.size()-1) && keyframe.times[keyframe.index] < currentTime){
-        keyframe.index++;
+    // stop callbacks can change components used by other jobs
+    for (Entity entity : finished){
+        ActionComponent* action = actions->findComponent(entity);
+        if (action && action->state == ActionState::Running){
+            actionStop(entity);
+            //onFinish.call(object);
+        }
     }
+}
+
+int ActionSystem::findKeyframe(const float* times, int lastIndex, int index, float currentTime){
+    // time usually moves forward a few keys, start from last cursor and search only when it jumps
+    index = std::clamp(index, 0, lastIndex);
+    if (index > 0 && times[index-1] >= currentTime){
+        index = (int)(std::lower_bound(times, times + index, currentTime) - times);
+    }else{
+        int steps = 0;
+        while (index < lastIndex && times[index] < currentTime && steps < 4){
+            index++;
+            steps++;
+        }
+        if (index < lastIndex && times[index] < currentTime){
+            index = (int)(std::lower_bound(times + index, times + lastIndex, currentTime) - times);
+        }
+    }
+
+    return index;
+}
+
+float ActionSystem::getKeyframeInterpolation(const float* times, int index, float currentTime){
+    float interpolation = 0;
 
     float previousTime = 0;
-    float nextTime = keyframe.times[keyframe.index];
+    float nextTime = times[index];
 
-    if (keyframe.index > 0){
-        previousTime = keyframe.times[keyframe.index-1];
+    if (index > 0){
+        previousTime = times[index-1];
     }
 
     if (nextTime > previousTime){
-        keyframe.interpolation = (currentTime - previousTime) / (nextTime - previousTime);
+        interpolation = (currentTime - previousTime) / (nextTime - previousTime);
     }
 
-    if (keyframe.interpolation > 1){
-        keyframe.interpolation = 1;
+    if (interpolation > 1){
+        interpolation = 1;
     }
+
+    return interpolation;
+}
+
+void ActionSystem::keyframeUpdate(double dt, ActionComponent& action, KeyframeTracksComponent& keyframe){
+    if (keyframe.times.size() == 0)
+        return;
+
+    float currentTime = action.timecount;
+
+    const float* times = keyframe.times.data();
+
+    keyframe.index = findKeyframe(times, (int)keyframe.times.size() - 1, keyframe.index, currentTime);
+    keyframe.interpolation = getKeyframeInterpolation(times, keyframe.index, currentTime);
 }
 
 void ActionSystem::translateTracksUpdate(KeyframeTracksComponent& keyframe, TranslateTracksComponent& translatetracks, Transform& transform){
@@ -871,17 +1490,18 @@ void ActionSystem::rotateTracksUpdate(KeyframeTracksComponent& keyframe, RotateT
 }
 
 void ActionSystem::morphTracksUpdate(KeyframeTracksComponent& keyframe, MorphTracksComponent& morpthtracks, MeshComponent& mesh){
-    std::vector<float> previousMorph = morpthtracks.values[0];
-    if (keyframe.index > 0){
-        previousMorph = morpthtracks.values[keyframe.index-1];
+    const unsigned int count = std::min(morpthtracks.count, (unsigned int)MAX_MORPHTARGETS);
+
+    if (morpthtracks.values.size() < (keyframe.index + 1) * (size_t)morpthtracks.count){
+        Log::error("MorphTrack of index %i has not enough weights", keyframe.index);
+        return;
     }
 
-    if ((keyframe.index == 0) || (morpthtracks.values[keyframe.index].size() == morpthtracks.values[keyframe.index-1].size())) {
-        for (int morphIndex = 0; morphIndex < morpthtracks.values[keyframe.index].size(); morphIndex++) {
-            mesh.morphWeights[morphIndex] = previousMorph[morphIndex] + keyframe.interpolation * (morpthtracks.values[keyframe.index][morphIndex] - previousMorph[morphIndex]);
-        }
-    }else{
-        Log::error("MorphTrack of index %i is different size than index %i", keyframe.index, keyframe.index-1);
+    const float* nextMorph = &morpthtracks.values[keyframe.index * morpthtracks.count];
+    const float* previousMorph = (keyframe.index > 0) ? (nextMorph - morpthtracks.count) : nextMorph;
+
+    for (unsigned int morphIndex = 0; morphIndex < count; morphIndex++) {
+        mesh.morphWeights[morphIndex] = previousMorph[morphIndex] + keyframe.interpolation * (nextMorph[morphIndex] - previousMorph[morphIndex]);
     }
 }
 
@@ -931,181 +1551,152 @@ void ActionSystem::actionStateChange(Entity entity, ActionComponent& action){
     }
 }
 
-void ActionSystem::update(double dt){
-
-    //Animations actions
-    auto animations = scene->getComponentArray<AnimationComponent>();
-    for (int i = 0; i < animations->size(); i++){
-        AnimationComponent& animcomp = animations->getComponentFromIndex(i);
+unsigned int ActionSystem::getSkippedAnimationSamples() const{
+    return skippedAnimationSamples;
+}
 
-        Entity entity = animations->getEntity(i);
-        Signature signature = scene->getSignature(entity);
+void ActionSystem::update(double dt){
+    skippedAnimationSamples = 0;
 
-        if (signature.test(scene->getComponentId<ActionComponent>())){
-            ActionComponent& action = scene->getComponent<ActionComponent>(entity);
+    animationLodUpdate();
 
-            actionStateChange(entity, action);
+    //Animations actions
+    for (auto [entity, animcomp, action] : scene->view<AnimationComponent, ActionComponent>()){
+        actionStateChange(entity, action);
 
-            if (action.state == ActionState::Running){
-                animationUpdate(dt, entity, action, animcomp);
-            }
+        if (action.state == ActionState::Running){
+            animationUpdate(dt, entity, action, animcomp);
         }
     }
 
     //All actions
-    auto actions = scene->getComponentArray<ActionComponent>();
-    for (int i = 0; i < actions->size(); i++){
-		ActionComponent& action = actions->getComponentFromIndex(i);
-
-        actionStateChange(actions->getEntity(i), action);
+    auto spriteanims = scene->getComponentArray<SpriteAnimationComponent>();
+    auto particlesarr = scene->getComponentArray<ParticlesComponent>();
+    auto keyframes = scene->getComponentArray<KeyframeTracksComponent>();
+    auto translatetracksarr = scene->getComponentArray<TranslateTracksComponent>();
+    auto rotatetracksarr = scene->getComponentArray<RotateTracksComponent>();
+    auto scaletracksarr = scene->getComponentArray<ScaleTracksComponent>();
+    auto morphtracksarr = scene->getComponentArray<MorphTracksComponent>();
+    auto timedactions = scene->getComponentArray<TimedActionComponent>();
+    auto posactions = scene->getComponentArray<PositionActionComponent>();
+    auto rotactions = scene->getComponentArray<RotationActionComponent>();
+    auto scaleactions = scene->getComponentArray<ScaleActionComponent>();
+    auto coloractions = scene->getComponentArray<ColorActionComponent>();
+    auto alphaactions = scene->getComponentArray<AlphaActionComponent>();
+
+    auto transforms = scene->getComponentArray<Transform>();
+    auto meshes = scene->getComponentArray<MeshComponent>();
+    auto sprites = scene->getComponentArray<SpriteComponent>();
+    auto instmeshes = scene->getComponentArray<InstancedMeshComponent>();
+    auto allpoints = scene->getComponentArray<PointsComponent>();
+    auto uis = scene->getComponentArray<UIComponent>();
+
+    for (auto [entity, action] : scene->view<ActionComponent>()){
+
+        actionStateChange(entity, action);
 
         // Action update
         if (action.state == ActionState::Running){
 
-            Entity entity = actions->getEntity(i);
-            Signature signature = scene->getSignature(entity);
-            Signature targetSignature;
-            if (action.target != NULL_ENTITY){
-                targetSignature = scene->getSignature(action.target);
-            }
-
             //Sprite animation
-            if (signature.test(scene->getComponentId<SpriteAnimationComponent>())){
-                SpriteAnimationComponent& spriteanim = scene->getComponent<SpriteAnimationComponent>(entity);
-                if (targetSignature.test(scene->getComponentId<SpriteComponent>()) && targetSignature.test(scene->getComponentId<MeshComponent>())){
-                    SpriteComponent& sprite = scene->getComponent<SpriteComponent>(action.target);
-                    MeshComponent& mesh = scene->getComponent<MeshComponent>(action.target);
-
-                    spriteActionUpdate(dt, entity, action, mesh, sprite, spriteanim);
+            if (SpriteAnimationComponent* spriteanim = spriteanims->findComponent(entity)){
+                SpriteComponent* sprite = sprites->findComponent(action.target);
+                MeshComponent* targetMesh = meshes->findComponent(action.target);
+                if (sprite && targetMesh){
+                    spriteActionUpdate(dt, entity, action, *targetMesh, *sprite, *spriteanim);
                     if (action.state != ActionState::Running) continue;
                 }
             }
 
-            //Particles
-            if (signature.test(scene->getComponentId<ParticlesComponent>())){
-                ParticlesComponent& particles = scene->getComponent<ParticlesComponent>(entity);
-
-                if (targetSignature.test(scene->getComponentId<InstancedMeshComponent>())){
-                    InstancedMeshComponent& instmesh = scene->getComponent<InstancedMeshComponent>(action.target);
-
-                    particlesActionUpdate(dt, entity, action.target, action, particles, instmesh);
-                    if (action.state != ActionState::Running) continue;
+            //Particles, all emitters are updated together after other actions
+            if (particlesarr->findComponent(entity)){
+                ParticlesJob job = {};
+                job.entity = entity;
+                job.target = action.target;
+                if (instmeshes->findComponent(action.target)){
+                    job.pointsTarget = false;
+                    particlesJobs.push_back(job);
                 }
-                if (targetSignature.test(scene->getComponentId<PointsComponent>())){
-                    PointsComponent& points = scene->getComponent<PointsComponent>(action.target);
-
-                    particlesActionUpdate(dt, entity, action.target, action, particles, points);
-                    if (action.state != ActionState::Running) continue;
+                if (allpoints->findComponent(action.target)){
+                    job.pointsTarget = true;
+                    particlesJobs.push_back(job);
                 }
             }
 
             //keyframe animation
-            if (signature.test(scene->getComponentId<KeyframeTracksComponent>())){
-                KeyframeTracksComponent& keyframe = scene->getComponent<KeyframeTracksComponent>(entity);
-
-                keyframeUpdate(dt, action, keyframe);
-                if (action.state != ActionState::Running) continue;
-
-                if (signature.test(scene->getComponentId<TranslateTracksComponent>())){
-                    TranslateTracksComponent& translatetracks = scene->getComponent<TranslateTracksComponent>(entity);
-
-                    if (targetSignature.test(scene->getComponentId<Transform>())){
-                        Transform& transform = scene->getComponent<Transform>(action.target);
-
-                        translateTracksUpdate(keyframe, translatetracks, transform);
-                    }
-                }
-
-                if (signature.test(scene->getComponentId<RotateTracksComponent>())){
-                    RotateTracksComponent& rotatetracks = scene->getComponent<RotateTracksComponent>(entity);
-
-                    if (targetSignature.test(scene->getComponentId<Transform>())){
-                        Transform& transform = scene->getComponent<Transform>(action.target);
-
-                        rotateTracksUpdate(keyframe, rotatetracks, transform);
-                    }
-                }
+            if (KeyframeTracksComponent* keyframe = keyframes->findComponent(entity)){
+                // set again by its animation in each update
+                bool skipUpdate = keyframe->skipUpdate;
+                keyframe->skipUpdate = false;
+
+                if (keyframe->packed){
+                    // sampled with its animation clip
+                }else if (skipUpdate){
+                    skippedAnimationSamples++;
+                }else{
+                    keyframeUpdate(dt, action, *keyframe);
+                    if (action.state != ActionState::Running) continue;
 
-                if (signature.test(scene->getComponentId<ScaleTracksComponent>())){
-                    ScaleTracksComponent& scaletracks = scene->getComponent<ScaleTracksComponent>(entity);
+                    if (Transform* targetTransform = transforms->findComponent(action.target)){
+                        if (TranslateTracksComponent* translatetracks = translatetracksarr->findComponent(entity)){
+                            translateTracksUpdate(*keyframe, *translatetracks, *targetTransform);
+                        }
 
-                    if (targetSignature.test(scene->getComponentId<Transform>())){
-                        Transform& transform = scene->getComponent<Transform>(action.target);
+                        if (RotateTracksComponent* rotatetracks = rotatetracksarr->findComponent(entity)){
+                            rotateTracksUpdate(*keyframe, *rotatetracks, *targetTransform);
+                        }
 
-                        scaleTracksUpdate(keyframe, scaletracks, transform);
+                        if (ScaleTracksComponent* scaletracks = scaletracksarr->findComponent(entity)){
+                            scaleTracksUpdate(*keyframe, *scaletracks, *targetTransform);
+                        }
                     }
-                }
-
-                if (signature.test(scene->getComponentId<MorphTracksComponent>())){
-                    MorphTracksComponent& morpthtracks = scene->getComponent<MorphTracksComponent>(entity);
-
-                    if (targetSignature.test(scene->getComponentId<MeshComponent>())){
-                        MeshComponent& mesh = scene->getComponent<MeshComponent>(action.target);
 
-                        morphTracksUpdate(keyframe, morpthtracks, mesh);
+                    if (MorphTracksComponent* morpthtracks = morphtracksarr->findComponent(entity)){
+                        if (MeshComponent* targetMesh = meshes->findComponent(action.target)){
+                            morphTracksUpdate(*keyframe, *morpthtracks, *targetMesh);
+                        }
                     }
                 }
             }
 
 
-            if (signature.test(scene->getComponentId<TimedActionComponent>())){
-                TimedActionComponent& timedaction = scene->getComponent<TimedActionComponent>(entity);
+            if (TimedActionComponent* timedaction = timedactions->findComponent(entity)){
 
-                timedActionUpdate(dt, entity, action, timedaction);
+                timedActionUpdate(dt, entity, action, *timedaction);
                 if (action.state != ActionState::Running) continue;
 
                 //Transform animation
-                if (targetSignature.test(scene->getComponentId<Transform>())){
-                    Transform& transform = scene->getComponent<Transform>(action.target);
-
-                    if (signature.test(scene->getComponentId<PositionActionComponent>())){
-                        PositionActionComponent& posaction = scene->getComponent<PositionActionComponent>(entity);
-
-                        positionActionUpdate(dt, action, timedaction, posaction, transform);
+                if (Transform* targetTransform = transforms->findComponent(action.target)){
+                    if (PositionActionComponent* posaction = posactions->findComponent(entity)){
+                        positionActionUpdate(dt, action, *timedaction, *posaction, *targetTransform);
                     }
 
-                    if (signature.test(scene->getComponentId<RotationActionComponent>())){
-                        RotationActionComponent& rotaction = scene->getComponent<RotationActionComponent>(entity);
-
-                        rotationActionUpdate(dt, action, timedaction, rotaction, transform);
+                    if (RotationActionComponent* rotaction = rotactions->findComponent(entity)){
+                        rotationActionUpdate(dt, action, *timedaction, *rotaction, *targetTransform);
                     }
 
-                    if (signature.test(scene->getComponentId<ScaleActionComponent>())){
-                        ScaleActionComponent& scaleaction = scene->getComponent<ScaleActionComponent>(entity);
-
-                        scaleActionUpdate(dt, action, timedaction, scaleaction, transform);
+                    if (ScaleActionComponent* scaleaction = scaleactions->findComponent(entity)){
+                        scaleActionUpdate(dt, action, *timedaction, *scaleaction, *targetTransform);
                     }
                 }
 
                 //Color animation
-                if (signature.test(scene->getComponentId<ColorActionComponent>())){
-                    ColorActionComponent& coloraction = scene->getComponent<ColorActionComponent>(entity);
-
-                    if (targetSignature.test(scene->getComponentId<MeshComponent>())){
-                        MeshComponent& mesh = scene->getComponent<MeshComponent>(action.target);
-
-                        colorActionMeshUpdate(dt, action, timedaction, coloraction, mesh);
+                if (ColorActionComponent* coloraction = coloractions->findComponent(entity)){
+                    if (MeshComponent* targetMesh = meshes->findComponent(action.target)){
+                        colorActionMeshUpdate(dt, action, *timedaction, *coloraction, *targetMesh);
                     }
-                    if (targetSignature.test(scene->getComponentId<UIComponent>())){
-                        UIComponent& uirender = scene->getComponent<UIComponent>(action.target);
-
-                        colorActionUIUpdate(dt, action, timedaction, coloraction, uirender);
+                    if (UIComponent* targetUI = uis->findComponent(action.target)){
+                        colorActionUIUpdate(dt, action, *timedaction, *coloraction, *targetUI);
                     }
                 }
 
                 //Alpha animation
-                if (signature.test(scene->getComponentId<AlphaActionComponent>())){
-                    AlphaActionComponent& alphaaction = scene->getComponent<AlphaActionComponent>(entity);
-
-                    if (targetSignature.test(scene->getComponentId<MeshComponent>())){
-                        MeshComponent& mesh = scene->getComponent<MeshComponent>(action.target);
-
-                        alphaActionMeshUpdate(dt, action, timedaction, alphaaction, mesh);
+                if (AlphaActionComponent* alphaaction = alphaactions->findComponent(entity)){
+                    if (MeshComponent* targetMesh = meshes->findComponent(action.target)){
+                        alphaActionMeshUpdate(dt, action, *timedaction, *alphaaction, *targetMesh);
                     }
-                    if (targetSignature.test(scene->getComponentId<UIComponent>())){
-                        UIComponent& uirender = scene->getComponent<UIComponent>(action.target);
-
-                        alphaActionUIUpdate(dt, action, timedaction, alphaaction, uirender);
+                    if (UIComponent* targetUI = uis->findComponent(action.target)){
+                        alphaActionUIUpdate(dt, action, *timedaction, *alphaaction, *targetUI);
                     }
                 }
 
@@ -1115,6 +1706,8 @@ void ActionSystem::update(double dt){
         }
 
 	}
+
+    particlesUpdate(dt);
 }
 
 void ActionSystem::entityDestroyed(Entity entity){
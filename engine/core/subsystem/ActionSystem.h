@@ -29,6 +29,9 @@
 #include "component/RotateTracksComponent.h"
 #include "component/ScaleTracksComponent.h"
 #include "component/MorphTracksComponent.h"
+#include "component/ModelComponent.h"
+#include "component/BoneComponent.h"
+#include "component/CameraComponent.h"
 
 namespace Supernova{
 
@@ -36,6 +39,60 @@ namespace Supernova{
 
     private:
 
+		// modifier values computed once for all particles of an update
+		struct ParticleModifierData{
+			float fromTime;
+			float toTime;
+			float invDuration;
+			EaseType functionType;
+			FunctionSubscribe<float(float)>* function; // only custom functions
+			float outsideValue;
+			bool active;
+		};
+
+		struct ParticleModifiersData{
+			ParticleModifierData position;
+			ParticleModifierData velocity;
+			ParticleModifierData acceleration;
+			ParticleModifierData color;
+			ParticleModifierData alpha;
+			ParticleModifierData size;
+			ParticleModifierData sprite;
+			ParticleModifierData rotation;
+			ParticleModifierData scale;
+			bool active;
+		};
+
+		// emitter updated by jobs, large ones are split in chunks
+		// components are found again when jobs run, callbacks can remove them
+		struct ParticlesJob{
+			Entity entity;
+			Entity target;
+			bool pointsTarget; // updates points instead of instances
+			ParticlesComponent* particles;
+			InstancedMeshComponent* instmesh;
+			PointsComponent* points;
+			SpriteComponent* sprite;
+			ParticleModifiersData mods;
+			size_t count;
+			bool serial; // runs only in calling thread
+		};
+
+		struct ParticlesChunk{
+			size_t job;
+			size_t begin;
+			size_t end;
+			bool exist;
+			std::vector<uint32_t> freed;
+		};
+
+		std::vector<ParticlesJob> particlesJobs;
+		std::vector<ParticlesChunk> particlesChunks;
+
+		std::vector<CameraComponent*> lodCameras;
+		uint64_t animationLodFrame;
+		unsigned int skippedAnimationSamples;
+
 		void actionStateChange(Entity entity, ActionComponent& action);
 
 		void actionComponentStart(ActionComponent& action);
@@ -45,8 +102,12 @@ namespace Supernova{
 
 		void actionDestroy(ActionComponent& action);
 
+		void animationLodUpdate();
 		void animationUpdate(double dt, Entity entity, ActionComponent& action, AnimationComponent& animcomp);
 		void animationDestroy(AnimationComponent& animcomp);
+		void animationPackClip(AnimationComponent& animcomp);
+		void animationUnpackClip(AnimationComponent& animcomp);
+		void animationClipUpdate(AnimationClipData& clip);
 
 		// Sprite action functions
 		void setSpriteTextureRect(MeshComponent& mesh, SpriteComponent& sprite, SpriteAnimationComponent& spriteanim);
@@ -69,29 +130,43 @@ namespace Supernova{
 		//Particle helpers functions
 		int findUnusedParticle(ParticlesComponent& particles);
 
-		float getFloatInitializerValue(float& min, float& max);
-		Vector3 getVector3InitializerValue(Vector3& min, Vector3& max, bool linearSort);
-		Quaternion getQuaternionInitializerValue(Quaternion& min, Quaternion& max, bool shortestPath);
-		Rect getSpriteInitializerValue(std::vector<int>& frames, SpriteComponent& sprite);
-		Rect getSpriteInitializerValue(std::vector<int>& frames, PointsComponent& points);
+		static float getParticleRandom(uint64_t& random);
+		float getFloatInitializerValue(uint64_t& random, float& min, float& max);
+		Vector3 getVector3InitializerValue(uint64_t& random, Vector3& min, Vector3& max, bool linearSort);
+		Quaternion getQuaternionInitializerValue(uint64_t& random, Quaternion& min, Quaternion& max, bool shortestPath);
+		Rect getSpriteInitializerValue(uint64_t& random, std::vector<int>& frames, SpriteComponent& sprite);
+		Rect getSpriteInitializerValue(uint64_t& random, std::vector<int>& frames, PointsComponent& points);
 		void applyParticleInitializers(size_t idx, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite);
 		void applyParticleInitializers(size_t idx, ParticlesComponent& particles, PointsComponent& points);
 
-		float getTimeFromParticleTime(float& time, float& fromTime, float& toTime);
+		bool setupParticleModifier(ParticleModifierData& data, float fromTime, float toTime, EaseType functionType, FunctionSubscribe<float(float)>& function);
+		bool hasCustomParticleModifier(const ParticleModifiersData& mods);
+		bool setupParticleModifiers(ParticleModifiersData& mods, ParticlesComponent& particles);
+		float getParticleModifierValue(const ParticleModifierData& data, float time);
 		float getFloatModifierValue(float& value, float& fromValue, float& toValue);
 		Vector3 getVector3ModifierValue(float& value, Vector3& fromValue, Vector3& toValue);
 		Quaternion getQuaternionModifierValue(float& value, Quaternion& fromValue, Quaternion& toValue, bool shortestPath);
 		Rect getSpriteModifierValue(float& value, std::vector<int>& frames, SpriteComponent& sprite);
 		Rect getSpriteModifierValue(float& value, std::vector<int>& frames, PointsComponent& points);
-		void applyParticleModifiers(size_t idx, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite);
-		void applyParticleModifiers(size_t idx, ParticlesComponent& particles, PointsComponent& points);
-
-		void particleActionStart(ParticlesComponent& particles, InstancedMeshComponent& instmesh, MeshComponent& mesh);
-		void particleActionStart(ParticlesComponent& particles, PointsComponent& points);
-		void particlesActionUpdate(double dt, Entity entity, Entity target, ActionComponent& action, ParticlesComponent& particles, InstancedMeshComponent& instmesh);
-		void particlesActionUpdate(double dt, Entity entity, Entity target, ActionComponent& action, ParticlesComponent& particles, PointsComponent& points);
+		void applyParticleModifiers(size_t idx, const ParticleModifiersData& mods, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite);
+		void applyParticleModifiers(size_t idx, const ParticleModifiersData& mods, ParticlesComponent& particles, PointsComponent& points);
+
+		void createParticles(ParticlesComponent& particles, Entity entity);
+		void integrateParticles(ParticlesData& data, float dt, size_t begin, size_t end);
+
+		void particleActionStart(Entity entity, ParticlesComponent& particles, InstancedMeshComponent& instmesh, MeshComponent& mesh);
+		void particleActionStart(Entity entity, ParticlesComponent& particles, PointsComponent& points);
+		void emitParticles(double dt, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite);
+		void emitParticles(double dt, ParticlesComponent& particles, PointsComponent& points);
+		bool stepParticles(double dt, size_t begin, size_t end, const ParticleModifiersData& mods, ParticlesComponent& particles, InstancedMeshComponent& instmesh, SpriteComponent* sprite, std::vector<uint32_t>& freed);
+		bool stepParticles(double dt, size_t begin, size_t end, const ParticleModifiersData& mods, ParticlesComponent& particles, PointsComponent& points, std::vector<uint32_t>& freed);
+		void particlesJobEmit(double dt, ParticlesJob& job);
+		void particlesJobStep(double dt, ParticlesChunk& chunk);
+		void particlesUpdate(double dt);
 
 		//Keyframe
+		static int findKeyframe(const float* times, int lastIndex, int index, float currentTime);
+		static float getKeyframeInterpolation(const float* times, int index, float currentTime);
 		void keyframeUpdate(double dt, ActionComponent& action, KeyframeTracksComponent& keyframe);
 		void translateTracksUpdate(KeyframeTracksComponent& keyframe, TranslateTracksComponent& translatetracks, Transform& transform);
 		void scaleTracksUpdate(KeyframeTracksComponent& keyframe, ScaleTracksComponent& scaletracks, Transform& transform);
@@ -104,6 +179,9 @@ namespace Supernova{
 		void actionStart(Entity entity);
 		void actionStop(Entity entity);
 		void actionPause(Entity entity);
+
+		// keyframe tracks not sampled in last update by animation level of detail
+		unsigned int getSkippedAnimationSamples() const;
 	
 		virtual void load();
 		virtual void destroy();
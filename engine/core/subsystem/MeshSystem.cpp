@@ -628,7 +628,7 @@ Matrix4 MeshSystem::getGLTFMeshGlobalMatrix(int nodeIndex, ModelComponent& model
     return matrix;
 }
 
-Entity MeshSystem::generateSketetalStructure(Entity entity, ModelComponent& model, int nodeIndex, int skinIndex){
+Entity MeshSystem::generateSketetalStructure(Entity entity, ModelComponent& model, int nodeIndex, int skinIndex, int depth){
     tinygltf::Node node = model.gltfModel->nodes[nodeIndex];
     tinygltf::Skin skin = model.gltfModel->skins[skinIndex];
 
@@ -674,6 +674,7 @@ Entity MeshSystem::generateSketetalStructure(Entity entity, ModelComponent& mode
     BoneComponent& bonecomp = scene->getComponent<BoneComponent>(bone);
 
     bonecomp.index = index;
+    bonecomp.depth = depth;
     scene->setEntityName(bone, node.name);
 
     Matrix4 matrix = getGLTFNodeMatrix(nodeIndex, model);
@@ -690,9 +691,19 @@ Entity MeshSystem::generateSketetalStructure(Entity entity, ModelComponent& mode
     model.bonesNameMapping[scene->getEntityName(bone)] = bone;
     model.bonesIdMapping[nodeIndex] = bone;
 
+    if (index >= 0 && index < MAX_BONES){
+        if (model.bones.size() <= index){
+            model.bones.resize(index + 1, NULL_ENTITY);
+            model.bonesOffsetMatrix.resize(index + 1);
+        }
+        model.bones[index] = bone;
+        model.bonesOffsetMatrix[index] = offsetMatrix;
+        model.bonesTransformIndex.clear();
+    }
+
     for (size_t i = 0; i < node.children.size(); i++){
         // here bonetransform and bonecomp losts references
-        scene->addEntityChild(bone, generateSketetalStructure(entity, model, node.children[i], skinIndex), false);
+        scene->addEntityChild(bone, generateSketetalStructure(entity, model, node.children[i], skinIndex, depth + 1), false);
     }
 
     return bone;
@@ -2052,16 +2063,26 @@ bool MeshSystem::loadGLTF(Entity entity, std::string filename){
 
         model.bonesNameMapping.clear();
         model.bonesIdMapping.clear();
+        model.bones.clear();
+        model.bonesOffsetMatrix.clear();
+        model.bonesTransformIndex.clear();
 
-        model.skeleton = generateSketetalStructure(entity, model, skeletonRoot, skinIndex);
+        // bones are sorted once after all skeleton is created
+        bool deferredHierarchySort = scene->isDeferredHierarchySort();
+        scene->setDeferredHierarchySort(true);
+
+        model.skeleton = generateSketetalStructure(entity, model, skeletonRoot, skinIndex, 0);
 
         if (model.skeleton != NULL_ENTITY) {
             if (skin.joints.size() > MAX_BONES){
                 Log::error("Cannot create skinning bigger than %i", MAX_BONES);
+                scene->setDeferredHierarchySort(deferredHierarchySort);
                 return false;
             }
             scene->addEntityChild(entity, model.skeleton, false);
         }
+
+        scene->setDeferredHierarchySort(deferredHierarchySort);
     }
 
     for (size_t i = 0; i < model.gltfModel->animations.size(); i++) {
@@ -2155,15 +2176,9 @@ bool MeshSystem::loadGLTF(Entity entity, std::string filename){
                     scene->addComponent<MorphTracksComponent>(track, {});
                     MorphTracksComponent& morphtracks = scene->getComponent<MorphTracksComponent>(track);
                     int morphNum = accessorOut.count / accessorIn.count;
-                    for (int c = 0; c < accessorIn.count; c++) {
-                        std::vector<float> weightsAc;
-                        for (int m = 0; m < morphNum; m++) {
-                            weightsAc.push_back(values[(morphNum * c) + m]);
-                        }
-
-                        keyframe.times.push_back(timeValues[c]);
-                        morphtracks.values.push_back(weightsAc);
-                    }
+                    morphtracks.count = morphNum;
+                    morphtracks.values.assign(values, values + (morphNum * accessorIn.count));
+                    keyframe.times.assign(timeValues, timeValues + accessorIn.count);
                 }
 
                 if (foundTrack) {
@@ -2470,6 +2485,9 @@ void MeshSystem::destroyModel(ModelComponent& model){
     }
     model.bonesIdMapping.clear();
     model.bonesNameMapping.clear();
+    model.bones.clear();
+    model.bonesOffsetMatrix.clear();
+    model.bonesTransformIndex.clear();
 
     clearAnimations(model);
 
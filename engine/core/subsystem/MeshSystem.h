@@ -42,7 +42,7 @@ namespace Supernova{
 		std::string getBufferName(int bufferViewIndex, ModelComponent& model);
 		Matrix4 getGLTFNodeMatrix(int nodeIndex, ModelComponent& model);
 		Matrix4 getGLTFMeshGlobalMatrix(int nodeIndex, ModelComponent& model, std::map<int, int>& nodesParent);
-		Entity generateSketetalStructure(Entity entity, ModelComponent& model, int nodeIndex, int skinIndex);
+		Entity generateSketetalStructure(Entity entity, ModelComponent& model, int nodeIndex, int skinIndex, int depth);
 		TextureFilter convertFilter(int filter);
 		TextureWrap convertWrap(int wrap);
 		void clearAnimations(ModelComponent& model);
@@ -125,25 +125,29 @@ bool PhysicsSystem::isLock3DBodies() const{
 void PhysicsSystem::updateBody2DPosition(Signature signature, Entity entity, Body2DComponent& body){
     if (signature.test(scene->getComponentId<Transform>())){
         Transform& transform = scene->getComponent<Transform>(entity);
-        if (b2Body_IsValid(body.body)){
+        updateBody2DPosition(transform, entity, body);
+    }
+}
 
-            b2Vec2 bNewPosition = {transform.worldPosition.x / pointsToMeterScale2D, transform.worldPosition.y / pointsToMeterScale2D};
-            float bNewAngle = Angle::defaultToRad(transform.worldRotation.getRoll());
+void PhysicsSystem::updateBody2DPosition(Transform& transform, Entity entity, Body2DComponent& body){
+    if (b2Body_IsValid(body.body)){
 
-            if (body.newBody && transform.needUpdate){
-                bNewPosition = {transform.position.x / pointsToMeterScale2D, transform.position.y / pointsToMeterScale2D};
-                bNewAngle = Angle::defaultToRad(transform.rotation.getRoll());
-                if (transform.parent != NULL_ENTITY){
-                    Log::warn("Body position and rotation cannot be obtained from world: %u (%s)", entity, scene->getEntityName(entity).c_str());
-                }
+        b2Vec2 bNewPosition = {transform.worldPosition.x / pointsToMeterScale2D, transform.worldPosition.y / pointsToMeterScale2D};
+        float bNewAngle = Angle::defaultToRad(transform.worldRotation.getRoll());
+
+        if (body.newBody && transform.needUpdate){
+            bNewPosition = {transform.position.x / pointsToMeterScale2D, transform.position.y / pointsToMeterScale2D};
+            bNewAngle = Angle::defaultToRad(transform.rotation.getRoll());
+            if (transform.parent != NULL_ENTITY){
+                Log::warn("Body position and rotation cannot be obtained from world: %u (%s)", entity, scene->getEntityName(entity).c_str());
             }
+        }
 
-            b2Transform bTransform = b2Body_GetTransform(body.body);
+        b2Transform bTransform = b2Body_GetTransform(body.body);
 
-            if (bTransform.p != bNewPosition || b2Rot_GetAngle(bTransform.q) != bNewAngle){
-                b2Body_SetTransform(body.body, bNewPosition, b2MakeRot(bNewAngle));
-                b2Body_SetAwake(body.body, true);
-            }
+        if (bTransform.p != bNewPosition || b2Rot_GetAngle(bTransform.q) != bNewAngle){
+            b2Body_SetTransform(body.body, bNewPosition, b2MakeRot(bNewAngle));
+            b2Body_SetAwake(body.body, true);
         }
     }
 }
@@ -151,26 +155,30 @@ void PhysicsSystem::updateBody2DPosition(Signature signature, Entity entity, Bod
 void PhysicsSystem::updateBody3DPosition(Signature signature, Entity entity, Body3DComponent& body){
     if (signature.test(scene->getComponentId<Transform>())){
         Transform& transform = scene->getComponent<Transform>(entity);
-        if (!body.body.IsInvalid()){
-            JPH::Vec3 jNewPosition(transform.worldPosition.x, transform.worldPosition.y, transform.worldPosition.z);
-            JPH::Quat jNewQuat(transform.worldRotation.x, transform.worldRotation.y, transform.worldRotation.z, transform.worldRotation.w);
+        updateBody3DPosition(transform, entity, body);
+    }
+}
 
-            if (body.newBody && transform.needUpdate){
-                jNewPosition = JPH::Vec3(transform.position.x, transform.position.y, transform.position.z);
-                jNewQuat = JPH::Quat(transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w);
-                if (transform.parent != NULL_ENTITY){
-                    Log::warn("Body position and rotation cannot be obtained from world: %u (%s)", entity, scene->getEntityName(entity).c_str());
-                }
+void PhysicsSystem::updateBody3DPosition(Transform& transform, Entity entity, Body3DComponent& body){
+    if (!body.body.IsInvalid()){
+        JPH::Vec3 jNewPosition(transform.worldPosition.x, transform.worldPosition.y, transform.worldPosition.z);
+        JPH::Quat jNewQuat(transform.worldRotation.x, transform.worldRotation.y, transform.worldRotation.z, transform.worldRotation.w);
+
+        if (body.newBody && transform.needUpdate){
+            jNewPosition = JPH::Vec3(transform.position.x, transform.position.y, transform.position.z);
+            jNewQuat = JPH::Quat(transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w);
+            if (transform.parent != NULL_ENTITY){
+                Log::warn("Body position and rotation cannot be obtained from world: %u (%s)", entity, scene->getEntityName(entity).c_str());
             }
+        }
 
-            JPH::BodyInterface &body_interface = world3D.GetBodyInterfaceNoLock();
-            JPH::Vec3 jPosition;
-            JPH::Quat jQuat;
-            body_interface.GetPositionAndRotation(body.body, jPosition, jQuat);
+        JPH::BodyInterface &body_interface = world3D.GetBodyInterfaceNoLock();
+        JPH::Vec3 jPosition;
+        JPH::Quat jQuat;
+        body_interface.GetPositionAndRotation(body.body, jPosition, jQuat);
 
-            if (jPosition != jNewPosition || jQuat != jNewQuat){
-                body_interface.SetPositionAndRotation(body.body, jNewPosition, jNewQuat, JPH::EActivation::Activate);
-            }
+        if (jPosition != jNewPosition || jQuat != jNewQuat){
+            body_interface.SetPositionAndRotation(body.body, jNewPosition, jNewQuat, JPH::EActivation::Activate);
         }
     }
 }
@@ -1806,14 +1814,14 @@ void PhysicsSystem::destroy(){
 
 void PhysicsSystem::update(double dt){
 	auto bodies2d = scene->getComponentArray<Body2DComponent>();
+	auto transforms = scene->getComponentArray<Transform>();
 
-	for (int i = 0; i < bodies2d->size(); i++){
-		Body2DComponent& body = bodies2d->getComponentFromIndex(i);
-		Entity entity = bodies2d->getEntity(i);
-		Signature signature = scene->getSignature(entity);
-
+	// bodies without transform are also not new anymore
+	for (auto [entity, body] : scene->view<Body2DComponent>()){
         if (b2Body_IsValid(body.body)){
-            updateBody2DPosition(signature, entity, body);
+            if (Transform* transform = transforms->findComponent(entity)){
+                updateBody2DPosition(*transform, entity, body);
+            }
 
             body.newBody = false;
         }
@@ -1861,13 +1869,11 @@ void PhysicsSystem::update(double dt){
 
     auto bodies3d = scene->getComponentArray<Body3DComponent>();
 
-	for (int i = 0; i < bodies3d->size(); i++){
-		Body3DComponent& body = bodies3d->getComponentFromIndex(i);
-		Entity entity = bodies3d->getEntity(i);
-		Signature signature = scene->getSignature(entity);
-
+	for (auto [entity, body] : scene->view<Body3DComponent>()){
         if (!body.body.IsInvalid()){
-            updateBody3DPosition(signature, entity, body);
+            if (Transform* transform = transforms->findComponent(entity)){
+                updateBody3DPosition(*transform, entity, body);
+            }
 
             body.newBody = false;
         }
@@ -1879,40 +1885,32 @@ void PhysicsSystem::update(double dt){
 		world3D.Update(dt, cCollisionSteps, temp_allocator, job_system);
 	}
 
-	for (int i = 0; i < bodies3d->size(); i++){
-		Body3DComponent& body = bodies3d->getComponentFromIndex(i);
-		Entity entity = bodies3d->getEntity(i);
-		Signature signature = scene->getSignature(entity);
-
+	for (auto [entity, body, transform] : scene->view<Body3DComponent, Transform>()){
         if (!body.body.IsInvalid()){
             JPH::BodyInterface &body_interface = world3D.GetBodyInterfaceNoLock();
             JPH::RVec3 position = body_interface.GetPosition(body.body);
             JPH::Quat rotation = body_interface.GetRotation(body.body);
-            if (signature.test(scene->getComponentId<Transform>())){
-                Transform& transform = scene->getComponent<Transform>(entity);
-
-                if (!std::isnan(position.GetX()) && !std::isnan(position.GetY()) && !std::isnan(position.GetZ())){
-                    Vector3 nPosition = Vector3(position.GetX(), position.GetY(), position.GetZ());
-                    Quaternion nRotation = Quaternion(rotation.GetW(), rotation.GetX(), rotation.GetY(), rotation.GetZ());
 
-                    if (transform.parent != NULL_ENTITY){
-                        Transform& transformParent = scene->getComponent<Transform>(transform.parent);
+            if (!std::isnan(position.GetX()) && !std::isnan(position.GetY()) && !std::isnan(position.GetZ())){
+                Vector3 nPosition = Vector3(position.GetX(), position.GetY(), position.GetZ());
+                Quaternion nRotation = Quaternion(rotation.GetW(), rotation.GetX(), rotation.GetY(), rotation.GetZ());
 
-                        nPosition = transformParent.modelMatrix.inverse() * nPosition;
-                        nRotation = transformParent.worldRotation.inverse() * nRotation;
-                    }
+                if (transform.parent != NULL_ENTITY){
+                    Transform& transformParent = scene->getComponent<Transform>(transform.parent);
 
-                    if (transform.position != nPosition){
-                        transform.position = nPosition;
-                        transform.needUpdate = true;
-                    }
+                    nPosition = transformParent.modelMatrix.inverse() * nPosition;
+                    nRotation = transformParent.worldRotation.inverse() * nRotation;
+                }
 
-                    if (transform.rotation != nRotation){
-                        transform.rotation = nRotation;
-                        transform.needUpdate = true;
-                    }
+                if (transform.position != nPosition){
+                    transform.position = nPosition;
+                    transform.needUpdate = true;
                 }
 
+                if (transform.rotation != nRotation){
+                    transform.rotation = nRotation;
+                    transform.needUpdate = true;
+                }
             }
         }
     }
@@ -8,6 +8,7 @@
 #include "SubSystem.h"
 #include "component/Body2DComponent.h"
 #include "component/Joint2DComponent.h"
+#include "component/Transform.h"
 #include "object/physics/Contact2D.h"
 #include "object/physics/Manifold2D.h"
 #include "object/physics/Body3D.h"
@@ -51,7 +52,9 @@ namespace Supernova{
 		JPH::ObjectLayerPairFilterMask* object_vs_object_layer_filter;
 
 		void updateBody2DPosition(Signature signature, Entity entity, Body2DComponent& body);
+		void updateBody2DPosition(Transform& transform, Entity entity, Body2DComponent& body);
 		void updateBody3DPosition(Signature signature, Entity entity, Body3DComponent& body);
+		void updateBody3DPosition(Transform& transform, Entity entity, Body3DComponent& body);
 
 		void createGenericJoltBody(Entity entity, Body3DComponent& body, const JPH::ShapeRefC shape);
 
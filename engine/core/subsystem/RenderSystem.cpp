@@ -17,8 +17,11 @@
 #include "util/Angle.h"
 #include "buffer/ExternalBuffer.h"
 #include "math/AABB.h"
+#include "util/ThreadPool.h"
 #include <memory>
 #include <cmath>
+#include <algorithm>
+#include <limits>
 
 using namespace Supernova;
 
@@ -37,6 +40,37 @@ RenderSystem::RenderSystem(Scene* scene): SubSystem(scene){
 	signature.set(scene->getComponentId<Transform>());
 
 	this->scene = scene;
+
+	for (int i = 0; i < 4; i++){
+		renderQueueVersions[i] = 0;
+	}
+	needUpdateRenderQueue = true;
+
+	culledMeshes = 0;
+	drawnMeshes = 0;
+	skippedSkinnings = 0;
+
+	meshSpatialVersion = 0;
+
+	renderQueueRevision = 0;
+	shadowCasterRevision = 0;
+	drawFrame = 0;
+
+	fsLightingHash = 0;
+	vsShadowsHash = 0;
+	fsShadowsHash = 0;
+	fsFogHash = 0;
+
+	clusteredLights = false;
+	fsClusterLightingHash = 0;
+	clusterLightingKey = 0;
+	clusterLightingValid = false;
+
+	needUpdateInstanceGroups = false;
+	instancePass = 0;
+	meshPipelines = 0;
+
+	pendingBatch = {nullptr, nullptr, 0, 0};
 }
 
 RenderSystem::~RenderSystem(){
@@ -114,6 +148,14 @@ void RenderSystem::destroy(){
 			destroyCamera(camera, false);
 		}
 	}
+
+	for (auto& [key, group] : instanceGroups){
+		destroyInstanceGroup(group);
+	}
+	instanceGroups.clear();
+	meshContentHashes.clear();
+
+	destroyBatches();
 }
 
 void RenderSystem::createFramebuffer(CameraComponent& camera){
@@ -185,8 +227,6 @@ int RenderSystem::checkLightsAndShadow(){
 	auto lights = scene->getComponentArray<LightComponent>();
 
 	int numLights = lights->size();
-	if (numLights > MAX_LIGHTS)
-		numLights = MAX_LIGHTS;
 
 	if (numLights > 0)
 		hasLights = true;
@@ -257,12 +297,12 @@ bool RenderSystem::loadLights(int numLights){
 	return true;
 }
 
-void RenderSystem::processLights(Transform& cameraTransform){
+void RenderSystem::processLights(CameraComponent& camera, Transform& cameraTransform){
 	auto lights = scene->getComponentArray<LightComponent>();
 
 	int numLights = lights->size();
-	if (numLights > MAX_LIGHTS)
-		numLights = MAX_LIGHTS;
+
+	lightsData.resize(numLights);
 
 	for (int i = 0; i < numLights; i++){
 		LightComponent& light = lights->getComponentFromIndex(i);
@@ -295,17 +335,115 @@ void RenderSystem::processLights(Transform& cameraTransform){
 			}
 		}
 
-		fs_lighting.direction_range[i] = Vector4(light.worldDirection.x, light.worldDirection.y, light.worldDirection.z, light.range);
-		fs_lighting.color_intensity[i] = Vector4(light.color.x, light.color.y, light.color.z, light.intensity);
-		fs_lighting.position_type[i] = Vector4(worldPosition.x, worldPosition.y, worldPosition.z, (float)type);
-		fs_lighting.inCon_ouCon_shadows_cascades[i] = Vector4(light.innerConeCos, light.outerConeCos, light.shadowMapIndex, light.numShadowCascades);
-		fs_lighting.eyePos = Vector4(cameraTransform.worldPosition.x, cameraTransform.worldPosition.y, cameraTransform.worldPosition.z, 0.0);
+		lightsData[i].direction_range = Vector4(light.worldDirection.x, light.worldDirection.y, light.worldDirection.z, light.range);
+		lightsData[i].color_intensity = Vector4(light.color.x, light.color.y, light.color.z, light.intensity);
+		lightsData[i].position_type = Vector4(worldPosition.x, worldPosition.y, worldPosition.z, (float)type);
+		lightsData[i].inCon_ouCon_shadows_cascades = Vector4(light.innerConeCos, light.outerConeCos, light.shadowMapIndex, light.numShadowCascades);
+	}
+
+	clusteredLights = (numLights > MAX_LIGHTS);
+	clusterLightingValid = false;
+
+	for (int i = 0; i < MAX_LIGHTS; i++){
+		if (i < numLights){
+			fs_lighting.direction_range[i] = lightsData[i].direction_range;
+			fs_lighting.color_intensity[i] = lightsData[i].color_intensity;
+			fs_lighting.position_type[i] = lightsData[i].position_type;
+			fs_lighting.inCon_ouCon_shadows_cascades[i] = lightsData[i].inCon_ouCon_shadows_cascades;
+		}else{
+			// Setting intensity of other lights to zero
+			fs_lighting.color_intensity[i].w = 0.0;
+		}
+	}
+	fs_lighting.eyePos = Vector4(cameraTransform.worldPosition.x, cameraTransform.worldPosition.y, cameraTransform.worldPosition.z, 0.0);
+	fs_clusterLighting.eyePos = fs_lighting.eyePos;
+
+	fsLightingHash = ObjectRender::getUniformHash(&fs_lighting, sizeof(float) * (16 * MAX_LIGHTS + 4));
+
+	if (clusteredLights){
+		lightCuller.clear();
+		lightCuller.reserve(numLights);
+		for (int i = 0; i < numLights; i++){
+			const LightData& data = lightsData[i];
+			// directional lights and lights without range reach everything
+			float range = (data.position_type.w == 0) ? 0 : data.direction_range.w;
+			lightCuller.add(Vector3(data.position_type.x, data.position_type.y, data.position_type.z), range);
+		}
+		lightCuller.build(camera.viewMatrix, camera.viewProjectionMatrix);
+	}
+	vsShadowsHash = ObjectRender::getUniformHash(&vs_shadows, sizeof(float) * (16 * MAX_SHADOWSMAP));
+	fsShadowsHash = ObjectRender::getUniformHash(&fs_shadows, sizeof(float) * (4 * (MAX_SHADOWSMAP + MAX_SHADOWSCUBEMAP)));
+}
+
+fs_lighting_t* RenderSystem::selectLights(const AABB& box, uint64_t& hash){
+	if (!clusteredLights || box.isNull() || box.isInfinite() || box == AABB::ZERO){
+		hash = fsLightingHash;
+		return &fs_lighting;
+	}
+
+	lightCuller.query(box, lightCandidates);
+
+	lightScores.clear();
+	for (uint32_t index : lightCandidates){
+		const LightData& data = lightsData[index];
+		float intensity = data.color_intensity.w;
+
+		if (intensity <= 0)
+			continue;
+
+		if (data.position_type.w == 0){
+			// directional lights always come first
+			lightScores.push_back(std::make_pair(std::numeric_limits<float>::max(), index));
+		}else{
+			float range = data.direction_range.w;
+			float sqDist = box.squaredDistance(Vector3(data.position_type.x, data.position_type.y, data.position_type.z));
+			if (range > 0 && sqDist > range * range)
+				continue;
+			lightScores.push_back(std::make_pair(intensity / std::max(sqDist, 1.0f), index));
+		}
+	}
+
+	size_t numSelected = std::min(lightScores.size(), (size_t)MAX_LIGHTS);
+	std::partial_sort(lightScores.begin(), lightScores.begin() + numSelected, lightScores.end(),
+		[](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b){
+			return (a.first != b.first) ? (a.first > b.first) : (a.second < b.second);
+		});
+	// same light order for the same set keeps the uniform hash stable
+	std::sort(lightScores.begin(), lightScores.begin() + numSelected,
+		[](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b){
+			return a.second < b.second;
+		});
+
+	uint64_t key = 14695981039346656037ULL;
+	for (size_t i = 0; i < numSelected; i++){
+		key = (key ^ (lightScores[i].second + 1)) * 1099511628211ULL;
+	}
+	key = (key ^ numSelected) * 1099511628211ULL;
+
+	// neighbour objects often share the same lights
+	if (clusterLightingValid && key == clusterLightingKey){
+		hash = fsClusterLightingHash;
+		return &fs_clusterLighting;
 	}
 
-	// Setting intensity of other lights to zero
-	for (int i = numLights; i < MAX_LIGHTS; i++){
-		fs_lighting.color_intensity[i].w = 0.0;
+	for (int i = 0; i < MAX_LIGHTS; i++){
+		if (i < numSelected){
+			const LightData& data = lightsData[lightScores[i].second];
+			fs_clusterLighting.direction_range[i] = data.direction_range;
+			fs_clusterLighting.color_intensity[i] = data.color_intensity;
+			fs_clusterLighting.position_type[i] = data.position_type;
+			fs_clusterLighting.inCon_ouCon_shadows_cascades[i] = data.inCon_ouCon_shadows_cascades;
+		}else{
+			fs_clusterLighting.color_intensity[i].w = 0.0;
+		}
 	}
+
+	fsClusterLightingHash = ObjectRender::getUniformHash(&fs_clusterLighting, sizeof(float) * (16 * MAX_LIGHTS + 4));
+	clusterLightingKey = key;
+	clusterLightingValid = true;
+
+	hash = fsClusterLightingHash;
+	return &fs_clusterLighting;
 }
 
 bool RenderSystem::loadAndProcessFog(){
@@ -326,6 +464,8 @@ bool RenderSystem::loadAndProcessFog(){
 
 		fs_fog.color_type = Vector4(fog->color.x, fog->color.y, fog->color.z, fogTypeI);
 		fs_fog.density_start_end = Vector4(fog->density, 0.0, fog->linearStart, fog->linearEnd);
+
+		fsFogHash = ObjectRender::getUniformHash(&fs_fog, sizeof(float) * 8);
 	}
 
 	return hasFog;
@@ -893,7 +1033,10 @@ bool RenderSystem::loadMesh(Entity entity, MeshComponent& mesh, uint8_t pipeline
 
 	mesh.needReload = false;
 	mesh.loadCalled = true;
-	SystemRender::addQueueCommand(&changeLoaded, new check_load_t{scene, entity});
+	// instance groups are not entities and are marked loaded by caller
+	if (entity != NULL_ENTITY){
+		SystemRender::addQueueCommand(&changeLoaded, new check_load_t{scene, entity});
+	}
 
 	return true;
 }
@@ -901,39 +1044,36 @@ bool RenderSystem::loadMesh(Entity entity, MeshComponent& mesh, uint8_t pipeline
 bool RenderSystem::drawMesh(MeshComponent& mesh, Transform& transform, CameraComponent& camera, Transform& camTransform, bool renderToTexture, InstancedMeshComponent* instmesh, TerrainComponent* terrain){
 	if (mesh.loaded){
 
-		if (mesh.worldAABB != AABB::ZERO && !isInsideCamera(camera, mesh.worldAABB)) {
-			return false;
-		}
-
 		if (mesh.needUpdateBuffer){
+			// dropped uploads are tried again in next draw
+			bool updated = true;
 			if (mesh.buffer.getUsage() != BufferUsage::IMMUTABLE)
-				mesh.buffer.getRender()->updateBuffer(mesh.buffer.getSize(), mesh.buffer.getData());
+				updated = mesh.buffer.updateRender(mesh.buffer.getSize()) && updated;
 			if (mesh.indices.getUsage() != BufferUsage::IMMUTABLE)
-				mesh.indices.getRender()->updateBuffer(mesh.indices.getSize(), mesh.indices.getData());
+				updated = mesh.indices.updateRender(mesh.indices.getSize()) && updated;
 			for (int i = 0; i < mesh.numExternalBuffers; i++){
 				if (mesh.eBuffers[i].getUsage() != BufferUsage::IMMUTABLE)
-					mesh.eBuffers[i].getRender()->updateBuffer(mesh.eBuffers[i].getSize(), mesh.eBuffers[i].getData());
+					updated = mesh.eBuffers[i].updateRender(mesh.eBuffers[i].getSize()) && updated;
 			}
 
-			mesh.needUpdateBuffer = false;
+			mesh.needUpdateBuffer = !updated;
 		}
 		unsigned int instanceCount = 1;
 		if (instmesh){
 			instanceCount = instmesh->numVisible;
 
 			if (instmesh->needUpdateBuffer){
-				instmesh->buffer.getRender()->updateBuffer(instmesh->buffer.getSize(), instmesh->buffer.getData());
-
-				instmesh->needUpdateBuffer = false;
+				instmesh->needUpdateBuffer = !instmesh->buffer.updateRender(instmesh->buffer.getSize());
 			}
 		}
 
 		if (terrain && terrain->needUpdateNodesBuffer){
+			bool updated = true;
 			for (int s = 0; s < 2; s++){
-				terrain->nodesbuffer[s].getRender()->updateBuffer(terrain->nodesbuffer[s].getSize(), terrain->nodesbuffer[s].getData());
+				updated = terrain->nodesbuffer[s].updateRender(terrain->nodesbuffer[s].getSize()) && updated;
 			}
 
-			terrain->needUpdateNodesBuffer = false;
+			terrain->needUpdateNodesBuffer = !updated;
 		}
 
 		if (terrain && terrain->needUpdateTerrain){
@@ -945,6 +1085,12 @@ bool RenderSystem::drawMesh(MeshComponent& mesh, Transform& transform, CameraCom
 			terrain->needUpdateTerrain = false;
 		}
 
+		uint64_t lightingHash = fsLightingHash;
+		fs_lighting_t* lighting = &fs_lighting;
+		if (hasLights){
+			lighting = selectLights(mesh.worldAABB, lightingHash);
+		}
+
 		for (int i = 0; i < mesh.numSubmeshes; i++){
 			ObjectRender& render = mesh.submeshes[i].render;
 
@@ -957,6 +1103,7 @@ bool RenderSystem::drawMesh(MeshComponent& mesh, Transform& transform, CameraCom
 			if (mesh.submeshes[i].needUpdateTexture || needUpdateFramebuffer){
 				ShaderData& shaderData = mesh.submeshes[i].shader.get()->shaderData;
 				loadPBRTextures(mesh.submeshes[i].material, shaderData, mesh.submeshes[i].render, mesh.receiveShadows);
+				needUpdateRenderQueue = true;
 			}
 			mesh.submeshes[i].needUpdateTexture = false; // loadDepthTexture is in drawMeshDepth
 
@@ -971,14 +1118,14 @@ bool RenderSystem::drawMesh(MeshComponent& mesh, Transform& transform, CameraCom
 			}
 
 			if (hasFog){
-				render.applyUniformBlock(mesh.submeshes[i].slotFSFog, ShaderStageType::FRAGMENT, sizeof(float) * 8, &fs_fog);
+				render.applyUniformBlock(mesh.submeshes[i].slotFSFog, ShaderStageType::FRAGMENT, sizeof(float) * 8, &fs_fog, fsFogHash);
 			}
 
 			if (hasLights){
-				render.applyUniformBlock(mesh.submeshes[i].slotFSLighting, ShaderStageType::FRAGMENT, sizeof(float) * (16 * MAX_LIGHTS + 4), &fs_lighting);
+				render.applyUniformBlock(mesh.submeshes[i].slotFSLighting, ShaderStageType::FRAGMENT, sizeof(float) * (16 * MAX_LIGHTS + 4), lighting, lightingHash);
 				if (hasShadows && mesh.receiveShadows){
-					render.applyUniformBlock(mesh.submeshes[i].slotVSShadows, ShaderStageType::VERTEX, sizeof(float) * (16 * MAX_SHADOWSMAP), &vs_shadows);
-					render.applyUniformBlock(mesh.submeshes[i].slotFSShadows, ShaderStageType::FRAGMENT, sizeof(float) * (4 * (MAX_SHADOWSMAP + MAX_SHADOWSCUBEMAP)), &fs_shadows);
+					render.applyUniformBlock(mesh.submeshes[i].slotVSShadows, ShaderStageType::VERTEX, sizeof(float) * (16 * MAX_SHADOWSMAP), &vs_shadows, vsShadowsHash);
+					render.applyUniformBlock(mesh.submeshes[i].slotFSShadows, ShaderStageType::FRAGMENT, sizeof(float) * (4 * (MAX_SHADOWSMAP + MAX_SHADOWSCUBEMAP)), &fs_shadows, fsShadowsHash);
 				}
 			}
 
@@ -1011,20 +1158,16 @@ bool RenderSystem::drawMesh(MeshComponent& mesh, Transform& transform, CameraCom
 			//model, normal and mvp matrix
 			render.applyUniformBlock(mesh.submeshes[i].slotVSParams, ShaderStageType::VERTEX, sizeof(float) * 48, &transform.modelMatrix);
 
-			render.draw(mesh.submeshes[i].vertexCount, instanceCount);
+			render.draw(mesh.submeshes[i].baseElement, mesh.submeshes[i].vertexCount, instanceCount);
 		}
 	}
 
 	return true;
 }
 
-bool RenderSystem::drawMeshDepth(MeshComponent& mesh, const float cameraFar, const Plane frustumPlanes[6], vs_depth_t vsDepthParams, InstancedMeshComponent* instmesh, TerrainComponent* terrain){
+bool RenderSystem::drawMeshDepth(MeshComponent& mesh, vs_depth_t vsDepthParams, InstancedMeshComponent* instmesh, TerrainComponent* terrain){
 	if (mesh.loaded && mesh.castShadows){
 
-		if (mesh.worldAABB != AABB::ZERO && !isInsideCamera(cameraFar, frustumPlanes, mesh.worldAABB)) {
-			return false;
-		}
-
 		for (int i = 0; i < mesh.numSubmeshes; i++){
 			ObjectRender& depthRender = mesh.submeshes[i].depthRender;
 
@@ -1075,6 +1218,9 @@ void RenderSystem::destroyMesh(Entity entity, MeshComponent& mesh){
 	if (!mesh.loaded)
 		return;
 
+	needUpdateRenderQueue = true;
+	meshContentHashes.erase(entity);
+
 	for (int i = 0; i < mesh.numSubmeshes; i++){
 
 		Submesh& submesh = mesh.submeshes[i];
@@ -1245,16 +1391,16 @@ bool RenderSystem::drawUI(UIComponent& uirender, Transform& transform, bool rend
 		}
 
 		if (uirender.needUpdateBuffer){
-			uirender.buffer.getRender()->updateBuffer(uirender.buffer.getSize(), uirender.buffer.getData());
+			bool updated = uirender.buffer.updateRender(uirender.buffer.getSize());
 
 			if (uirender.indices.getCount() > 0){
-				uirender.indices.getRender()->updateBuffer(uirender.indices.getSize(), uirender.indices.getData());
+				updated = uirender.indices.updateRender(uirender.indices.getSize()) && updated;
 				uirender.vertexCount = uirender.indices.getCount();
 			}else{
 				uirender.vertexCount = uirender.buffer.getCount();
 			}
 
-			uirender.needUpdateBuffer = false;
+			uirender.needUpdateBuffer = !updated;
 		}
 
 		ObjectRender& render = uirender.render;
@@ -1447,8 +1593,7 @@ bool RenderSystem::drawPoints(PointsComponent& points, Transform& transform, Tra
 		}
 
 		if (points.needUpdateBuffer){
-			points.buffer.getRender()->updateBuffer(points.buffer.getSize(), points.buffer.getData());
-			points.needUpdateBuffer = false;
+			points.needUpdateBuffer = !points.buffer.updateRender(points.buffer.getSize());
 		}
 
 		ObjectRender& render = points.render;
@@ -1492,8 +1637,7 @@ bool RenderSystem::drawLines(LinesComponent& lines, Transform& transform, Transf
 	if (lines.loaded && lines.buffer.getSize() > 0){
 
 		if (lines.needUpdateBuffer){
-			lines.buffer.getRender()->updateBuffer(lines.buffer.getSize(), lines.buffer.getData());
-			lines.needUpdateBuffer = false;
+			lines.needUpdateBuffer = !lines.buffer.updateRender(lines.buffer.getSize());
 		}
 
 		ObjectRender& render = lines.render;
@@ -1752,20 +1896,27 @@ Rect RenderSystem::getScissorRect(UILayoutComponent& layout, ImageComponent& img
 }
 
 void RenderSystem::updateTransform(Transform& transform){
+	Transform* transformParent = NULL;
+	if (transform.parent != NULL_ENTITY){
+		transformParent = &scene->getComponent<Transform>(transform.parent);
+	}
+
+	updateTransform(transform, transformParent);
+}
+
+void RenderSystem::updateTransform(Transform& transform, Transform* transformParent){
 	Matrix4 translateMatrix = Matrix4::translateMatrix(transform.position);
 	Matrix4 rotationMatrix = transform.rotation.getRotationMatrix();
 	Matrix4 scaleMatrix = Matrix4::scaleMatrix(transform.scale);
 
 	transform.localMatrix = translateMatrix * rotationMatrix * scaleMatrix;
 
-	if (transform.parent != NULL_ENTITY){
-		Transform& transformParent = scene->getComponent<Transform>(transform.parent);
-
-		transform.modelMatrix = transformParent.modelMatrix * transform.localMatrix;
+	if (transformParent){
+		transform.modelMatrix = transformParent->modelMatrix * transform.localMatrix;
 
-		transform.worldPosition = transformParent.modelMatrix * transform.position;
-		transform.worldScale = transformParent.worldScale * transform.scale;
-		transform.worldRotation = transformParent.worldRotation * transform.rotation;
+		transform.worldPosition = transformParent->modelMatrix * transform.position;
+		transform.worldScale = transformParent->worldScale * transform.scale;
+		transform.worldRotation = transformParent->worldRotation * transform.rotation;
 	}else{
 		transform.modelMatrix = transform.localMatrix;
 
@@ -2389,6 +2540,7 @@ void RenderSystem::changeLoaded(void* data){
 		MeshComponent& mesh = scene->getComponent<MeshComponent>(entity);
 
 		mesh.loaded = true;
+		scene->getSystem<RenderSystem>()->needUpdateRenderQueue = true;
 
 	}else if (signature.test(scene->getComponentId<UIComponent>())){
 		UIComponent& uirender = scene->getComponent<UIComponent>(entity);
@@ -2533,32 +2685,149 @@ void RenderSystem::updateMVP(size_t index, Transform& transform, CameraComponent
 	transform.distanceToCamera = (cameraTransform.worldPosition - transform.worldPosition).length();
 }
 
-void RenderSystem::update(double dt){
-	int numLights = checkLightsAndShadow();
+void RenderSystem::updateTransforms(){
+	// below this amount of dirty transforms threads cost more than they save
+	const size_t parallelMinTransforms = 1024;
+	const size_t noParent = (size_t)-1;
 
 	auto transforms = scene->getComponentArray<Transform>();
-	auto cameras = scene->getComponentArray<CameraComponent>();
+	size_t count = transforms->size();
 
-	for (int i = 0; i < transforms->size(); i++){
+	transformParents.resize(count);
+	dirtyBranches.clear();
+
+	// children always come after their parent, so each root starts a contiguous branch
+	size_t branchStart = 0;
+	bool branchDirty = false;
+	size_t dirtyTransforms = 0;
+	for (size_t i = 0; i < count; i++){
 		Transform& transform = transforms->getComponentFromIndex(i);
 
 		if (transform.parent != NULL_ENTITY){
-			Transform& transformParent = scene->getComponent<Transform>(transform.parent);
-
-			if (transformParent.needUpdate){
-				transform.needUpdate = true;
+			transformParents[i] = transforms->getIndex(transform.parent);
+		}else{
+			transformParents[i] = noParent;
+			if (branchDirty){
+				dirtyBranches.push_back(std::make_pair(branchStart, i));
+				dirtyTransforms += i - branchStart;
 			}
+			branchStart = i;
+			branchDirty = false;
+		}
+
+		if (transform.needUpdate || transform.needUpdateChildVisibility){
+			branchDirty = true;
+		}
+	}
+	if (branchDirty){
+		dirtyBranches.push_back(std::make_pair(branchStart, count));
+		dirtyTransforms += count - branchStart;
+	}
+
+	auto updateBranches = [&](size_t begin, size_t end){
+		for (size_t b = begin; b < end; b++){
+			for (size_t i = dirtyBranches[b].first; i < dirtyBranches[b].second; i++){
+				Transform& transform = transforms->getComponentFromIndex(i);
+				Transform* transformParent = NULL;
+
+				if (transformParents[i] != noParent){
+					transformParent = &transforms->getComponentFromIndex(transformParents[i]);
+
+					if (transformParent->needUpdate){
+						transform.needUpdate = true;
+					}
+
+					if (transformParent->needUpdateChildVisibility){
+						transform.visible = transformParent->visible;
+						transform.needUpdateChildVisibility = true;
+					}
+				}
 
-			if (transformParent.needUpdateChildVisibility){
-				transform.visible = transformParent.visible;
-				transform.needUpdateChildVisibility = true;
+				if (transform.needUpdate){
+					updateTransform(transform, transformParent);
+				}
 			}
 		}
+	};
+
+	// branches do not share transforms, each one can be updated by a different thread
+	if (dirtyBranches.size() > 1 && dirtyTransforms >= parallelMinTransforms){
+		ThreadPool::instance().parallelFor(dirtyBranches.size(), 1, updateBranches);
+	}else{
+		updateBranches(0, dirtyBranches.size());
+	}
+}
+
+void RenderSystem::updateSkinning(){
+	// below this amount of bones threads cost more than they save
+	const size_t parallelMinBones = 1024;
+
+	auto transforms = scene->getComponentArray<Transform>();
+	const uint64_t transformsVersion = transforms->getVersion();
+
+	skinnedModels.clear();
+	skippedSkinnings = 0;
 
+	size_t totalBones = 0;
+	for (auto [entity, transform, model, mesh] : scene->view<Transform, ModelComponent, MeshComponent>()){
+		// models before bones, skinning uses inverseDerivedTransform
 		if (transform.needUpdate){
-			updateTransform(transform);
+			model.inverseDerivedTransform = transform.modelMatrix.inverse();
+		}
+
+		// bones of offscreen models are not animated, palette is rebuilt when visible again
+		if (!model.bones.empty() && model.animationOffscreen){
+			model.needUpdateSkinning = true;
+			skippedSkinnings++;
+		}else if (!model.bones.empty()){
+			skinnedModels.push_back(std::make_pair(&model, &mesh));
+			totalBones += model.bones.size();
+		}
+	}
+
+	// each skeleton writes only its own palette
+	auto updatePalettes = [&](size_t begin, size_t end){
+		for (size_t m = begin; m < end; m++){
+			ModelComponent& model = *skinnedModels[m].first;
+			MeshComponent& mesh = *skinnedModels[m].second;
+
+			// transforms are reordered by hierarchy, indexes are found again only when that array changes
+			if (model.bonesTransformIndex.size() != model.bones.size() || model.bonesTransformVersion != transformsVersion){
+				model.bonesTransformIndex.resize(model.bones.size());
+				for (size_t b = 0; b < model.bones.size(); b++){
+					model.bonesTransformIndex[b] = (transforms->contains(model.bones[b])) ? transforms->getIndex(model.bones[b]) : SIZE_MAX;
+				}
+				model.bonesTransformVersion = transformsVersion;
+			}
+
+			size_t numBones = std::min(model.bones.size(), model.bonesOffsetMatrix.size());
+			for (size_t b = 0; b < numBones; b++){
+				Transform* transform = transforms->findComponentFromIndex(model.bonesTransformIndex[b]);
+				if (!transform || (!transform->needUpdate && !model.needUpdateSkinning)){
+					continue;
+				}
+
+				mesh.bonesMatrix[b] = model.inverseDerivedTransform * transform->modelMatrix * model.bonesOffsetMatrix[b];
+			}
+
+			model.needUpdateSkinning = false;
 		}
+	};
+
+	if (skinnedModels.size() > 1 && totalBones >= parallelMinBones){
+		ThreadPool::instance().parallelFor(skinnedModels.size(), 1, updatePalettes);
+	}else{
+		updatePalettes(0, skinnedModels.size());
 	}
+}
+
+void RenderSystem::update(double dt){
+	int numLights = checkLightsAndShadow();
+
+	auto transforms = scene->getComponentArray<Transform>();
+	auto cameras = scene->getComponentArray<CameraComponent>();
+
+	updateTransforms();
 
 	Entity mainCameraEntity = scene->getCamera();
 	uint8_t pipelines = 0;
@@ -2592,6 +2861,8 @@ void RenderSystem::update(double dt){
 	CameraComponent& mainCamera =  scene->getComponent<CameraComponent>(mainCameraEntity);
 	Transform& mainCameraTransform =  scene->getComponent<Transform>(mainCameraEntity);
 
+	meshPipelines = pipelines;
+
 	loadLights(numLights);
 	loadAndProcessFog();
 
@@ -2613,150 +2884,147 @@ void RenderSystem::update(double dt){
 		}
 	}
 
-	for (int i = 0; i < transforms->size(); i++){
-		Transform& transform = transforms->getComponentFromIndex(i);
-
-		Entity entity = transforms->getEntity(i);
-		Signature signature = scene->getSignature(entity);
-
-		if (signature.test(scene->getComponentId<MeshComponent>())){
-			MeshComponent& mesh = scene->getComponent<MeshComponent>(entity);
+	auto instmeshes = scene->getComponentArray<InstancedMeshComponent>();
+	auto terrains = scene->getComponentArray<TerrainComponent>();
+	auto texts = scene->getComponentArray<TextComponent>();
 
-			TerrainComponent* terrain = scene->findComponent<TerrainComponent>(entity);
+	for (auto [entity, transform, mesh] : scene->view<Transform, MeshComponent>()){
+		TerrainComponent* terrain = terrains->findComponent(entity);
 
-			InstancedMeshComponent* instmesh = scene->findComponent<InstancedMeshComponent>(entity);
-			if (instmesh){
-				bool sortTransparentInstances = mesh.transparent && mainCamera.type != CameraType::CAMERA_2D;
+		InstancedMeshComponent* instmesh = instmeshes->findComponent(entity);
+		if (instmesh){
+			bool sortTransparentInstances = mesh.transparent && mainCamera.type != CameraType::CAMERA_2D;
 
-				if (instmesh->needUpdateInstances && !instmesh->instancedBillboard){
-					updateInstancedMesh(*instmesh, mesh, transform, mainCamera, mainCameraTransform);
-				}
+			if (instmesh->needUpdateInstances && !instmesh->instancedBillboard){
+				updateInstancedMesh(*instmesh, mesh, transform, mainCamera, mainCameraTransform);
+			}
 
-				if (instmesh->needUpdateInstances || ((mainCamera.needUpdate || transform.needUpdate) && sortTransparentInstances)){
-					if (!hasMultipleCameras || !sortTransparentInstances){
-						if (instmesh->instancedBillboard){
-							updateInstancedMesh(*instmesh, mesh, transform, mainCamera, mainCameraTransform);
-						}
-						sortInstancedMesh(*instmesh, mesh, transform, mainCamera, mainCameraTransform);
+			if (instmesh->needUpdateInstances || ((mainCamera.needUpdate || transform.needUpdate) && sortTransparentInstances)){
+				if (!hasMultipleCameras || !sortTransparentInstances){
+					if (instmesh->instancedBillboard){
+						updateInstancedMesh(*instmesh, mesh, transform, mainCamera, mainCameraTransform);
 					}
+					sortInstancedMesh(*instmesh, mesh, transform, mainCamera, mainCameraTransform);
 				}
-
-				instmesh->needUpdateInstances = false;
-			}
-			if (mesh.loaded && mesh.needReload){
-				destroyMesh(entity, mesh);
-			}
-			if (!mesh.loadCalled){
-				loadMesh(entity, mesh, pipelines, instmesh, terrain);
-			}
-		}else if (signature.test(scene->getComponentId<UIComponent>())){
-			UIComponent& ui = scene->getComponent<UIComponent>(entity);
-			if (!ui.loaded){
-				bool isText = false;
-				if (signature.test(scene->getComponentId<TextComponent>())){
-					isText = true;
-				}
-				if (ui.loaded && ui.needReload){
-					destroyUI(entity, ui);
-				}
-				if (!ui.loadCalled){
-					loadUI(entity, ui, pipelines, isText);
-				}
-			}
-		}else if (signature.test(scene->getComponentId<PointsComponent>())){
-			PointsComponent& points = scene->getComponent<PointsComponent>(entity);
-			if (points.loaded && points.needReload){
-				destroyPoints(entity, points);
-			}
-			if (!points.loadCalled){
-				loadPoints(entity, points, pipelines);
-			}
-		}else if (signature.test(scene->getComponentId<LinesComponent>())){
-			LinesComponent& lines = scene->getComponent<LinesComponent>(entity);
-			if (lines.loaded && lines.needReload){
-				destroyLines(entity, lines);
 			}
-			if (!lines.loadCalled){
-				loadLines(entity, lines, pipelines);
-			}
-		}
 
-		if (mainCamera.needUpdate || transform.needUpdate){
-
-			// need to be updated for every camera
-			if (!hasMultipleCameras){
-				updateMVP(i, transform, mainCamera, mainCameraTransform);
+			instmesh->needUpdateInstances = false;
 
-				if (signature.test(scene->getComponentId<TerrainComponent>())){
-					TerrainComponent& terrain = scene->getComponent<TerrainComponent>(entity);
+			updateMeshSpatial(entity, mesh);
 
-					updateTerrain(terrain, transform, mainCamera, mainCameraTransform);
-				}
+			if (mesh.castShadows){
+				movedCasters.push_back(entity);
 			}
+		}
+		if (mesh.loaded && mesh.needReload){
+			destroyMesh(entity, mesh);
+		}
+		if (!mesh.loadCalled){
+			loadMesh(entity, mesh, pipelines, instmesh, terrain);
+		}
+	}
 
-			// need to be updated ONLY for main camera
-			if (signature.test(scene->getComponentId<LightComponent>())){
-				LightComponent& light = scene->getComponent<LightComponent>(entity);
-				
-				updateLightFromScene(light, transform, mainCamera);
+	for (auto [entity, transform, ui] : scene->view<Transform, UIComponent>()){
+		if (!ui.loaded){
+			bool isText = texts->contains(entity);
+			if (ui.loaded && ui.needReload){
+				destroyUI(entity, ui);
 			}
-			
-			if (signature.test(scene->getComponentId<AudioComponent>())){
-				AudioComponent& audio = scene->getComponent<AudioComponent>(entity);
-
-				audio.needUpdate = true;
+			if (!ui.loadCalled){
+				loadUI(entity, ui, pipelines, isText);
 			}
+		}
+	}
 
+	for (auto [entity, transform, points] : scene->view<Transform, PointsComponent>()){
+		if (points.loaded && points.needReload){
+			destroyPoints(entity, points);
+		}
+		if (!points.loadCalled){
+			loadPoints(entity, points, pipelines);
 		}
+	}
 
-		if (transform.needUpdate){
+	for (auto [entity, transform, lines] : scene->view<Transform, LinesComponent>()){
+		if (lines.loaded && lines.needReload){
+			destroyLines(entity, lines);
+		}
+		if (!lines.loadCalled){
+			loadLines(entity, lines, pipelines);
+		}
+	}
 
-			if (signature.test(scene->getComponentId<MeshComponent>())){
-				MeshComponent& mesh = scene->getComponent<MeshComponent>(entity);
+	// billboards can change transforms, so MVP is updated before other transform dependents
+	if (!hasMultipleCameras){
+		for (int i = 0; i < transforms->size(); i++){
+			Transform& transform = transforms->getComponentFromIndex(i);
 
-				mesh.worldAABB = transform.modelMatrix * mesh.aabb;
+			if (mainCamera.needUpdate || transform.needUpdate){
+				updateMVP(i, transform, mainCamera, mainCameraTransform);
 			}
+		}
 
-			if (signature.test(scene->getComponentId<ModelComponent>())){
-				ModelComponent& model = scene->getComponent<ModelComponent>(entity);
-
-				model.inverseDerivedTransform = transform.modelMatrix.inverse();
+		for (auto [entity, transform, terrain] : scene->view<Transform, TerrainComponent>()){
+			if (mainCamera.needUpdate || transform.needUpdate){
+				updateTerrain(terrain, transform, mainCamera, mainCameraTransform);
 			}
+		}
+	}
 
-			if (signature.test(scene->getComponentId<BoneComponent>())){
-				BoneComponent& bone = scene->getComponent<BoneComponent>(entity);
+	// need to be updated ONLY for main camera
+	for (auto [entity, transform, light] : scene->view<Transform, LightComponent>()){
+		if (mainCamera.needUpdate || transform.needUpdate){
+			updateLightFromScene(light, transform, mainCamera);
+		}
+	}
 
-				if (bone.model != NULL_ENTITY){
-					ModelComponent& model = scene->getComponent<ModelComponent>(bone.model);
-					MeshComponent& mesh = scene->getComponent<MeshComponent>(bone.model);
+	for (auto [entity, transform, audio] : scene->view<Transform, AudioComponent>()){
+		if (mainCamera.needUpdate || transform.needUpdate){
+			audio.needUpdate = true;
+		}
+	}
 
-					Matrix4 skinning = model.inverseDerivedTransform * transform.modelMatrix * bone.offsetMatrix;
+	syncMeshSpatial();
 
-					if (bone.index >= 0 && bone.index < MAX_BONES)
-						mesh.bonesMatrix[bone.index] = skinning;
-				}
+	for (auto [entity, transform, mesh] : scene->view<Transform, MeshComponent>()){
+		if (transform.needUpdate){
+			mesh.worldAABB = transform.modelMatrix * mesh.aabb;
+			updateMeshSpatial(entity, mesh);
+
+			if (mesh.castShadows){
+				movedCasters.push_back(entity);
 			}
 
+			if (!needUpdateInstanceGroups && !instanceGroups.empty()){
+				auto it = meshSpatial.find(entity);
+				if (it != meshSpatial.end() && it->second.queueIndex < renderQueue.size() && renderQueue[it->second.queueIndex].instanceKey != 0){
+					needUpdateInstanceGroups = true;
+				}
+			}
 		}
+	}
 
-        if (signature.test(scene->getComponentId<PointsComponent>())){
-			PointsComponent& points = scene->getComponent<PointsComponent>(entity);
+	updateSkinning();
 
-			bool sortTransparentPoints = points.transparent && mainCamera.type != CameraType::CAMERA_2D;
+	for (auto [entity, transform, points] : scene->view<Transform, PointsComponent>()){
+		bool sortTransparentPoints = points.transparent && mainCamera.type != CameraType::CAMERA_2D;
 
-			if (points.needUpdate){
-				updatePoints(points, transform, mainCamera, mainCameraTransform);
-			}
+		if (points.needUpdate){
+			updatePoints(points, transform, mainCamera, mainCameraTransform);
+		}
 
-			if (points.needUpdate || ((mainCamera.needUpdate || transform.needUpdate) && sortTransparentPoints)){
-				if (!hasMultipleCameras || !sortTransparentPoints){
-					sortPoints(points, transform, mainCamera, mainCameraTransform);
-				}
+		if (points.needUpdate || ((mainCamera.needUpdate || transform.needUpdate) && sortTransparentPoints)){
+			if (!hasMultipleCameras || !sortTransparentPoints){
+				sortPoints(points, transform, mainCamera, mainCameraTransform);
 			}
-
-			points.needUpdate = false;
 		}
 
+		points.needUpdate = false;
+	}
+
+	for (int i = 0; i < transforms->size(); i++){
+		Transform& transform = transforms->getComponentFromIndex(i);
+
 		transform.needUpdateChildVisibility = false;
 		transform.needUpdate = false;
 	}
@@ -2768,102 +3036,1473 @@ void RenderSystem::update(double dt){
 		}
 	}
 
-	processLights(mainCameraTransform);
+	processLights(mainCamera, mainCameraTransform);
 }
 
-void RenderSystem::draw(){
-	std::priority_queue<TransparentMeshesData, std::vector<TransparentMeshesData>, MeshComparison> transparentMeshes;
-
+void RenderSystem::updateRenderQueue(){
 	auto transforms = scene->getComponentArray<Transform>();
-	auto cameras = scene->getComponentArray<CameraComponent>();
-
-	//---------Depth shader----------
-	if (hasShadows){
-		auto lights = scene->getComponentArray<LightComponent>();
-		auto meshes = scene->getComponentArray<MeshComponent>();
-		auto terrains = scene->getComponentArray<TerrainComponent>();
-		
-		for (int l = 0; l < lights->size(); l++){
-			LightComponent& light = lights->getComponentFromIndex(l);
+	auto meshes = scene->getComponentArray<MeshComponent>();
+	auto instmeshes = scene->getComponentArray<InstancedMeshComponent>();
+	auto terrains = scene->getComponentArray<TerrainComponent>();
 
-			if (light.intensity > 0 && light.shadows){
-				size_t cameras = 1;
-				if (light.type == LightType::POINT){
-					cameras = 6;
-				}else if (light.type == LightType::DIRECTIONAL){
-					cameras = light.numShadowCascades;
-				}
+	uint64_t versions[4] = {transforms->getVersion(), meshes->getVersion(), instmeshes->getVersion(), terrains->getVersion()};
 
-				for (int c = 0; c < cameras; c++){
-					size_t face = 0;
-					size_t fb = c;
-					if (light.type == LightType::POINT){
-						face = c;
-						fb = 0;
-					}
-					light.cameras[c].render.setClearColor(Vector4(1.0, 1.0, 1.0, 1.0));
+	if (!needUpdateRenderQueue && std::equal(versions, versions + 4, renderQueueVersions)){
+		return;
+	}
 
-					light.cameras[c].render.startRenderPass(&light.framebuffer[fb], face);
-					for (int i = 0; i < meshes->size(); i++){
-						MeshComponent& mesh = meshes->getComponentFromIndex(i);
-						Entity entity = meshes->getEntity(i);
-						Transform* transform = scene->findComponent<Transform>(entity);
+	std::copy(versions, versions + 4, renderQueueVersions);
+	needUpdateRenderQueue = false;
+	renderQueueRevision++;
+
+	renderQueue.clear();
+	for (auto [entity, mesh, transform] : scene->view<MeshComponent, Transform>()){
+		// pipeline (22 bits) and first texture (16 bits) of the first submesh
+		uint64_t stateKey = 0;
+		if (mesh.numSubmeshes > 0){
+			ObjectRender& render = mesh.submeshes[0].render;
+			stateKey = ((uint64_t)(render.getPipelineId(PipelineType::PIP_DEFAULT) & 0x3FFFFF) << 16) | (render.getTextureId() & 0xFFFF);
+		}
 
-						if (transform){
-							if (transform->visible){
-								InstancedMeshComponent* instmesh = scene->findComponent<InstancedMeshComponent>(entity);
-								TerrainComponent* terrain = scene->findComponent<TerrainComponent>(entity);
+		auto it = meshSpatial.find(entity);
+		if (it != meshSpatial.end()){
+			it->second.queueIndex = (uint32_t)renderQueue.size();
+			if (it->second.proxy != AABBTree::NULL_NODE){
+				meshTree.setData(it->second.proxy, it->second.queueIndex);
+			}
+		}
 
-								vs_depth_t vsDepthParams;
+		InstancedMeshComponent* instmesh = instmeshes->findComponent(entity);
+		TerrainComponent* terrain = terrains->findComponent(entity);
 
-								if (transform->billboard && mesh.enableShadowsBillboard){
-									Matrix4 modelViewMatrix = light.cameras[c].lightViewMatrix * transform->modelMatrix;
+		uint64_t instanceKey = 0;
+		uint64_t materialKey = 0;
+		if (Engine::isAutomaticInstancing()){
+			instanceKey = getMeshInstanceKey(entity, mesh, transform, instmesh, terrain);
+			if (instanceKey != 0){
+				materialKey = getMeshMaterialKey(mesh);
+			}
+		}
 
-									modelViewMatrix.set(0, 0, transform->worldScale.x);
-									modelViewMatrix.set(0, 1, 0.0);
-									modelViewMatrix.set(0, 2, 0.0);
+		renderQueue.push_back({stateKey, &mesh, instmesh, terrain, &transform, instanceKey, materialKey, nullptr});
+	}
 
-									if (!transform->cylindricalBillboard) {
-										modelViewMatrix.set(1, 0, 0.0);
-										modelViewMatrix.set(1, 1, transform->worldScale.y);
-										modelViewMatrix.set(1, 2, 0.0);
-									}
+	needUpdateInstanceGroups = true;
+}
 
-									modelViewMatrix.set(2, 0, 0.0);
-									modelViewMatrix.set(2, 1, 0.0);
-									modelViewMatrix.set(2, 2, transform->worldScale.z);
+uint64_t RenderSystem::getMeshInstanceKey(Entity entity, MeshComponent& mesh, Transform& transform, InstancedMeshComponent* instmesh, TerrainComponent* terrain){
+	if (!mesh.loaded || instmesh || terrain || mesh.transparent || mesh.numSubmeshes == 0){
+		return 0;
+	}
+	if (transform.billboard || transform.fakeBillboard){
+		return 0;
+	}
 
-									vsDepthParams = {modelViewMatrix, light.cameras[c].lightProjectionMatrix};
-								}else{
-									vsDepthParams = {transform->modelMatrix, light.cameras[c].lightViewProjectionMatrix};
-								}
+	auto combine = [](uint64_t hash, uint64_t value){
+		return (hash ^ value) * 1099511628211ull;
+	};
 
-								drawMeshDepth(mesh, light.cameras[c].nearFar.y, light.cameras[c].frustumPlanes, vsDepthParams, instmesh, terrain);
-							}
-						}
-					}
+	// vertex data is hashed once per loaded mesh, only immutable buffers are compared
+	auto it = meshContentHashes.find(entity);
+	if (it == meshContentHashes.end()){
+		uint64_t contentHash = 14695981039346656037ull;
 
-					light.cameras[c].render.endRenderPass();
-				}
+		std::vector<Buffer*> buffers = {&mesh.buffer, &mesh.indices};
+		for (int i = 0; i < mesh.numExternalBuffers; i++){
+			buffers.push_back(&mesh.eBuffers[i]);
+		}
+		for (Buffer* buffer : buffers){
+			if (buffer->getSize() == 0){
+				continue;
+			}
+			if (buffer->getUsage() != BufferUsage::IMMUTABLE || !buffer->getData()){
+				contentHash = 0;
+				break;
+			}
+			contentHash = combine(contentHash, ObjectRender::getUniformHash(buffer->getData(), buffer->getSize()));
+			for (auto const& attr : buffer->getAttributes()){
+				contentHash = combine(contentHash, (uint64_t)attr.first);
+				contentHash = combine(contentHash, attr.second.getOffset());
+				contentHash = combine(contentHash, attr.second.getElements());
+				contentHash = combine(contentHash, (uint64_t)attr.second.getDataType());
 			}
 		}
+
+		it = meshContentHashes.emplace(entity, contentHash).first;
 	}
 
-	for (int i = 0; i < cameras->size(); i++){
-		Entity cameraEntity = cameras->getEntity(i);
-		CameraComponent& camera = cameras->getComponentFromIndex(i);
-		Transform& cameraTransform = scene->getComponent<Transform>(cameraEntity);
+	if (it->second == 0){
+		return 0;
+	}
 
-		bool isMainCamera = (cameraEntity == scene->getCamera());
+	uint64_t key = combine(it->second, mesh.numSubmeshes);
+	key = combine(key, (uint64_t)mesh.cullingMode);
+	key = combine(key, (uint64_t)mesh.windingOrder);
+	key = combine(key, mesh.castShadows);
+	key = combine(key, mesh.receiveShadows);
 
-		if (!isMainCamera && !camera.renderToTexture){
-			continue; // camera is not used
+	for (int i = 0; i < mesh.numSubmeshes; i++){
+		Submesh& submesh = mesh.submeshes[i];
+
+		if (submesh.hasSkinning || submesh.hasMorphTarget || submesh.hasTextureRect){
+			return 0;
 		}
 
-		if (Engine::getMainScene() == scene || camera.renderToTexture){
-			camera.render.setClearColor(scene->getBackgroundColor());
+		for (auto const& attr : submesh.attributes){
+			key = combine(key, (uint64_t)attr.first);
+			key = combine(key, std::hash<std::string>()(attr.second.getBuffer()));
+			key = combine(key, attr.second.getOffset());
+			key = combine(key, attr.second.getCount());
 		}
-		
+
+		key = combine(key, std::hash<std::string>()(submesh.shaderProperties));
+		key = combine(key, submesh.vertexCount);
+		key = combine(key, (uint64_t)submesh.primitiveType);
+		key = combine(key, submesh.enableFaceCulling);
+	}
+
+	return (key != 0) ? key : 1;
+}
+
+uint64_t RenderSystem::getMeshMaterialKey(MeshComponent& mesh){
+	uint64_t key = 14695981039346656037ull;
+
+	for (int i = 0; i < mesh.numSubmeshes; i++){
+		const Material& material = mesh.submeshes[i].material;
+		float factors[10] = {material.baseColorFactor.x, material.baseColorFactor.y, material.baseColorFactor.z, material.baseColorFactor.w,
+							material.metallicFactor, material.roughnessFactor,
+							material.emissiveFactor.x, material.emissiveFactor.y, material.emissiveFactor.z, 0};
+
+		key = (key ^ ObjectRender::getUniformHash(factors, sizeof(factors))) * 1099511628211ull;
+		key = (key ^ mesh.submeshes[i].render.getTexturesHash()) * 1099511628211ull;
+	}
+
+	return key;
+}
+
+bool RenderSystem::hasMeshTextureUpdate(MeshComponent& mesh){
+	for (int i = 0; i < mesh.numSubmeshes; i++){
+		if (mesh.submeshes[i].needUpdateTexture){
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void RenderSystem::updateInstanceGroups(){
+	const size_t instancingMinMeshes = 8;
+
+	if (!Engine::isAutomaticInstancing()){
+		for (auto& [key, group] : instanceGroups){
+			destroyInstanceGroup(group);
+		}
+		instanceGroups.clear();
+		return;
+	}
+
+	if (instanceVisible.size() != renderQueue.size()){
+		instanceVisible.assign(renderQueue.size(), false);
+		needUpdateInstanceGroups = true;
+	}
+	for (size_t i = 0; i < renderQueue.size(); i++){
+		RenderQueueItem& item = renderQueue[i];
+		if (item.instanceKey == 0){
+			continue;
+		}
+
+		if (instanceVisible[i] != item.transform->visible){
+			needUpdateInstanceGroups = true;
+		}
+
+		// groups draw a copy of first member material, so any member change regroups
+		uint64_t materialKey = getMeshMaterialKey(*item.mesh);
+		if (materialKey != item.materialKey){
+			item.materialKey = materialKey;
+			needUpdateInstanceGroups = true;
+		}
+
+		if (item.instanceGroup && hasMeshTextureUpdate(*item.mesh)){
+			needUpdateInstanceGroups = true;
+		}
+	}
+
+	if (!needUpdateInstanceGroups){
+		return;
+	}
+	needUpdateInstanceGroups = false;
+
+	for (auto& [key, group] : instanceGroups){
+		group.members.clear();
+	}
+
+	for (uint32_t i = 0; i < renderQueue.size(); i++){
+		RenderQueueItem& item = renderQueue[i];
+
+		item.instanceGroup = nullptr;
+		instanceVisible[i] = item.transform->visible;
+
+		// textures are loaded when drawn alone, then material key changes and mesh is grouped again
+		if (item.instanceKey == 0 || !item.transform->visible || hasMeshTextureUpdate(*item.mesh)){
+			continue;
+		}
+
+		// members share rotation and scale, instances only carry world positions
+		const Matrix4& m = item.transform->modelMatrix;
+		float basis[9] = {m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2]};
+		uint64_t key = (item.instanceKey ^ item.materialKey) * 1099511628211ull;
+		key = (key ^ ObjectRender::getUniformHash(basis, sizeof(basis))) * 1099511628211ull;
+
+		InstanceGroup& group = instanceGroups[key];
+		group.members.push_back(i);
+	}
+
+	for (auto it = instanceGroups.begin(); it != instanceGroups.end();){
+		InstanceGroup& group = it->second;
+
+		if (group.members.size() < instancingMinMeshes){
+			destroyInstanceGroup(group);
+			it = instanceGroups.erase(it);
+			continue;
+		}
+
+		Transform& firstTransform = *renderQueue[group.members[0]].transform;
+
+		if (group.mesh.loaded && group.instmesh.maxInstances < group.members.size()){
+			destroyInstanceGroup(group);
+		}
+
+		if (!group.mesh.loaded){
+			group.mesh = *renderQueue[group.members[0]].mesh;
+			group.mesh.loaded = false;
+			group.mesh.loadCalled = false;
+			group.mesh.needReload = false;
+			for (int s = 0; s < group.mesh.numSubmeshes; s++){
+				group.mesh.submeshes[s].render = ObjectRender();
+				group.mesh.submeshes[s].depthRender = ObjectRender();
+				group.mesh.submeshes[s].shader.reset();
+				group.mesh.submeshes[s].depthShader.reset();
+			}
+
+			group.instmesh = InstancedMeshComponent();
+			group.instmesh.buffer.addAttribute(AttributeType::INSTANCEMATRIXCOL1, 4, 0, true);
+			group.instmesh.buffer.addAttribute(AttributeType::INSTANCEMATRIXCOL2, 4, 4 * sizeof(float), true);
+			group.instmesh.buffer.addAttribute(AttributeType::INSTANCEMATRIXCOL3, 4, 8 * sizeof(float), true);
+			group.instmesh.buffer.addAttribute(AttributeType::INSTANCEMATRIXCOL4, 4, 12 * sizeof(float), true);
+			group.instmesh.buffer.addAttribute(AttributeType::INSTANCECOLOR, 4, 16 * sizeof(float), true);
+			group.instmesh.buffer.addAttribute(AttributeType::INSTANCETEXTURERECT, 4, 20 * sizeof(float), true);
+			group.instmesh.buffer.setStride(24 * sizeof(float));
+			group.instmesh.buffer.setRenderAttributes(true);
+			group.instmesh.buffer.setInstanceBuffer(true);
+			group.instmesh.buffer.setUsage(BufferUsage::DYNAMIC);
+			group.instmesh.maxInstances = instancingMinMeshes;
+			while (group.instmesh.maxInstances < group.members.size()){
+				group.instmesh.maxInstances *= 2;
+			}
+
+			if (loadMesh(NULL_ENTITY, group.mesh, meshPipelines, &group.instmesh, nullptr)){
+				group.mesh.loaded = true;
+			}else{
+				// members are drawn one by one until next grouping
+				destroyInstanceGroup(group);
+				++it;
+				continue;
+			}
+		}
+
+		group.transform.modelMatrix = firstTransform.modelMatrix;
+		group.transform.modelMatrix.set(3, 0, 0.0);
+		group.transform.modelMatrix.set(3, 1, 0.0);
+		group.transform.modelMatrix.set(3, 2, 0.0);
+		group.transform.normalMatrix = firstTransform.normalMatrix;
+		group.inverseBase = group.transform.modelMatrix.inverse();
+
+		group.instmesh.renderInstances.resize(group.members.size());
+		group.mesh.worldAABB = AABB();
+		for (size_t m = 0; m < group.members.size(); m++){
+			RenderQueueItem& item = renderQueue[group.members[m]];
+
+			group.instmesh.renderInstances[m].instanceMatrix = group.inverseBase * item.transform->modelMatrix;
+			group.instmesh.renderInstances[m].color = Vector4(1.0, 1.0, 1.0, 1.0);
+			group.instmesh.renderInstances[m].textureRect = Rect(0.0, 0.0, 1.0, 1.0);
+			group.mesh.worldAABB.merge(item.mesh->worldAABB);
+
+			item.instanceGroup = &group;
+		}
+		group.instmesh.numVisible = (unsigned int)group.members.size();
+
+		group.instmesh.buffer.setData((unsigned char*)(&group.instmesh.renderInstances.at(0)), sizeof(InstanceRenderData) * group.instmesh.numVisible);
+		group.instmesh.needUpdateBuffer = !group.instmesh.buffer.updateRender(group.instmesh.buffer.getSize());
+
+		++it;
+	}
+}
+
+void RenderSystem::destroyInstanceGroup(InstanceGroup& group){
+	if (!group.mesh.loadCalled){
+		return;
+	}
+
+	destroyMeshCopy(group.mesh);
+	group.instmesh.buffer.getRender()->destroyBuffer();
+
+	group.mesh = MeshComponent();
+	group.instmesh = InstancedMeshComponent();
+}
+
+void RenderSystem::destroyMeshCopy(MeshComponent& mesh){
+	for (int i = 0; i < mesh.numSubmeshes; i++){
+		Submesh& submesh = mesh.submeshes[i];
+
+		submesh.shader.reset();
+		if (!submesh.shaderProperties.empty())
+			ShaderPool::remove(ShaderType::MESH, submesh.shaderProperties);
+		if (submesh.depthShader){
+			submesh.depthShader.reset();
+			ShaderPool::remove(ShaderType::DEPTH, submesh.depthShaderProperties);
+		}
+
+		submesh.material.baseColorTexture.destroy();
+		submesh.material.metallicRoughnessTexture.destroy();
+		submesh.material.normalTexture.destroy();
+		submesh.material.occlusionTexture.destroy();
+		submesh.material.emissiveTexture.destroy();
+
+		submesh.render.destroy();
+		submesh.depthRender.destroy();
+	}
+
+	mesh.buffer.getRender()->destroyBuffer();
+	mesh.indices.getRender()->destroyBuffer();
+	for (int i = 0; i < mesh.numExternalBuffers; i++){
+		mesh.eBuffers[i].getRender()->destroyBuffer();
+	}
+}
+
+bool RenderSystem::drawInstanceGroup(InstanceGroup& group, CameraComponent& camera, Transform& cameraTransform, bool renderToTexture){
+	group.transform.modelViewProjectionMatrix = camera.viewProjectionMatrix * group.transform.modelMatrix;
+
+	return drawMesh(group.mesh, group.transform, camera, cameraTransform, renderToTexture, &group.instmesh, nullptr);
+}
+
+uint64_t RenderSystem::getSpriteBatchKey(MeshComponent& mesh, Transform& transform){
+	if (!mesh.loaded || mesh.needReload || mesh.numSubmeshes != 1 || mesh.numExternalBuffers > 0 || transform.billboard){
+		return 0;
+	}
+
+	Submesh& submesh = mesh.submeshes[0];
+	if (submesh.primitiveType != PrimitiveType::TRIANGLES || submesh.hasSkinning || submesh.hasMorphTarget || submesh.needUpdateTexture || !submesh.attributes.empty()){
+		return 0;
+	}
+	if (!mesh.buffer.isRenderAttributes() || mesh.buffer.getCount() == 0){
+		return 0;
+	}
+
+	auto combine = [](uint64_t hash, uint64_t value){
+		return (hash ^ value) * 1099511628211ull;
+	};
+
+	uint64_t key = 14695981039346656037ull;
+
+	bool bakeColor = false;
+	for (auto const& attr : mesh.buffer.getAttributes()){
+		// batch vertices are written per attribute, other data cannot be transformed
+		if (attr.second.getDataType() != AttributeDataType::FLOAT){
+			return 0;
+		}
+		if (attr.first == AttributeType::COLOR){
+			bakeColor = (attr.second.getElements() == 4);
+		}else if (attr.first != AttributeType::POSITION && attr.first != AttributeType::TEXCOORD1 && attr.first != AttributeType::NORMAL){
+			return 0;
+		}
+		key = combine(key, (uint64_t)attr.first);
+		key = combine(key, attr.second.getElements());
+	}
+
+	const Material& material = submesh.material;
+	float factors[10] = {1.0, 1.0, 1.0, 1.0,
+						material.metallicFactor, material.roughnessFactor,
+						material.emissiveFactor.x, material.emissiveFactor.y, material.emissiveFactor.z, 0};
+	if (!bakeColor){
+		factors[0] = material.baseColorFactor.x;
+		factors[1] = material.baseColorFactor.y;
+		factors[2] = material.baseColorFactor.z;
+		factors[3] = material.baseColorFactor.w;
+	}
+
+	key = combine(key, std::hash<std::string>()(submesh.shaderProperties));
+	key = combine(key, ObjectRender::getUniformHash(factors, sizeof(factors)));
+	key = combine(key, submesh.render.getTexturesHash());
+	key = combine(key, submesh.render.getPipelineId(PIP_DEFAULT));
+	key = combine(key, submesh.enableFaceCulling);
+	key = combine(key, (uint64_t)mesh.cullingMode);
+	key = combine(key, (uint64_t)mesh.windingOrder);
+	key = combine(key, mesh.receiveShadows);
+	key = combine(key, mesh.transparent);
+
+	return (key != 0) ? key : 1;
+}
+
+uint64_t RenderSystem::getUIBatchKey(UIComponent& ui, Transform& transform){
+	if (!ui.loaded || ui.needReload || ui.needUpdateTexture || ui.primitiveType != PrimitiveType::TRIANGLES || ui.buffer.getCount() == 0){
+		return 0;
+	}
+	// billboards rotate for each camera when drawn, batches are baked before
+	if (transform.billboard || ui.texture.isFramebuffer()){
+		return 0;
+	}
+
+	auto combine = [](uint64_t hash, uint64_t value){
+		return (hash ^ value) * 1099511628211ull;
+	};
+
+	uint64_t key = 6605813339339102567ull;
+
+	bool bakeColor = false;
+	for (auto const& attr : ui.buffer.getAttributes()){
+		if (attr.second.getDataType() != AttributeDataType::FLOAT){
+			return 0;
+		}
+		if (attr.first == AttributeType::COLOR){
+			bakeColor = (attr.second.getElements() == 4);
+		}else if (attr.first != AttributeType::POSITION && attr.first != AttributeType::TEXCOORD1){
+			return 0;
+		}
+		key = combine(key, (uint64_t)attr.first);
+		key = combine(key, attr.second.getElements());
+	}
+
+	// text has no vertex color, so its color stays a uniform of the batch
+	if (!bakeColor){
+		key = combine(key, ObjectRender::getUniformHash(&ui.color, sizeof(float) * 4));
+	}
+
+	key = combine(key, std::hash<std::string>()(ui.shaderProperties));
+	key = combine(key, ui.render.getTexturesHash());
+
+	return (key != 0) ? key : 1;
+}
+
+bool RenderSystem::appendBatchVertices(Buffer& buffer, IndexBuffer& indices, Transform& transform, const Rect& textureRect, const Vector4& color, InterleavedBuffer& batchBuffer, IndexBuffer& batchIndices, BatchRange& range){
+	unsigned int vertexCount = buffer.getCount();
+	unsigned int indexCount = (indices.getCount() > 0) ? indices.getCount() : vertexCount;
+	unsigned int baseVertex = batchBuffer.getCount();
+
+	// batch indices are 16 bits
+	if (baseVertex + vertexCount > UINT16_MAX + 1){
+		return false;
+	}
+
+	Attribute* attPosition = buffer.getAttribute(AttributeType::POSITION);
+	Attribute* attTexcoord = buffer.getAttribute(AttributeType::TEXCOORD1);
+	Attribute* attNormal = buffer.getAttribute(AttributeType::NORMAL);
+	Attribute* attColor = buffer.getAttribute(AttributeType::COLOR);
+
+	if (!attPosition){
+		return false;
+	}
+
+	Attribute* batchPosition = batchBuffer.getAttribute(AttributeType::POSITION);
+	Attribute* batchTexcoord = batchBuffer.getAttribute(AttributeType::TEXCOORD1);
+	Attribute* batchNormal = batchBuffer.getAttribute(AttributeType::NORMAL);
+	Attribute* batchColor = batchBuffer.getAttribute(AttributeType::COLOR);
+
+	for (unsigned int v = 0; v < vertexCount; v++){
+		batchBuffer.addVector3(batchPosition, transform.modelMatrix * buffer.getVector3(attPosition, v));
+
+		if (attTexcoord && batchTexcoord){
+			Vector2 uv = buffer.getVector2(attTexcoord, v);
+			batchBuffer.addVector2(batchTexcoord, Vector2(uv.x * textureRect.getWidth() + textureRect.getX(), uv.y * textureRect.getHeight() + textureRect.getY()));
+		}
+
+		if (attNormal && batchNormal){
+			Vector3 normal = buffer.getVector3(attNormal, v);
+			Vector4 worldNormal = transform.normalMatrix * Vector4(normal.x, normal.y, normal.z, 0.0);
+			batchBuffer.addVector3(batchNormal, Vector3(worldNormal.x, worldNormal.y, worldNormal.z).normalize());
+		}
+
+		if (attColor && batchColor){
+			if (attColor->getElements() == 4){
+				batchBuffer.addVector4(batchColor, buffer.getVector4(attColor, v) * color);
+			}else{
+				batchBuffer.addVector3(batchColor, buffer.getVector3(attColor, v));
+			}
+		}
+	}
+
+	range.first = batchIndices.getCount();
+	range.count = indexCount;
+
+	Attribute* attIndex = indices.getAttribute(AttributeType::INDEX);
+	Attribute* batchIndex = batchIndices.getAttribute(AttributeType::INDEX);
+	for (unsigned int i = 0; i < indexCount; i++){
+		unsigned int index = i;
+		if (indices.getCount() > 0){
+			if (attIndex->getDataType() == AttributeDataType::UNSIGNED_INT){
+				index = indices.getUInt32(attIndex, i);
+			}else{
+				index = indices.getUInt16(attIndex, i);
+			}
+		}
+		batchIndices.addUInt16(batchIndex, (uint16_t)(baseVertex + index));
+	}
+
+	return true;
+}
+
+void RenderSystem::updateBatches(){
+	const uint64_t batchKeepFrames = 120;
+
+	auto transforms = scene->getComponentArray<Transform>();
+	auto meshes = scene->getComponentArray<MeshComponent>();
+	auto sprites = scene->getComponentArray<SpriteComponent>();
+	auto instmeshes = scene->getComponentArray<InstancedMeshComponent>();
+	auto terrains = scene->getComponentArray<TerrainComponent>();
+	auto uis = scene->getComponentArray<UIComponent>();
+
+	transformBatchRanges.assign(transforms->size(), -1);
+	batchRanges.clear();
+	pendingBatch = {nullptr, nullptr, 0, 0};
+
+	if (!Engine::isAutomaticBatching()){
+		destroyBatches();
+		return;
+	}
+
+	batchCandidates.clear();
+	batchMembers.clear();
+
+	for (int i = 0; i < transforms->size(); i++){
+		Transform& transform = transforms->getComponentFromIndex(i);
+		Entity entity = transforms->getEntity(i);
+
+		if (!transform.visible){
+			continue;
+		}
+
+		uint64_t key = 0;
+		if (MeshComponent* mesh = meshes->findComponent(entity)){
+			if (sprites->contains(entity) && !instmeshes->contains(entity) && !terrains->contains(entity)){
+				key = getSpriteBatchKey(*mesh, transform);
+			}
+		}else if (UIComponent* ui = uis->findComponent(entity)){
+			key = getUIBatchKey(*ui, transform);
+		}
+
+		if (key != 0){
+			batchCandidates.push_back({(uint32_t)i, key});
+			batchMembers[key]++;
+		}
+	}
+
+	for (auto& [index, key] : batchCandidates){
+		// a single object is cheaper with its own buffers
+		if (batchMembers[key] < 2){
+			continue;
+		}
+
+		Transform& transform = transforms->getComponentFromIndex(index);
+		Entity entity = transforms->getEntity(index);
+
+		BatchRange range = {nullptr, nullptr, 0, 0};
+		bool added = false;
+
+		if (MeshComponent* meshPtr = meshes->findComponent(entity)){
+			MeshComponent& mesh = *meshPtr;
+
+			auto it = spriteBatches.find(key);
+			if (it == spriteBatches.end()){
+				it = spriteBatches.emplace(key, SpriteBatch{}).first;
+				SpriteBatch& batch = it->second;
+				for (auto const& attr : mesh.buffer.getAttributes()){
+					batch.mesh.buffer.addAttribute(attr.first, attr.second.getElements());
+				}
+				batch.mesh.buffer.setUsage(BufferUsage::STREAM);
+				batch.mesh.indices.setUsage(BufferUsage::STREAM);
+				batch.loadedVertexSize = 0;
+				batch.loadedIndexSize = 0;
+				batch.usedFrame = 0;
+			}
+			SpriteBatch& batch = it->second;
+
+			if (batch.usedFrame != drawFrame){
+				batch.usedFrame = drawFrame;
+				batch.source = &mesh;
+				batch.mesh.buffer.clear();
+				batch.mesh.indices.clear();
+			}
+
+			Vector4 color = mesh.submeshes[0].material.baseColorFactor;
+			added = appendBatchVertices(mesh.buffer, mesh.indices, transform, mesh.submeshes[0].textureRect, color, batch.mesh.buffer, batch.mesh.indices, range);
+			range.sprite = &batch;
+
+		}else if (UIComponent* uiPtr = uis->findComponent(entity)){
+			UIComponent& ui = *uiPtr;
+
+			auto it = uiBatches.find(key);
+			if (it == uiBatches.end()){
+				it = uiBatches.emplace(key, UIBatch{}).first;
+				UIBatch& batch = it->second;
+				for (auto const& attr : ui.buffer.getAttributes()){
+					batch.buffer.addAttribute(attr.first, attr.second.getElements());
+				}
+				batch.buffer.setUsage(BufferUsage::STREAM);
+				batch.indices.setUsage(BufferUsage::STREAM);
+				batch.shaderProperties = ui.shaderProperties;
+				batch.texture = ui.texture;
+				batch.color = Vector4(1.0, 1.0, 1.0, 1.0);
+				if (!batch.buffer.getAttribute(AttributeType::COLOR)){
+					batch.color = ui.color;
+				}
+				batch.loadedVertexSize = 0;
+				batch.loadedIndexSize = 0;
+				batch.usedFrame = 0;
+				batch.loaded = false;
+				batch.needUpdateBuffer = false;
+			}
+			UIBatch& batch = it->second;
+
+			if (batch.usedFrame != drawFrame){
+				batch.usedFrame = drawFrame;
+				batch.buffer.clear();
+				batch.indices.clear();
+			}
+
+			added = appendBatchVertices(ui.buffer, ui.indices, transform, Rect(0.0, 0.0, 1.0, 1.0), ui.color, batch.buffer, batch.indices, range);
+			range.ui = &batch;
+		}
+
+		if (added){
+			transformBatchRanges[index] = (int32_t)batchRanges.size();
+			batchRanges.push_back(range);
+		}
+	}
+
+	for (auto it = spriteBatches.begin(); it != spriteBatches.end();){
+		SpriteBatch& batch = it->second;
+
+		if (batch.usedFrame + batchKeepFrames < drawFrame){
+			destroySpriteBatch(batch);
+			it = spriteBatches.erase(it);
+			continue;
+		}
+
+		if (batch.usedFrame == drawFrame && loadSpriteBatch(batch)){
+			batch.mesh.needUpdateBuffer = true;
+		}
+
+		++it;
+	}
+
+	for (auto it = uiBatches.begin(); it != uiBatches.end();){
+		UIBatch& batch = it->second;
+
+		if (batch.usedFrame + batchKeepFrames < drawFrame){
+			destroyUIBatch(batch);
+			// batch copy keeps texture in pool after UI released it
+			batch.texture.destroy();
+			it = uiBatches.erase(it);
+			continue;
+		}
+
+		if (batch.usedFrame == drawFrame && loadUIBatch(batch)){
+			batch.needUpdateBuffer = true;
+		}
+
+		++it;
+	}
+}
+
+bool RenderSystem::loadSpriteBatch(SpriteBatch& batch){
+	if (batch.mesh.loaded){
+		if (batch.mesh.buffer.getSize() <= batch.loadedVertexSize && batch.mesh.indices.getSize() <= batch.loadedIndexSize){
+			return true;
+		}
+		destroySpriteBatch(batch);
+	}
+
+	// buffers grow in powers of two, reloading only when batch gets bigger
+	size_t vertexSize = 1024;
+	while (vertexSize < batch.mesh.buffer.getSize()){
+		vertexSize *= 2;
+	}
+	size_t indexSize = 256;
+	while (indexSize < batch.mesh.indices.getSize()){
+		indexSize *= 2;
+	}
+	batch.mesh.buffer.resize(vertexSize);
+	batch.mesh.indices.resize(indexSize);
+
+	InterleavedBuffer buffer = batch.mesh.buffer;
+	IndexBuffer indices = batch.mesh.indices;
+
+	batch.mesh = *batch.source;
+	batch.mesh.buffer = buffer;
+	batch.mesh.indices = indices;
+	batch.mesh.loaded = false;
+	batch.mesh.loadCalled = false;
+	batch.mesh.needReload = false;
+
+	Submesh& submesh = batch.mesh.submeshes[0];
+	submesh.render = ObjectRender();
+	submesh.depthRender = ObjectRender();
+	submesh.shader.reset();
+	submesh.depthShader.reset();
+	submesh.textureRect = Rect(0.0, 0.0, 1.0, 1.0);
+	if (buffer.getAttribute(AttributeType::COLOR) && buffer.getAttribute(AttributeType::COLOR)->getElements() == 4){
+		submesh.material.baseColorFactor = Vector4(1.0, 1.0, 1.0, 1.0);
+	}
+
+	if (!loadMesh(NULL_ENTITY, batch.mesh, meshPipelines, nullptr, nullptr)){
+		// members are drawn one by one
+		destroySpriteBatch(batch);
+		return false;
+	}
+	batch.mesh.loaded = true;
+	batch.loadedVertexSize = vertexSize;
+	batch.loadedIndexSize = indexSize;
+
+	return true;
+}
+
+bool RenderSystem::loadUIBatch(UIBatch& batch){
+	if (batch.loaded){
+		if (batch.buffer.getSize() <= batch.loadedVertexSize && batch.indices.getSize() <= batch.loadedIndexSize){
+			return true;
+		}
+		destroyUIBatch(batch);
+	}
+
+	size_t vertexSize = 1024;
+	while (vertexSize < batch.buffer.getSize()){
+		vertexSize *= 2;
+	}
+	size_t indexSize = 256;
+	while (indexSize < batch.indices.getSize()){
+		indexSize *= 2;
+	}
+
+	ObjectRender& render = batch.render;
+
+	render.beginLoad(PrimitiveType::TRIANGLES);
+
+	batch.shader = ShaderPool::get(ShaderType::UI, batch.shaderProperties);
+	if (!batch.shader->isCreated())
+		return false;
+	render.addShader(batch.shader.get());
+	ShaderData& shaderData = batch.shader.get()->shaderData;
+
+	batch.slotVSParams = shaderData.getUniformBlockIndex(UniformBlockType::UI_VS_PARAMS, ShaderStageType::VERTEX);
+	batch.slotFSParams = shaderData.getUniformBlockIndex(UniformBlockType::UI_FS_PARAMS, ShaderStageType::FRAGMENT);
+
+	batch.buffer.getRender()->createBuffer(vertexSize, batch.buffer.getData(), batch.buffer.getType(), batch.buffer.getUsage());
+	for (auto const &attr : batch.buffer.getAttributes()) {
+		render.addAttribute(shaderData.getAttrIndex(attr.first), batch.buffer.getRender(), attr.second.getElements(), attr.second.getDataType(), batch.buffer.getStride(), attr.second.getOffset(), attr.second.getNormalized(), attr.second.getPerInstance());
+	}
+
+	batch.indices.getRender()->createBuffer(indexSize, batch.indices.getData(), batch.indices.getType(), batch.indices.getUsage());
+	Attribute indexattr = batch.indices.getAttributes()[AttributeType::INDEX];
+	render.addIndex(batch.indices.getRender(), indexattr.getDataType(), indexattr.getOffset());
+
+	TextureRender* textureRender = batch.texture.getRender();
+	if (textureRender)
+		render.addTexture(shaderData.getTextureIndex(TextureShaderType::UI, ShaderStageType::FRAGMENT), ShaderStageType::FRAGMENT, textureRender);
+
+	if (!render.endLoad(meshPipelines, false, CullingMode::BACK, WindingOrder::CCW)){
+		destroyUIBatch(batch);
+		return false;
+	}
+
+	batch.loaded = true;
+	batch.loadedVertexSize = vertexSize;
+	batch.loadedIndexSize = indexSize;
+
+	return true;
+}
+
+void RenderSystem::destroySpriteBatch(SpriteBatch& batch){
+	if (!batch.mesh.loadCalled){
+		return;
+	}
+
+	destroyMeshCopy(batch.mesh);
+
+	batch.mesh.loaded = false;
+	batch.mesh.loadCalled = false;
+	batch.loadedVertexSize = 0;
+	batch.loadedIndexSize = 0;
+}
+
+void RenderSystem::destroyUIBatch(UIBatch& batch){
+	if (batch.shader){
+		batch.shader.reset();
+		ShaderPool::remove(ShaderType::UI, batch.shaderProperties);
+	}
+
+	batch.render.destroy();
+
+	batch.buffer.getRender()->destroyBuffer();
+	batch.indices.getRender()->destroyBuffer();
+
+	batch.loaded = false;
+	batch.loadedVertexSize = 0;
+	batch.loadedIndexSize = 0;
+}
+
+void RenderSystem::destroyBatches(){
+	for (auto& [key, batch] : spriteBatches){
+		destroySpriteBatch(batch);
+	}
+	spriteBatches.clear();
+
+	for (auto& [key, batch] : uiBatches){
+		destroyUIBatch(batch);
+		batch.texture.destroy();
+	}
+	uiBatches.clear();
+
+	batchRanges.clear();
+	transformBatchRanges.clear();
+	pendingBatch = {nullptr, nullptr, 0, 0};
+}
+
+bool RenderSystem::addBatchRange(int32_t range, CameraComponent& camera, Transform& cameraTransform, bool renderToTexture){
+	if (range < 0){
+		return false;
+	}
+
+	BatchRange& item = batchRanges[range];
+	if ((item.sprite && !item.sprite->mesh.loaded) || (item.ui && !item.ui->loaded)){
+		return false;
+	}
+
+	// consecutive members of same batch are merged in one draw
+	if (pendingBatch.count > 0 && pendingBatch.sprite == item.sprite && pendingBatch.ui == item.ui && pendingBatch.first + pendingBatch.count == item.first){
+		pendingBatch.count += item.count;
+	}else{
+		flushBatch(camera, cameraTransform, renderToTexture);
+		pendingBatch = item;
+	}
+
+	return true;
+}
+
+void RenderSystem::flushBatch(CameraComponent& camera, Transform& cameraTransform, bool renderToTexture){
+	if (pendingBatch.count == 0){
+		return;
+	}
+
+	if (pendingBatch.sprite){
+		SpriteBatch& batch = *pendingBatch.sprite;
+
+		batch.transform.modelViewProjectionMatrix = camera.viewProjectionMatrix;
+		batch.mesh.submeshes[0].baseElement = pendingBatch.first;
+		batch.mesh.submeshes[0].vertexCount = pendingBatch.count;
+
+		drawMesh(batch.mesh, batch.transform, camera, cameraTransform, renderToTexture, nullptr, nullptr);
+
+	}else if (pendingBatch.ui){
+		UIBatch& batch = *pendingBatch.ui;
+
+		if (batch.needUpdateBuffer){
+			bool updated = batch.buffer.updateRender(batch.buffer.getCount() * batch.buffer.getStride());
+			updated = batch.indices.updateRender(batch.indices.getCount() * batch.indices.getStride()) && updated;
+
+			batch.needUpdateBuffer = !updated;
+		}
+
+		ObjectRender& render = batch.render;
+
+		if (render.beginDraw((renderToTexture)?PIP_RTT:PIP_DEFAULT)){
+			render.applyUniformBlock(batch.slotVSParams, ShaderStageType::VERTEX, sizeof(float) * 16, &camera.viewProjectionMatrix);
+			render.applyUniformBlock(batch.slotFSParams, ShaderStageType::FRAGMENT, sizeof(float) * 4, &batch.color);
+			render.draw(pendingBatch.first, pendingBatch.count, 1);
+		}
+	}
+
+	pendingBatch.count = 0;
+}
+
+void RenderSystem::updateMeshSpatial(Entity entity, MeshComponent& mesh){
+	auto it = meshSpatial.find(entity);
+	if (it == meshSpatial.end()){
+		it = meshSpatial.insert({entity, {AABBTree::NULL_NODE, UINT32_MAX}}).first;
+	}
+	MeshSpatialData& data = it->second;
+
+	if (mesh.worldAABB == AABB::ZERO){
+		meshTree.destroyProxy(data.proxy);
+		data.proxy = AABBTree::NULL_NODE;
+		unboundedMeshes.insert(entity);
+		return;
+	}
+
+	unboundedMeshes.erase(entity);
+
+	if (mesh.worldAABB.isNull() || mesh.worldAABB.isInfinite()){
+		meshTree.destroyProxy(data.proxy);
+		data.proxy = AABBTree::NULL_NODE;
+	}else if (data.proxy == AABBTree::NULL_NODE){
+		data.proxy = meshTree.createProxy(mesh.worldAABB, entity, data.queueIndex);
+	}else{
+		meshTree.moveProxy(data.proxy, mesh.worldAABB);
+	}
+}
+
+void RenderSystem::removeMeshSpatial(Entity entity){
+	auto it = meshSpatial.find(entity);
+	if (it != meshSpatial.end()){
+		meshTree.destroyProxy(it->second.proxy);
+		meshSpatial.erase(it);
+	}
+	unboundedMeshes.erase(entity);
+}
+
+void RenderSystem::syncMeshSpatial(){
+	auto meshes = scene->getComponentArray<MeshComponent>();
+
+	if (meshSpatialVersion == meshes->getVersion()){
+		return;
+	}
+	meshSpatialVersion = meshes->getVersion();
+
+	// only when meshes were added or removed
+	for (auto it = meshSpatial.begin(); it != meshSpatial.end();){
+		if (!meshes->contains(it->first)){
+			meshTree.destroyProxy(it->second.proxy);
+			unboundedMeshes.erase(it->first);
+			it = meshSpatial.erase(it);
+		}else{
+			++it;
+		}
+	}
+
+	for (int i = 0; i < meshes->size(); i++){
+		Entity entity = meshes->getEntity(i);
+		if (meshSpatial.find(entity) == meshSpatial.end()){
+			updateMeshSpatial(entity, meshes->getComponentFromIndex(i));
+		}
+	}
+}
+
+const AABBTree& RenderSystem::getMeshTree() const{
+	return meshTree;
+}
+
+void RenderSystem::findMeshes(const AABB& box, std::vector<Entity>& result) const{
+	meshTree.queryAABB(box, result);
+}
+
+void RenderSystem::findMeshes(const Sphere& sphere, std::vector<Entity>& result) const{
+	meshTree.querySphere(sphere, result);
+}
+
+void RenderSystem::findMeshes(CameraComponent& camera, std::vector<Entity>& result) const{
+	Plane planes[6];
+	int numPlanes = 0;
+	for (int p = 0; p < 6; p++){
+		if (p == FRUSTUM_PLANE_FAR && camera.farClip == 0)
+			continue;
+
+		planes[numPlanes++] = camera.frustumPlanes[p];
+	}
+
+	meshTree.queryFrustum(planes, numPlanes, result);
+	result.insert(result.end(), unboundedMeshes.begin(), unboundedMeshes.end());
+}
+
+void RenderSystem::findMeshes(const Vector3& origin, const Vector3& direction, std::vector<Entity>& result) const{
+	meshTree.queryRay(origin, direction, result);
+}
+
+void RenderSystem::updateShadowCasters(){
+	shadowCasters.clear();
+	previousCasterMask.swap(shadowCasterMask);
+	shadowCasterMask.assign((renderQueue.size() + 63) / 64, 0);
+	casterCuller.clear();
+
+	for (uint32_t i = 0; i < renderQueue.size(); i++){
+		MeshComponent& mesh = *renderQueue[i].mesh;
+		if (mesh.castShadows && mesh.loaded){
+			shadowCasters.push_back(i);
+			shadowCasterMask[i / 64] |= ((uint64_t)1 << (i % 64));
+			casterCuller.add(mesh.worldAABB);
+		}
+	}
+
+	// castShadows can change without moving or reloading a mesh
+	if (shadowCasterMask != previousCasterMask){
+		shadowCasterRevision++;
+	}
+}
+
+const std::vector<uint64_t>& RenderSystem::cullShadowCasters(LightCasterCache& cache, int index, LightCamera& lightCamera){
+	const size_t treeCullingMinMeshes = 8192;
+
+	std::vector<uint64_t>& casters = cache.casters[index];
+
+	Plane planes[6];
+	int numPlanes = 0;
+	for (int p = 0; p < 6; p++){
+		if (p == FRUSTUM_PLANE_FAR && lightCamera.nearFar.y == 0)
+			continue;
+
+		planes[numPlanes++] = lightCamera.frustumPlanes[p];
+	}
+
+	bool cacheValid = (cache.frame != 0 && cache.queueRevision == renderQueueRevision && cache.casterRevision == shadowCasterRevision && cache.frame + 1 == drawFrame && casters.size() == shadowCasterMask.size());
+
+	cache.changed[index] = false;
+
+	if (!cacheValid || cache.viewProjection[index] != lightCamera.lightViewProjectionMatrix){
+		cache.changed[index] = true;
+		casters.assign(shadowCasterMask.size(), 0);
+
+		if (renderQueue.size() < treeCullingMinMeshes){
+			casterCuller.cull(planes, numPlanes, visibleCasters);
+			for (size_t w = 0; w < visibleCasters.size(); w++){
+				uint64_t bits = visibleCasters[w];
+				for (uint32_t b = 0; bits != 0; b++, bits >>= 1){
+					if (bits & 1){
+						uint32_t q = shadowCasters[w * 64 + b];
+						casters[q / 64] |= ((uint64_t)1 << (q % 64));
+					}
+				}
+			}
+		}else{
+			treeQueryProxies.clear();
+			meshTree.queryFrustum(planes, numPlanes, treeQueryProxies);
+			for (int32_t proxy : treeQueryProxies){
+				uint32_t q = meshTree.getData(proxy);
+				if (q < renderQueue.size()){
+					casters[q / 64] |= ((uint64_t)1 << (q % 64)) & shadowCasterMask[q / 64];
+				}
+			}
+			for (Entity entity : unboundedMeshes){
+				uint32_t q = meshSpatial[entity].queueIndex;
+				if (q < renderQueue.size()){
+					casters[q / 64] |= ((uint64_t)1 << (q % 64)) & shadowCasterMask[q / 64];
+				}
+			}
+		}
+
+		cache.viewProjection[index] = lightCamera.lightViewProjectionMatrix;
+	}else{
+		// light is still, only casters that moved are tested again
+		for (Entity entity : movedCasters){
+			auto it = meshSpatial.find(entity);
+			if (it == meshSpatial.end() || it->second.queueIndex >= renderQueue.size()){
+				continue;
+			}
+
+			uint32_t q = it->second.queueIndex;
+			uint64_t bit = ((uint64_t)1 << (q % 64)) & shadowCasterMask[q / 64];
+			const AABB& box = renderQueue[q].mesh->worldAABB;
+
+			// moving inside, outside or out of the view changes its depth
+			if (casters[q / 64] & bit){
+				cache.changed[index] = true;
+			}
+
+			if (box == AABB::ZERO || isInsideCamera(lightCamera.nearFar.y, lightCamera.frustumPlanes, box)){
+				casters[q / 64] |= bit;
+				cache.changed[index] = cache.changed[index] || (bit != 0);
+			}else{
+				casters[q / 64] &= ~bit;
+			}
+		}
+	}
+
+	cache.queueRevision = renderQueueRevision;
+	cache.casterRevision = shadowCasterRevision;
+	cache.frame = drawFrame;
+
+	return casters;
+}
+
+void RenderSystem::cullRenderQueue(const float cameraFar, const Plane frustumPlanes[6]){
+	// above this amount the spatial tree is faster than testing every box
+	const size_t treeCullingMinMeshes = 8192;
+
+	Plane planes[6];
+	int numPlanes = 0;
+	for (int p = 0; p < 6; p++){
+		if (p == FRUSTUM_PLANE_FAR && cameraFar == 0)
+			continue;
+
+		planes[numPlanes++] = frustumPlanes[p];
+	}
+
+	size_t numVisible = 0;
+	if (renderQueue.size() < treeCullingMinMeshes){
+		if (meshCuller.size() != renderQueue.size()){
+			// world boxes change every frame, packed once for all passes
+			meshCuller.clear();
+			meshCuller.reserve(renderQueue.size());
+			for (RenderQueueItem& item : renderQueue){
+				meshCuller.add(item.mesh->worldAABB);
+			}
+		}
+
+		numVisible = meshCuller.cull(planes, numPlanes, visibleMeshes);
+	}else{
+		visibleMeshes.assign((renderQueue.size() + 63) / 64, 0);
+
+		// tree leaves are enlarged boxes, so this can only draw a few more meshes
+		treeQueryProxies.clear();
+		meshTree.queryFrustum(planes, numPlanes, treeQueryProxies);
+		for (int32_t proxy : treeQueryProxies){
+			uint32_t index = meshTree.getData(proxy);
+			if (index < renderQueue.size()){
+				visibleMeshes[index / 64] |= ((uint64_t)1 << (index % 64));
+			}
+		}
+		for (Entity entity : unboundedMeshes){
+			uint32_t index = meshSpatial[entity].queueIndex;
+			if (index < renderQueue.size()){
+				visibleMeshes[index / 64] |= ((uint64_t)1 << (index % 64));
+			}
+		}
+	}
+
+	visibleMeshIndexes.clear();
+	for (size_t w = 0; w < visibleMeshes.size(); w++){
+		uint64_t bits = visibleMeshes[w];
+		for (uint32_t b = 0; bits != 0; b++, bits >>= 1){
+			if (bits & 1){
+				uint32_t index = (uint32_t)(w * 64 + b);
+				if (renderQueue[index].transform->visible){
+					visibleMeshIndexes.push_back(index);
+				}
+			}
+		}
+	}
+	if (numVisible == 0){
+		numVisible = visibleMeshIndexes.size();
+	}
+
+	culledMeshes += renderQueue.size() - std::min(numVisible, renderQueue.size());
+	drawnMeshes += visibleMeshIndexes.size();
+}
+
+size_t RenderSystem::sortRenderQueue(CameraComponent& camera){
+	const uint64_t depthMax = 0xFFFFFF;
+
+	cullRenderQueue(camera.farClip, camera.frustumPlanes);
+
+	renderQueueKeys.clear();
+	for (uint32_t i : visibleMeshIndexes){
+		RenderQueueItem& item = renderQueue[i];
+
+		float depth = item.transform->distanceToCamera / camera.farClip;
+		uint64_t depthKey = (uint64_t)(std::max(0.0f, std::min(1.0f, depth)) * depthMax);
+
+		// bits: pass (2) | pipeline (22) | texture (16) | front to back depth (24)
+		// transparent: pass (2) | back to front depth (24) | pipeline (22) | texture (16)
+		uint64_t key;
+		if (item.mesh->transparent && camera.transparentSort){
+			key = ((uint64_t)1 << 62) | ((depthMax - depthKey) << 38) | item.stateKey;
+		}else{
+			key = (item.stateKey << 24) | depthKey;
+		}
+
+		renderQueueKeys.push_back({key, i});
+	}
+
+	radixSort(renderQueueKeys, renderQueueKeysTemp);
+
+	size_t transparentBegin = 0;
+	while (transparentBegin < renderQueueKeys.size() && (renderQueueKeys[transparentBegin].key >> 62) == 0){
+		transparentBegin++;
+	}
+
+	return transparentBegin;
+}
+
+void RenderSystem::drawRenderQueue(size_t begin, size_t end, CameraComponent& camera, Transform& cameraTransform, bool renderToTexture){
+	instancePass++;
+
+	for (size_t i = begin; i < end; i++){
+		RenderQueueItem& item = renderQueue[renderQueueKeys[i].item];
+
+		if (item.instanceGroup){
+			// first visible member draws the whole group
+			if (item.instanceGroup->drawnPass != instancePass){
+				item.instanceGroup->drawnPass = instancePass;
+				drawInstanceGroup(*item.instanceGroup, camera, cameraTransform, renderToTexture);
+			}
+			continue;
+		}
+
+		drawMesh(*item.mesh, *item.transform, camera, cameraTransform, renderToTexture, item.instmesh, item.terrain);
+	}
+}
+
+unsigned int RenderSystem::getCulledMeshes() const{
+	return culledMeshes;
+}
+
+unsigned int RenderSystem::getDrawnMeshes() const{
+	return drawnMeshes;
+}
+
+unsigned int RenderSystem::getSkippedSkinnings() const{
+	return skippedSkinnings;
+}
+
+void RenderSystem::radixSort(std::vector<RenderQueueKey>& keys, std::vector<RenderQueueKey>& temp){
+	temp.resize(keys.size());
+
+	// LSD radix by byte, stable, passes with a single bucket are skipped
+	for (int shift = 0; shift < 64; shift += 8){
+		size_t count[256] = {};
+		for (const RenderQueueKey& k : keys){
+			count[(k.key >> shift) & 0xFF]++;
+		}
+
+		if (keys.empty() || count[(keys[0].key >> shift) & 0xFF] == keys.size()){
+			continue;
+		}
+
+		size_t offset = 0;
+		for (int b = 0; b < 256; b++){
+			size_t c = count[b];
+			count[b] = offset;
+			offset += c;
+		}
+
+		for (const RenderQueueKey& k : keys){
+			temp[count[(k.key >> shift) & 0xFF]++] = k;
+		}
+
+		keys.swap(temp);
+	}
+}
+
+void RenderSystem::draw(){
+	std::priority_queue<TransparentMeshesData, std::vector<TransparentMeshesData>, MeshComparison> transparentMeshes;
+
+	auto transforms = scene->getComponentArray<Transform>();
+	auto cameras = scene->getComponentArray<CameraComponent>();
+	auto meshes = scene->getComponentArray<MeshComponent>();
+	auto instmeshes = scene->getComponentArray<InstancedMeshComponent>();
+	auto terrains = scene->getComponentArray<TerrainComponent>();
+	auto layouts = scene->getComponentArray<UILayoutComponent>();
+	auto images = scene->getComponentArray<ImageComponent>();
+	auto uis = scene->getComponentArray<UIComponent>();
+	auto allpoints = scene->getComponentArray<PointsComponent>();
+	auto alllines = scene->getComponentArray<LinesComponent>();
+
+	culledMeshes = 0;
+	drawnMeshes = 0;
+
+	updateRenderQueue();
+
+	meshCuller.clear();
+
+	drawFrame++;
+
+	updateInstanceGroups();
+
+	updateBatches();
+
+	if (hasShadows){
+		updateShadowCasters();
+	}
+
+	//---------Depth shader----------
+	if (hasShadows){
+		auto lights = scene->getComponentArray<LightComponent>();
+
+		shadowViews.clear();
+		shadowViewMeshes.clear();
+		pendingShadowViews.clear();
+
+		for (int l = 0; l < lights->size(); l++){
+			LightComponent& light = lights->getComponentFromIndex(l);
+
+			if (light.intensity > 0 && light.shadows){
+				LightCasterCache& casterCache = lightCasters[lights->getEntity(l)];
+
+				size_t cameras = 1;
+				if (light.type == LightType::POINT){
+					cameras = 6;
+				}else if (light.type == LightType::DIRECTIONAL){
+					cameras = light.numShadowCascades;
+				}
+
+				for (int c = 0; c < cameras; c++){
+					const std::vector<uint64_t>& casters = cullShadowCasters(casterCache, c, light.cameras[c]);
+
+					ShadowView view = {&light, &casterCache, c, shadowViewMeshes.size(), 0};
+
+					// animated, terrain and instanced meshes also depend on time or main camera
+					bool dynamic = false;
+					uint64_t castersHash = 14695981039346656037ULL;
+					for (size_t w = 0; w < casters.size(); w++){
+						uint64_t bits = casters[w] & shadowCasterMask[w];
+						for (uint32_t b = 0; bits != 0; b++, bits >>= 1){
+							if ((bits & 1) && renderQueue[w * 64 + b].transform->visible){
+								uint32_t m = (uint32_t)(w * 64 + b);
+								shadowViewMeshes.push_back(m);
+								castersHash = (castersHash ^ m) * 1099511628211ULL;
+
+								MeshComponent& mesh = *renderQueue[m].mesh;
+								if (renderQueue[m].instmesh || renderQueue[m].terrain || mesh.needUpdateBuffer){
+									dynamic = true;
+								}
+								for (int i = 0; i < mesh.numSubmeshes && !dynamic; i++){
+									if (mesh.submeshes[i].hasSkinning || mesh.submeshes[i].hasMorphTarget || mesh.submeshes[i].needUpdateTexture){
+										dynamic = true;
+									}
+								}
+							}
+						}
+					}
+					view.end = shadowViewMeshes.size();
+
+					bool changed = dynamic || casterCache.changed[c] || !casterCache.rendered[c] ||
+									casterCache.renderedCasters[c] != castersHash ||
+									casterCache.renderedViewProjection[c] != light.cameras[c].lightViewProjectionMatrix ||
+									casterCache.renderedNearFar[c] != light.cameras[c].nearFar;
+					casterCache.renderedCasters[c] = castersHash;
+
+					if (changed && casterCache.dirtyFrame[c] == 0){
+						casterCache.dirtyFrame[c] = drawFrame;
+					}
+
+					if (casterCache.dirtyFrame[c] != 0){
+						pendingShadowViews.push_back(shadowViews.size());
+					}
+
+					shadowViews.push_back(view);
+				}
+			}
+		}
+
+		// over budget, maps never drawn go first and then the ones waiting longer
+		int maxShadowUpdates = Engine::getMaxShadowUpdates();
+		if (maxShadowUpdates > 0 && pendingShadowViews.size() > (size_t)maxShadowUpdates){
+			std::stable_sort(pendingShadowViews.begin(), pendingShadowViews.end(), [this](size_t a, size_t b){
+				const ShadowView& va = shadowViews[a];
+				const ShadowView& vb = shadowViews[b];
+				bool ra = va.cache->rendered[va.camera];
+				bool rb = vb.cache->rendered[vb.camera];
+				if (ra != rb)
+					return !ra;
+				return va.cache->dirtyFrame[va.camera] < vb.cache->dirtyFrame[vb.camera];
+			});
+			pendingShadowViews.resize(maxShadowUpdates);
+		}
+
+		for (size_t v : pendingShadowViews){
+			const ShadowView& view = shadowViews[v];
+			LightComponent& light = *view.light;
+			LightCasterCache& casterCache = *view.cache;
+			int c = view.camera;
+
+			size_t face = 0;
+			size_t fb = c;
+			if (light.type == LightType::POINT){
+				face = c;
+				fb = 0;
+			}
+			light.cameras[c].render.setClearColor(Vector4(1.0, 1.0, 1.0, 1.0));
+
+			culledMeshes += shadowCasters.size() - std::min(shadowCasters.size(), view.end - view.begin);
+			drawnMeshes += view.end - view.begin;
+
+			light.cameras[c].render.startRenderPass(&light.framebuffer[fb], face);
+			instancePass++;
+			for (size_t i = view.begin; i < view.end; i++){
+				uint32_t m = shadowViewMeshes[i];
+				MeshComponent& mesh = *renderQueue[m].mesh;
+				Transform& transform = *renderQueue[m].transform;
+
+				InstanceGroup* group = renderQueue[m].instanceGroup;
+				if (group){
+					if (group->drawnPass != instancePass){
+						group->drawnPass = instancePass;
+						drawMeshDepth(group->mesh, {group->transform.modelMatrix, light.cameras[c].lightViewProjectionMatrix}, &group->instmesh, nullptr);
+					}
+					continue;
+				}
+
+				vs_depth_t vsDepthParams;
+
+				if (transform.billboard && mesh.enableShadowsBillboard){
+					Matrix4 modelViewMatrix = light.cameras[c].lightViewMatrix * transform.modelMatrix;
+
+					modelViewMatrix.set(0, 0, transform.worldScale.x);
+					modelViewMatrix.set(0, 1, 0.0);
+					modelViewMatrix.set(0, 2, 0.0);
+
+					if (!transform.cylindricalBillboard) {
+						modelViewMatrix.set(1, 0, 0.0);
+						modelViewMatrix.set(1, 1, transform.worldScale.y);
+						modelViewMatrix.set(1, 2, 0.0);
+					}
+
+					modelViewMatrix.set(2, 0, 0.0);
+					modelViewMatrix.set(2, 1, 0.0);
+					modelViewMatrix.set(2, 2, transform.worldScale.z);
+
+					vsDepthParams = {modelViewMatrix, light.cameras[c].lightProjectionMatrix};
+				}else{
+					vsDepthParams = {transform.modelMatrix, light.cameras[c].lightViewProjectionMatrix};
+				}
+
+				drawMeshDepth(mesh, vsDepthParams, renderQueue[m].instmesh, renderQueue[m].terrain);
+			}
+
+			light.cameras[c].render.endRenderPass();
+
+			casterCache.rendered[c] = true;
+			casterCache.renderedViewProjection[c] = light.cameras[c].lightViewProjectionMatrix;
+			casterCache.renderedNearFar[c] = light.cameras[c].nearFar;
+			casterCache.dirtyFrame[c] = 0;
+		}
+
+		// maps waiting for update are sampled with the matrices they were drawn
+		if (shadowViews.size() > pendingShadowViews.size()){
+			for (const ShadowView& view : shadowViews){
+				LightComponent& light = *view.light;
+				LightCasterCache& casterCache = *view.cache;
+				int c = view.camera;
+
+				if (light.shadowMapIndex < 0 || !casterCache.rendered[c])
+					continue;
+
+				if (light.type != LightType::POINT){
+					vs_shadows.lightViewProjectionMatrix[light.shadowMapIndex+c] = casterCache.renderedViewProjection[c];
+					fs_shadows.bias_texSize_nearFar[light.shadowMapIndex+c] = Vector4(light.shadowBias, light.mapResolution, casterCache.renderedNearFar[c].x, casterCache.renderedNearFar[c].y);
+				}else if (c == 0){
+					fs_shadows.bias_texSize_nearFar[light.shadowMapIndex] = Vector4(light.shadowBias, light.mapResolution, casterCache.renderedNearFar[c].x, casterCache.renderedNearFar[c].y);
+				}
+			}
+
+			vsShadowsHash = ObjectRender::getUniformHash(&vs_shadows, sizeof(float) * (16 * MAX_SHADOWSMAP));
+			fsShadowsHash = ObjectRender::getUniformHash(&fs_shadows, sizeof(float) * (4 * (MAX_SHADOWSMAP + MAX_SHADOWSCUBEMAP)));
+		}
+	}
+
+	movedCasters.clear();
+
+	for (int i = 0; i < cameras->size(); i++){
+		Entity cameraEntity = cameras->getEntity(i);
+		CameraComponent& camera = cameras->getComponentFromIndex(i);
+		Transform& cameraTransform = scene->getComponent<Transform>(cameraEntity);
+
+		bool isMainCamera = (cameraEntity == scene->getCamera());
+
+		if (!isMainCamera && !camera.renderToTexture){
+			continue; // camera is not used
+		}
+
+		if (Engine::getMainScene() == scene || camera.renderToTexture){
+			camera.render.setClearColor(scene->getBackgroundColor());
+		}
+		
 		if (!camera.renderToTexture){
 			if (Engine::getFramebuffer()){
 				if (!Engine::getFramebuffer()->isCreated()){
@@ -2881,6 +4520,8 @@ void RenderSystem::draw(){
 			camera.render.startRenderPass(&camera.framebuffer->getRender());
 		}
 
+		bool renderToTexture = camera.renderToTexture || Engine::getFramebuffer();
+
 		//---------Draw opaque meshes and UI----------
 		bool hasActiveScissor = false;
 
@@ -2893,131 +4534,185 @@ void RenderSystem::draw(){
 				updateSkyViewProjection(sky, camera);
 			}
 
-			drawSky(sky, camera.renderToTexture || Engine::getFramebuffer());
+			drawSky(sky, renderToTexture);
+		}
+
+		// 2D cameras keep hierarchy order for meshes, 3D cameras use sorted render queue
+		bool useRenderQueue = (camera.type != CameraType::CAMERA_2D);
+
+		if (hasMultipleCameras){
+			for (int i = 0; i < transforms->size(); i++){
+				Transform& transform = transforms->getComponentFromIndex(i);
+				Entity entity = transforms->getEntity(i);
+
+				if (cameras->contains(entity)){
+					continue;
+				}
+
+				updateMVP(i, transform, camera, cameraTransform);
+
+				if (MeshComponent* meshPtr = meshes->findComponent(entity)){
+					MeshComponent& mesh = *meshPtr;
+
+					if (transform.visible){
+						InstancedMeshComponent* instmesh = instmeshes->findComponent(entity);
+						if (instmesh && mesh.transparent && camera.type != CameraType::CAMERA_2D){
+							if (instmesh->instancedBillboard){
+								updateInstancedMesh(*instmesh, mesh, transform, camera, cameraTransform);
+							}
+							sortInstancedMesh(*instmesh, mesh, transform, camera, cameraTransform);
+						}
+
+						if (TerrainComponent* terrain = terrains->findComponent(entity)){
+							updateTerrain(*terrain, transform, camera, cameraTransform);
+						}
+					}
+				}else if (PointsComponent* pointsPtr = allpoints->findComponent(entity)){
+					PointsComponent& points = *pointsPtr;
+
+					if (points.transparent && camera.type != CameraType::CAMERA_2D){
+						sortPoints(points, transform, camera, cameraTransform);
+					}
+				}
+			}
+		}
+
+		size_t transparentBegin = 0;
+		if (useRenderQueue){
+			transparentBegin = sortRenderQueue(camera);
+
+			drawRenderQueue(0, transparentBegin, camera, cameraTransform, renderToTexture);
 		}
 
+		Rect activeScissor;
+
 		for (int i = 0; i < transforms->size(); i++){
 			Transform& transform = transforms->getComponentFromIndex(i);
 			Entity entity = transforms->getEntity(i);
-			Signature signature = scene->getSignature(entity);
 
-			if (signature.test(scene->getComponentId<CameraComponent>())){
+			if (cameras->contains(entity)){
 				continue;
 			}
 
-			if (hasMultipleCameras){
-				updateMVP(i, transform, camera, cameraTransform);
-			}
-
-			// apply scissor on UI
-			if (signature.test(scene->getComponentId<UILayoutComponent>())){
-				UILayoutComponent& layout = scene->getComponent<UILayoutComponent>(entity);
+			// scissor is only changed when it differs from previous object, keeping batches inside same scissor
+			bool entityScissor = false;
+			Rect parentScissor;
 
-				Rect parentScissor;
+			if (UILayoutComponent* layoutPtr = layouts->findComponent(entity)){
+				UILayoutComponent& layout = *layoutPtr;
 
 				if (transform.parent != NULL_ENTITY){
-					Signature parentSignature = scene->getSignature(transform.parent);
-					if (parentSignature.test(scene->getComponentId<UILayoutComponent>())){
-						UILayoutComponent& parentLayout = scene->getComponent<UILayoutComponent>(transform.parent);
+					if (UILayoutComponent* parentLayoutPtr = layouts->findComponent(transform.parent)){
+						UILayoutComponent& parentLayout = *parentLayoutPtr;
 
 						parentScissor = parentLayout.scissor;
 						if (!parentScissor.isZero()){
 							if (!layout.ignoreScissor){
-								camera.render.applyScissor(parentScissor);
 								layout.scissor = parentScissor;
 
-								hasActiveScissor = true;
+								entityScissor = true;
 							}
 						}
 					}
 				}
 
-				if (signature.test(scene->getComponentId<ImageComponent>())){
-					ImageComponent& img = scene->getComponent<ImageComponent>(entity);
+				if (ImageComponent* imgPtr = images->findComponent(entity)){
+					ImageComponent& img = *imgPtr;
 
 					layout.scissor = getScissorRect(layout, img, transform, camera);
-					if (hasActiveScissor){
+					if (entityScissor){
 						layout.scissor = layout.scissor.fitOnRect(parentScissor);
 					}
 				}
 			}
 
-			if (signature.test(scene->getComponentId<MeshComponent>())){
-				MeshComponent& mesh = scene->getComponent<MeshComponent>(entity);
+			if (entityScissor != hasActiveScissor || (entityScissor && activeScissor != parentScissor)){
+				flushBatch(camera, cameraTransform, renderToTexture);
 
-				if (transform.visible){
+				if (entityScissor){
+					camera.render.applyScissor(parentScissor);
+				}else if (!camera.renderToTexture){
+					camera.render.applyScissor(Rect(0, 0, System::instance().getScreenWidth(), System::instance().getScreenHeight()));
+				}else{
+					camera.render.applyScissor(Rect(0, 0, camera.framebuffer->getWidth(), camera.framebuffer->getHeight()));
+				}
 
-					InstancedMeshComponent* instmesh = scene->findComponent<InstancedMeshComponent>(entity);
-					if (instmesh){
-						bool sortTransparentInstances = mesh.transparent && camera.type != CameraType::CAMERA_2D;
+				activeScissor = parentScissor;
+				hasActiveScissor = entityScissor;
+			}
 
-						if (hasMultipleCameras && sortTransparentInstances){
-							if (instmesh->instancedBillboard){
-								updateInstancedMesh(*instmesh, mesh, transform, camera, cameraTransform);
-							}
-							sortInstancedMesh(*instmesh, mesh, transform, camera, cameraTransform);
-						}
-					}
+			int32_t batchRange = ((size_t)i < transformBatchRanges.size()) ? transformBatchRanges[i] : -1;
 
-					TerrainComponent* terrain = scene->findComponent<TerrainComponent>(entity);
-					if (terrain && hasMultipleCameras){
-						updateTerrain(*terrain, transform, camera, cameraTransform);
-					}
+			if (MeshComponent* meshPtr = meshes->findComponent(entity)){
+				MeshComponent& mesh = *meshPtr;
+
+				// render queue meshes were already culled in batch
+				if (transform.visible && !useRenderQueue && (mesh.worldAABB == AABB::ZERO || isInsideCamera(camera, mesh.worldAABB))){
+
+					InstancedMeshComponent* instmesh = instmeshes->findComponent(entity);
+					TerrainComponent* terrain = terrains->findComponent(entity);
 
 					if (!mesh.transparent || !camera.transparentSort){
 						//Draw opaque meshes if transparency is not necessary
-						drawMesh(mesh, transform, camera, cameraTransform, camera.renderToTexture || Engine::getFramebuffer(), instmesh, terrain);
+						if (!addBatchRange(batchRange, camera, cameraTransform, renderToTexture)){
+							flushBatch(camera, cameraTransform, renderToTexture);
+							drawMesh(mesh, transform, camera, cameraTransform, renderToTexture, instmesh, terrain);
+						}
 					}else{
 						transparentMeshes.push({&mesh, instmesh, terrain, &transform, transform.distanceToCamera});
 					}
 				}
 
-			}else if (signature.test(scene->getComponentId<UIComponent>())){
-				UIComponent& ui = scene->getComponent<UIComponent>(entity);
+			}else if (UIComponent* uiPtr = uis->findComponent(entity)){
+				UIComponent& ui = *uiPtr;
 
-				bool isText = false;
-				if (signature.test(scene->getComponentId<TextComponent>())){
-					isText = true;
+				if (transform.visible){
+					if (!addBatchRange(batchRange, camera, cameraTransform, renderToTexture)){
+						flushBatch(camera, cameraTransform, renderToTexture);
+						drawUI(ui, transform, renderToTexture);
+					}
 				}
-				if (transform.visible)
-					drawUI(ui, transform, camera.renderToTexture || Engine::getFramebuffer());
 
-			}else if (signature.test(scene->getComponentId<PointsComponent>())){
-				PointsComponent& points = scene->getComponent<PointsComponent>(entity);
+			}else if (PointsComponent* pointsPtr = allpoints->findComponent(entity)){
+				PointsComponent& points = *pointsPtr;
 
-				bool sortTransparentPoints = points.transparent && camera.type != CameraType::CAMERA_2D;
-
-				if (hasMultipleCameras && sortTransparentPoints){
-					sortPoints(points, transform, camera, cameraTransform);
+				if (transform.visible){
+					flushBatch(camera, cameraTransform, renderToTexture);
+					drawPoints(points, transform, cameraTransform, renderToTexture);
 				}
 
-				if (transform.visible)
-					drawPoints(points, transform, cameraTransform, camera.renderToTexture || Engine::getFramebuffer());
+			}else if (LinesComponent* linesPtr = alllines->findComponent(entity)){
+				LinesComponent& lines = *linesPtr;
 
-			}else if (signature.test(scene->getComponentId<LinesComponent>())){
-				LinesComponent& lines = scene->getComponent<LinesComponent>(entity);
-
-				if (transform.visible)
-					drawLines(lines, transform, cameraTransform, camera.renderToTexture || Engine::getFramebuffer());
+				if (transform.visible){
+					flushBatch(camera, cameraTransform, renderToTexture);
+					drawLines(lines, transform, cameraTransform, renderToTexture);
+				}
 
 			}
+		}
 
-			if (hasActiveScissor){
-				if (!camera.renderToTexture){
-					camera.render.applyScissor(Rect(0, 0, System::instance().getScreenWidth(), System::instance().getScreenHeight()));
-				}else{
-					camera.render.applyScissor(Rect(0, 0, camera.framebuffer->getWidth(), camera.framebuffer->getHeight()));
-				}
-				hasActiveScissor = false;
+		flushBatch(camera, cameraTransform, renderToTexture);
+
+		if (hasActiveScissor){
+			if (!camera.renderToTexture){
+				camera.render.applyScissor(Rect(0, 0, System::instance().getScreenWidth(), System::instance().getScreenHeight()));
+			}else{
+				camera.render.applyScissor(Rect(0, 0, camera.framebuffer->getWidth(), camera.framebuffer->getHeight()));
 			}
+			hasActiveScissor = false;
 		}
 
 		//---------Draw transparent meshes----------
+		if (useRenderQueue){
+			drawRenderQueue(transparentBegin, renderQueueKeys.size(), camera, cameraTransform, renderToTexture);
+		}
+
 		while (!transparentMeshes.empty()){
 			TransparentMeshesData meshData = transparentMeshes.top();
 
 			//Draw transparent meshes
-			drawMesh(*meshData.mesh, *meshData.transform, camera, cameraTransform, camera.renderToTexture || Engine::getFramebuffer(), meshData.instmesh, meshData.terrain);
+			drawMesh(*meshData.mesh, *meshData.transform, camera, cameraTransform, renderToTexture, meshData.instmesh, meshData.terrain);
 
 			transparentMeshes.pop();
 		}
@@ -3052,6 +4747,7 @@ void RenderSystem::entityDestroyed(Entity entity){
 
 	if (signature.test(scene->getComponentId<LightComponent>())){
 		destroyLight(scene->getComponent<LightComponent>(entity));
+		lightCasters.erase(entity);
 	}
 
 	if (signature.test(scene->getComponentId<CameraComponent>())){
@@ -3060,6 +4756,8 @@ void RenderSystem::entityDestroyed(Entity entity){
 
 	if (signature.test(scene->getComponentId<MeshComponent>())){
 		destroyMesh(entity, scene->getComponent<MeshComponent>(entity));
+		removeMeshSpatial(entity);
+		meshContentHashes.erase(entity);
 	}
 
 	if (signature.test(scene->getComponentId<UIComponent>())){
@@ -24,8 +24,13 @@
 #include "render/CameraRender.h"
 #include "render/BufferRender.h"
 #include "render/FramebufferRender.h"
+#include "math/FrustumCuller.h"
+#include "math/AABBTree.h"
+#include "math/LightCuller.h"
 #include "Engine.h"
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <queue>
 
@@ -71,6 +76,96 @@ namespace Supernova{
 			float distanceToCamera;
 		};
 
+		struct InstanceGroup{
+			// copy of first member loaded with instanced shaders
+			MeshComponent mesh;
+			InstancedMeshComponent instmesh;
+			Transform transform;
+			Matrix4 inverseBase;
+			std::vector<uint32_t> members;
+			uint64_t drawnPass;
+		};
+
+		struct SpriteBatch{
+			// copy of first member, buffers hold world space vertices of all members
+			MeshComponent mesh;
+			Transform transform;
+			MeshComponent* source;
+			size_t loadedVertexSize;
+			size_t loadedIndexSize;
+			uint64_t usedFrame;
+		};
+
+		struct UIBatch{
+			ObjectRender render;
+			std::shared_ptr<ShaderRender> shader;
+			std::string shaderProperties;
+			Texture texture;
+			InterleavedBuffer buffer;
+			IndexBuffer indices;
+			Vector4 color;
+			int slotVSParams;
+			int slotFSParams;
+			size_t loadedVertexSize;
+			size_t loadedIndexSize;
+			uint64_t usedFrame;
+			bool loaded;
+			bool needUpdateBuffer;
+		};
+
+		struct BatchRange{
+			SpriteBatch* sprite;
+			UIBatch* ui;
+			uint32_t first;
+			uint32_t count;
+		};
+
+		struct RenderQueueItem{
+			uint64_t stateKey;
+			MeshComponent* mesh;
+			InstancedMeshComponent* instmesh;
+			TerrainComponent* terrain;
+			Transform* transform;
+			uint64_t instanceKey; // zero if mesh cannot be instanced automatically
+			uint64_t materialKey; // checked every frame, materials change without queue updates
+			InstanceGroup* instanceGroup;
+		};
+
+		struct RenderQueueKey{
+			uint64_t key;
+			uint32_t item;
+		};
+
+		struct MeshSpatialData{
+			int32_t proxy;
+			uint32_t queueIndex;
+		};
+
+		struct LightCasterCache{
+			// render queue bits of meshes inside each light camera
+			std::vector<uint64_t> casters[6];
+			Matrix4 viewProjection[6];
+			uint64_t queueRevision = 0;
+			uint64_t casterRevision = 0;
+			uint64_t frame = 0;
+			bool changed[6];
+
+			// state of the shadow map content, kept while nothing inside it changes
+			bool rendered[6];
+			Matrix4 renderedViewProjection[6];
+			Vector2 renderedNearFar[6];
+			uint64_t renderedCasters[6];
+			uint64_t dirtyFrame[6];
+		};
+
+		struct ShadowView{
+			LightComponent* light;
+			LightCasterCache* cache;
+			int camera;
+			size_t begin;
+			size_t end;
+		};
+
 		struct MeshComparison{
 			bool const operator()(const TransparentMeshesData& lhs, const TransparentMeshesData& rhs) const{
 				return lhs.distanceToCamera < rhs.distanceToCamera;
@@ -100,16 +195,138 @@ namespace Supernova{
 		fs_shadows_t fs_shadows;
 		fs_fog_t fs_fog;
 
+		// frame constant blocks are hashed once when written
+		uint64_t fsLightingHash;
+		uint64_t vsShadowsHash;
+		uint64_t fsShadowsHash;
+		uint64_t fsFogHash;
+
+		// all scene lights, only MAX_LIGHTS fit the uniform block
+		struct LightData{
+			Vector4 direction_range;
+			Vector4 color_intensity;
+			Vector4 position_type;
+			Vector4 inCon_ouCon_shadows_cascades;
+		};
+		std::vector<LightData> lightsData;
+
+		// with more than MAX_LIGHTS each object gets the most relevant lights of its clusters
+		bool clusteredLights;
+		LightCuller lightCuller;
+		std::vector<uint32_t> lightCandidates;
+		std::vector<std::pair<float, uint32_t>> lightScores;
+		fs_lighting_t fs_clusterLighting;
+		uint64_t fsClusterLightingHash;
+		uint64_t clusterLightingKey;
+		bool clusterLightingValid;
+
+		// hot hierarchy data rebuilt each frame from Transform array order
+		std::vector<size_t> transformParents;
+		std::vector<std::pair<size_t, size_t>> dirtyBranches;
+
+		std::vector<std::pair<ModelComponent*, MeshComponent*>> skinnedModels;
+
+		// meshes drawn by 3D cameras, rebuilt only when renderables change
+		std::vector<RenderQueueItem> renderQueue;
+		std::vector<RenderQueueKey> renderQueueKeys;
+		std::vector<RenderQueueKey> renderQueueKeysTemp;
+		uint64_t renderQueueVersions[4];
+		uint64_t renderQueueRevision;
+		bool needUpdateRenderQueue;
+
+		// render queue boxes culled once per camera before drawing
+		FrustumCuller meshCuller;
+		std::vector<uint64_t> visibleMeshes;
+		std::vector<uint32_t> visibleMeshIndexes;
+		unsigned int culledMeshes;
+		unsigned int drawnMeshes;
+		unsigned int skippedSkinnings;
+
+		// spatial index over mesh world bounds, leaves moved only when transforms change
+		AABBTree meshTree;
+		std::unordered_map<Entity, MeshSpatialData> meshSpatial;
+		std::unordered_set<Entity> unboundedMeshes; // AABB::ZERO, never culled
+		std::vector<int32_t> treeQueryProxies;
+		uint64_t meshSpatialVersion;
+
+		// shadow casters packed once per frame, lists cached per light while nothing moves
+		std::vector<uint32_t> shadowCasters;
+		std::vector<uint64_t> shadowCasterMask;
+		std::vector<uint64_t> previousCasterMask;
+		uint64_t shadowCasterRevision; // changed when any mesh starts or stops casting
+		FrustumCuller casterCuller;
+		std::vector<uint64_t> visibleCasters;
+		std::vector<Entity> movedCasters;
+		std::unordered_map<Entity, LightCasterCache> lightCasters;
+		std::vector<ShadowView> shadowViews;
+		std::vector<uint32_t> shadowViewMeshes;
+		std::vector<size_t> pendingShadowViews;
+		uint64_t drawFrame;
+
+		// identical static meshes grouped in one instanced draw
+		std::unordered_map<uint64_t, InstanceGroup> instanceGroups;
+		std::unordered_map<Entity, uint64_t> meshContentHashes;
+		std::vector<bool> instanceVisible;
+		bool needUpdateInstanceGroups;
+		uint64_t instancePass;
+		uint8_t meshPipelines;
+
+		// 2D sprites and UI sharing shader and textures, drawn as index ranges in hierarchy order
+		std::unordered_map<uint64_t, SpriteBatch> spriteBatches;
+		std::unordered_map<uint64_t, UIBatch> uiBatches;
+		std::vector<BatchRange> batchRanges;
+		std::vector<int32_t> transformBatchRanges; // by transform index, -1 if drawn alone
+		std::vector<std::pair<uint32_t, uint64_t>> batchCandidates;
+		std::unordered_map<uint64_t, uint32_t> batchMembers;
+		BatchRange pendingBatch;
+
 		static void changeLoaded(void* data);
 		static void changeDestroy(void* data);
 
+		void updateTransform(Transform& transform, Transform* transformParent);
+		void updateTransforms();
+		void updateSkinning();
+		void updateRenderQueue();
+		void updateMeshSpatial(Entity entity, MeshComponent& mesh);
+		void removeMeshSpatial(Entity entity);
+		void syncMeshSpatial();
+
+		uint64_t getMeshInstanceKey(Entity entity, MeshComponent& mesh, Transform& transform, InstancedMeshComponent* instmesh, TerrainComponent* terrain);
+		uint64_t getMeshMaterialKey(MeshComponent& mesh);
+		bool hasMeshTextureUpdate(MeshComponent& mesh);
+		void updateInstanceGroups();
+		void destroyInstanceGroup(InstanceGroup& group);
+		void destroyMeshCopy(MeshComponent& mesh);
+		bool drawInstanceGroup(InstanceGroup& group, CameraComponent& camera, Transform& cameraTransform, bool renderToTexture);
+
+		uint64_t getSpriteBatchKey(MeshComponent& mesh, Transform& transform);
+		uint64_t getUIBatchKey(UIComponent& ui, Transform& transform);
+		void updateBatches();
+		bool loadSpriteBatch(SpriteBatch& batch);
+		bool loadUIBatch(UIBatch& batch);
+		void destroySpriteBatch(SpriteBatch& batch);
+		void destroyUIBatch(UIBatch& batch);
+		void destroyBatches();
+		bool appendBatchVertices(Buffer& buffer, IndexBuffer& indices, Transform& transform, const Rect& textureRect, const Vector4& color, InterleavedBuffer& batchBuffer, IndexBuffer& batchIndices, BatchRange& range);
+		bool addBatchRange(int32_t range, CameraComponent& camera, Transform& cameraTransform, bool renderToTexture);
+		void flushBatch(CameraComponent& camera, Transform& cameraTransform, bool renderToTexture);
+
+		void updateShadowCasters();
+		const std::vector<uint64_t>& cullShadowCasters(LightCasterCache& cache, int index, LightCamera& lightCamera);
+
+		void cullRenderQueue(const float cameraFar, const Plane frustumPlanes[6]);
+		size_t sortRenderQueue(CameraComponent& camera);
+		void drawRenderQueue(size_t begin, size_t end, CameraComponent& camera, Transform& cameraTransform, bool renderToTexture);
+		static void radixSort(std::vector<RenderQueueKey>& keys, std::vector<RenderQueueKey>& temp);
+
 		void updateMVP(size_t index, Transform& transform, CameraComponent& camera, Transform& cameraTransform);
 
 		void createFramebuffer(CameraComponent& camera);
 		void createEmptyTextures();
 		int checkLightsAndShadow();
 		bool loadLights(int numLights);
-		void processLights(Transform& cameraTransform);
+		void processLights(CameraComponent& camera, Transform& cameraTransform);
+		fs_lighting_t* selectLights(const AABB& box, uint64_t& hash);
 		bool loadAndProcessFog();
 		TextureShaderType getShadowMapByIndex(int index);
 		TextureShaderType getShadowMapCubeByIndex(int index);
@@ -131,7 +348,7 @@ namespace Supernova{
 	protected:
 
 		bool drawMesh(MeshComponent& mesh, Transform& transform, CameraComponent& camera, Transform& camTransform, bool renderToTexture, InstancedMeshComponent* instmesh, TerrainComponent* terrain);
-		bool drawMeshDepth(MeshComponent& mesh, const float cameraFar, const Plane frustumPlanes[6], vs_depth_t vsDepthParams, InstancedMeshComponent* instmesh, TerrainComponent* terrain);
+		bool drawMeshDepth(MeshComponent& mesh, vs_depth_t vsDepthParams, InstancedMeshComponent* instmesh, TerrainComponent* terrain);
 		void destroyMesh(Entity entity, MeshComponent& mesh);
 
 		bool drawUI(UIComponent& uirender, Transform& transform, bool renderToTexture);
@@ -180,6 +397,19 @@ namespace Supernova{
 		bool isInsideCamera(CameraComponent& camera, const AABB& box);
 		bool isInsideCamera(CameraComponent& camera, const Vector3& point);
 		bool isInsideCamera(CameraComponent& camera, const Vector3& center, const float& radius);
+
+		// meshes in the last drawn frame, summed over all camera and shadow passes
+		unsigned int getCulledMeshes() const;
+		unsigned int getDrawnMeshes() const;
+		// skeletons with palette paused by animation level of detail in last update
+		unsigned int getSkippedSkinnings() const;
+
+		// spatial queries over mesh world bounds, candidates use enlarged boxes
+		const AABBTree& getMeshTree() const;
+		void findMeshes(const AABB& box, std::vector<Entity>& result) const;
+		void findMeshes(const Sphere& sphere, std::vector<Entity>& result) const;
+		void findMeshes(CameraComponent& camera, std::vector<Entity>& result) const;
+		void findMeshes(const Vector3& origin, const Vector3& direction, std::vector<Entity>& result) const;
 	
 		virtual void load();
 		virtual void destroy();
@@ -1122,52 +1122,46 @@ Rect UISystem::fitOnPanel(Rect uiRect, Entity parentPanel){
 
 void UISystem::update(double dt){
 
-    // need to be ordered by Transform
-    auto layouts = scene->getComponentArray<UILayoutComponent>();
-
-    for (int i = 0; i < layouts->size(); i++){
-        UILayoutComponent& layout = layouts->getComponentFromIndex(i);
-        Entity entity = layouts->getEntity(i);
-        Signature signature = scene->getSignature(entity);
-
-        if (signature.test(scene->getComponentId<UIContainerComponent>())){
-            UIContainerComponent& container = scene->getComponent<UIContainerComponent>(entity);
-            // reseting all container boxes
-            for (int b = 0; b < container.numBoxes; b++){
-                container.boxes[b].layout = NULL_ENTITY;
-            }
-            container.numBoxes = 0;
+    // reseting all container boxes
+    for (auto [entity, container] : scene->view<UIContainerComponent>()){
+        for (int b = 0; b < container.numBoxes; b++){
+            container.boxes[b].layout = NULL_ENTITY;
         }
+        container.numBoxes = 0;
+    }
 
-        if (signature.test(scene->getComponentId<Transform>())){
-            Transform& transform = scene->getComponent<Transform>(entity);
-            UILayoutComponent* parentlayout = scene->findComponent<UILayoutComponent>(transform.parent);
-            if (parentlayout){
-                UIContainerComponent* parentcontainer = scene->findComponent<UIContainerComponent>(transform.parent);
-                if (parentcontainer && transform.visible){
-                    if (parentcontainer->numBoxes < MAX_CONTAINER_BOXES){
-                        layout.containerBoxIndex = parentcontainer->numBoxes;
-                        if (!layout.usingAnchors){
-                            layout.anchorPreset = AnchorPreset::TOP_LEFT;
-                            layout.usingAnchors = true;
-                        }
-                        parentcontainer->boxes[layout.containerBoxIndex].layout = entity;
+    auto layouts = scene->getComponentArray<UILayoutComponent>();
+    auto containers = scene->getComponentArray<UIContainerComponent>();
+    auto panels = scene->getComponentArray<PanelComponent>();
 
-                        parentcontainer->numBoxes = parentcontainer->numBoxes + 1;
-                    }else{
-                        transform.parent = NULL_ENTITY;
-                        Log::error("The UI container has exceeded the maximum allowed of %i children. Please, increase MAX_CONTAINER_BOXES value.", MAX_CONTAINER_BOXES);
+    // need to be ordered by Transform
+    for (auto [entity, layout, transform] : scene->view<UILayoutComponent, Transform>()){
+        UILayoutComponent* parentlayout = layouts->findComponent(transform.parent);
+        if (parentlayout){
+            UIContainerComponent* parentcontainer = containers->findComponent(transform.parent);
+            if (parentcontainer && transform.visible){
+                if (parentcontainer->numBoxes < MAX_CONTAINER_BOXES){
+                    layout.containerBoxIndex = parentcontainer->numBoxes;
+                    if (!layout.usingAnchors){
+                        layout.anchorPreset = AnchorPreset::TOP_LEFT;
+                        layout.usingAnchors = true;
                     }
-                }
+                    parentcontainer->boxes[layout.containerBoxIndex].layout = entity;
 
-                PanelComponent* parentpanel = scene->findComponent<PanelComponent>(transform.parent);
-                if (parentpanel){
-                    layout.panel = transform.parent;
+                    parentcontainer->numBoxes = parentcontainer->numBoxes + 1;
+                }else{
+                    transform.parent = NULL_ENTITY;
+                    Log::error("The UI container has exceeded the maximum allowed of %i children. Please, increase MAX_CONTAINER_BOXES value.", MAX_CONTAINER_BOXES);
                 }
+            }
 
-                if (parentlayout->panel != NULL_ENTITY){
-                    layout.panel = parentlayout->panel;
-                }
+            PanelComponent* parentpanel = panels->findComponent(transform.parent);
+            if (parentpanel){
+                layout.panel = transform.parent;
+            }
+
+            if (parentlayout->panel != NULL_ENTITY){
+                layout.panel = parentlayout->panel;
             }
         }
     }
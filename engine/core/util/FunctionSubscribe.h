@@ -180,6 +180,10 @@ namespace Supernova {
             functions.clear();
             tags.clear();
         }
+
+        bool empty() const{
+            return functions.empty();
+        }
     };
 }
 
@@ -0,0 +1,118 @@
+//
+// (c) 2024 Eduardo Doria.
+//
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace Supernova;
+
+ThreadPool::ThreadPool(size_t numWorkers){
+    stopping = false;
+
+    for (size_t i = 0; i < numWorkers; i++){
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+
+    for (std::thread& worker : workers){
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance(){
+    // main thread also works, so one less worker than hardware threads
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+size_t ThreadPool::getNumWorkers() const{
+    return workers.size();
+}
+
+bool ThreadPool::runNextJob(std::unique_lock<std::mutex>& lock){
+    if (jobs.empty()){
+        return false;
+    }
+
+    Job job = std::move(jobs.front());
+    jobs.pop_front();
+
+    std::exception_ptr error;
+
+    lock.unlock();
+    try{
+        job.func();
+    }catch (...){
+        error = std::current_exception();
+    }
+    lock.lock();
+
+    if (error && !*job.error){
+        *job.error = error;
+    }
+
+    // always counted, otherwise caller waits forever
+    if (--(*job.pending) == 0){
+        condition.notify_all();
+    }
+
+    return true;
+}
+
+void ThreadPool::workerLoop(){
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true){
+        condition.wait(lock, [this]{ return stopping || !jobs.empty(); });
+
+        if (stopping && jobs.empty()){
+            return;
+        }
+
+        runNextJob(lock);
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t minBatch, const std::function<void(size_t begin, size_t end)>& func){
+    if (count == 0){
+        return;
+    }
+
+    size_t numThreads = workers.size() + 1;
+    size_t batch = std::max(std::max(minBatch, (size_t)1), (count + numThreads - 1) / numThreads);
+
+    if (workers.empty() || batch >= count){
+        func(0, count);
+        return;
+    }
+
+    std::atomic<size_t> pending((count + batch - 1) / batch);
+    std::exception_ptr error;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (size_t begin = 0; begin < count; begin += batch){
+        size_t end = std::min(begin + batch, count);
+        jobs.push_back({[&func, begin, end](){ func(begin, end); }, &pending, &error});
+    }
+    condition.notify_all();
+
+    // helping with queued jobs also allows nested parallelFor calls
+    while (pending > 0){
+        if (!runNextJob(lock)){
+            condition.wait(lock, [this, &pending]{ return pending == 0 || !jobs.empty(); });
+        }
+    }
+
+    if (error){
+        lock.unlock();
+        std::rethrow_exception(error);
+    }
+}
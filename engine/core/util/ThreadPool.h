@@ -0,0 +1,52 @@
+//
+// (c) 2024 Eduardo Doria.
+//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Supernova {
+
+    // Engine wide worker pool, calling thread also runs jobs while waiting
+    class ThreadPool {
+    private:
+        struct Job{
+            std::function<void()> func;
+            std::atomic<size_t>* pending;
+            std::exception_ptr* error; // first exception of its parallelFor
+        };
+
+        std::vector<std::thread> workers;
+        std::deque<Job> jobs;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stopping;
+
+        bool runNextJob(std::unique_lock<std::mutex>& lock);
+        void workerLoop();
+
+    public:
+        ThreadPool(size_t numWorkers);
+        virtual ~ThreadPool();
+
+        static ThreadPool& instance();
+
+        size_t getNumWorkers() const;
+
+        // Splits [0, count) in batches of at least minBatch and blocks until all are done
+        // an exception thrown by a batch is rethrown in calling thread after all batches finish
+        void parallelFor(size_t count, size_t minBatch, const std::function<void(size_t begin, size_t end)>& func);
+    };
+
+}
+
+#endif //THREADPOOL_H
@@ -9,14 +9,29 @@
 
 using namespace Supernova;
 
+sg_buffer SokolBuffer::streamBuffer = {SG_INVALID_ID};
+size_t SokolBuffer::streamCapacity = 0;
+size_t SokolBuffer::streamUsed = 0;
+size_t SokolBuffer::streamRequired = 0;
+std::unordered_map<uint32_t, int> SokolBuffer::streamOffsets;
+uint64_t SokolBuffer::frame = 1;
+uint32_t SokolBuffer::frameUploadBytes = 0;
+uint32_t SokolBuffer::uploadBytes = 0;
+
 SokolBuffer::SokolBuffer(){
     buffer.id = SG_INVALID_ID;
+    type = BufferType::VERTEX_BUFFER;
+    updateFrame = 0;
+    uploaded = false;
 }
 
-SokolBuffer::SokolBuffer(const SokolBuffer& rhs): buffer(rhs.buffer) {}
+SokolBuffer::SokolBuffer(const SokolBuffer& rhs): buffer(rhs.buffer), type(rhs.type), updateFrame(rhs.updateFrame), uploaded(rhs.uploaded) {}
 
 SokolBuffer& SokolBuffer::operator=(const SokolBuffer& rhs){
     buffer = rhs.buffer;
+    type = rhs.type;
+    updateFrame = rhs.updateFrame;
+    uploaded = rhs.uploaded;
     return *this;
 }
 
@@ -38,6 +53,10 @@ bool SokolBuffer::createBuffer(unsigned int size, void* data, BufferType type, B
         vbuf_desc.type = SG_BUFFERTYPE_STORAGEBUFFER;
     }
 
+    this->type = type;
+    updateFrame = 0;
+    uploaded = (usage == BufferUsage::IMMUTABLE);
+
     if (usage == BufferUsage::IMMUTABLE){
         vbuf_desc.usage = SG_USAGE_IMMUTABLE;
     }else if (usage == BufferUsage::DYNAMIC){
@@ -63,15 +82,40 @@ bool SokolBuffer::createBuffer(unsigned int size, void* data, BufferType type, B
     return false;
 }
 
-// called by draw
-void SokolBuffer::updateBuffer(unsigned int size, void* data){
+// called by draw, returns false when data was not sent
+bool SokolBuffer::updateBuffer(unsigned int size, void* data){
     if (buffer.id != SG_INVALID_ID && data && size > 0){
-        if (Engine::isAsyncThread()){
-            SokolCmdQueue::add_command_update_buffer(buffer, {data, (size_t)size});
+        if (updateFrame != frame){
+            if (Engine::isAsyncThread()){
+                SokolCmdQueue::add_command_update_buffer(buffer, {data, (size_t)size});
+            }else{
+                sg_update_buffer(buffer, {data, (size_t)size});
+            }
+            updateFrame = frame;
+            streamOffsets.erase(buffer.id);
+        }else if (type == BufferType::VERTEX_BUFFER){
+            // second upload in same frame, for example points sorted for another camera
+            int offset;
+            if (appendStream(size, data, offset)){
+                streamOffsets[buffer.id] = offset;
+                // own buffer keeps older data, next frame must upload again
+                uploaded = false;
+                frameUploadBytes += size;
+                return true;
+            }
+            return false;
         }else{
-            sg_update_buffer(buffer, {data, (size_t)size});
+            Log::warn("Buffer %u already updated in this frame", buffer.id);
+            return false;
         }
+
+        uploaded = true;
+        frameUploadBytes += size;
+
+        return true;
     }
+
+    return false;
 }
 
 void SokolBuffer::destroyBuffer(){
@@ -83,9 +127,95 @@ void SokolBuffer::destroyBuffer(){
         }
     }
 
+    streamOffsets.erase(buffer.id);
+
     buffer.id = SG_INVALID_ID;
+    uploaded = false;
+}
+
+bool SokolBuffer::isUploaded() const{
+    return uploaded;
 }
 
 sg_buffer SokolBuffer::get(){
     return buffer;
+}
+
+bool SokolBuffer::appendStream(unsigned int size, void* data, int& offset){
+    // appends are 4 bytes aligned
+    size_t alignedSize = (size + 3) & ~(size_t)3;
+
+    if (streamBuffer.id == SG_INVALID_ID || streamUsed + alignedSize > streamCapacity){
+        // ring grows in next frame, this upload is lost
+        streamRequired += alignedSize;
+        return false;
+    }
+
+    // same offset returned by sokol, appends start at zero in each frame
+    // it is known here even when append is recorded to render thread
+    offset = (int)streamUsed;
+    streamUsed += alignedSize;
+
+    if (Engine::isAsyncThread()){
+        SokolCmdQueue::add_command_append_buffer(streamBuffer, {data, (size_t)size});
+    }else{
+        sg_append_buffer(streamBuffer, {data, (size_t)size});
+    }
+
+    return true;
+}
+
+bool SokolBuffer::hasStreamBindings(){
+    return !streamOffsets.empty();
+}
+
+bool SokolBuffer::getStreamBinding(uint32_t id, sg_buffer& buffer, int& offset){
+    auto it = streamOffsets.find(id);
+    if (it == streamOffsets.end()){
+        return false;
+    }
+
+    buffer = streamBuffer;
+    offset = it->second;
+
+    return true;
+}
+
+void SokolBuffer::endFrame(){
+    if (streamRequired > 0 && sg_isvalid()){
+        size_t capacity = (streamCapacity > 0) ? streamCapacity : 64 * 1024;
+        while (capacity < streamCapacity + streamRequired){
+            capacity *= 2;
+        }
+
+        sg_buffer_desc desc = {0};
+        desc.size = capacity;
+        desc.type = SG_BUFFERTYPE_VERTEXBUFFER;
+        desc.usage = SG_USAGE_STREAM;
+
+        if (Engine::isAsyncThread()){
+            if (streamBuffer.id != SG_INVALID_ID){
+                SokolCmdQueue::add_command_destroy_buffer(streamBuffer);
+            }
+            streamBuffer = SokolCmdQueue::add_command_make_buffer(desc);
+        }else{
+            if (streamBuffer.id != SG_INVALID_ID){
+                sg_destroy_buffer(streamBuffer);
+            }
+            streamBuffer = sg_make_buffer(desc);
+        }
+        streamCapacity = (streamBuffer.id != SG_INVALID_ID) ? capacity : 0;
+    }
+
+    streamUsed = 0;
+    streamRequired = 0;
+    streamOffsets.clear();
+    frame++;
+
+    uploadBytes = frameUploadBytes;
+    frameUploadBytes = 0;
+}
+
+uint32_t SokolBuffer::getUploadBytes(){
+    return uploadBytes;
 }
\ No newline at end of file
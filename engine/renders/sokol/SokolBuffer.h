@@ -8,12 +8,28 @@
 #include "render/Render.h"
 
 #include "sokol_gfx.h"
+#include <unordered_map>
 
 namespace Supernova{
     class SokolBuffer{
 
     private:
         sg_buffer buffer;
+        BufferType type;
+        uint64_t updateFrame; // sokol allows only one update per buffer and frame
+        bool uploaded;
+
+        // shared stream buffer for repeated uploads in same frame, data is appended and bound with offsets
+        static sg_buffer streamBuffer;
+        static size_t streamCapacity;
+        static size_t streamUsed;
+        static size_t streamRequired;
+        static std::unordered_map<uint32_t, int> streamOffsets;
+        static uint64_t frame;
+        static uint32_t frameUploadBytes;
+        static uint32_t uploadBytes;
+
+        static bool appendStream(unsigned int size, void* data, int& offset);
 
     public:
         SokolBuffer();
@@ -21,10 +37,19 @@ namespace Supernova{
         SokolBuffer& operator=(const SokolBuffer& rhs);
 
         bool createBuffer(unsigned int size, void* data, BufferType type, BufferUsage usage);
-        void updateBuffer(unsigned int size, void* data);
+        bool updateBuffer(unsigned int size, void* data);
         void destroyBuffer();
 
+        bool isUploaded() const;
+
         sg_buffer get();
+
+        // replaces buffer by its stream copy of this frame, if any
+        static bool hasStreamBindings();
+        static bool getStreamBinding(uint32_t id, sg_buffer& buffer, int& offset);
+
+        static void endFrame();
+        static uint32_t getUploadBytes();
     };
 }
 
@@ -6,6 +6,8 @@
 
 #include "System.h"
 #include "SokolCmdQueue.h"
+#include "SokolObject.h"
+#include "Engine.h"
 
 #include "sokol_gfx.h"
 
@@ -34,35 +36,60 @@ void SokolCamera::setClearColor(Vector4 clearColor){
 
 void SokolCamera::startRenderPass(FramebufferRender* framebuffer, size_t face){
     pass.attachments = framebuffer->backend.get(face);
-    //SokolCmdQueue::add_command_begin_pass(pass);
-    sg_begin_pass(pass);
+    if (Engine::isAsyncThread()){
+        SokolCmdQueue::add_command_begin_pass(pass);
+    }else{
+        sg_begin_pass(pass);
+    }
+    SokolObject::beginPass();
 }
 
 void SokolCamera::startRenderPass(int width, int height){
-    pass.swapchain = System::instance().getSokolSwapchain();
-    pass.swapchain.width = width;
-    pass.swapchain.height = height;
-    //SokolCmdQueue::add_command_begin_pass(pass);
-    sg_begin_pass(pass);
+    if (Engine::isAsyncThread()){
+        pass.swapchain = {0};
+        pass.swapchain.width = width;
+        pass.swapchain.height = height;
+        SokolCmdQueue::add_command_begin_swapchain_pass(pass);
+    }else{
+        pass.swapchain = System::instance().getSokolSwapchain();
+        pass.swapchain.width = width;
+        pass.swapchain.height = height;
+        sg_begin_pass(pass);
+    }
+    SokolObject::beginPass();
 }
 
 void SokolCamera::startRenderPass(){
-    pass.swapchain = System::instance().getSokolSwapchain();
-    //SokolCmdQueue::add_command_begin_pass(pass);
-    sg_begin_pass(pass);
+    if (Engine::isAsyncThread()){
+        pass.swapchain = {0};
+        SokolCmdQueue::add_command_begin_swapchain_pass(pass);
+    }else{
+        pass.swapchain = System::instance().getSokolSwapchain();
+        sg_begin_pass(pass);
+    }
+    SokolObject::beginPass();
 }
 
 void SokolCamera::applyViewport(Rect rect){
-    //SokolCmdQueue::add_command_apply_viewport((int)rect.getX(), (int)rect.getY(), (int)rect.getWidth(), (int)rect.getHeight(), false);
-    sg_apply_viewport((int)rect.getX(), (int)rect.getY(), (int)rect.getWidth(), (int)rect.getHeight(), false);
+    if (Engine::isAsyncThread()){
+        SokolCmdQueue::add_command_apply_viewport((int)rect.getX(), (int)rect.getY(), (int)rect.getWidth(), (int)rect.getHeight(), false);
+    }else{
+        sg_apply_viewport((int)rect.getX(), (int)rect.getY(), (int)rect.getWidth(), (int)rect.getHeight(), false);
+    }
 }
 
 void SokolCamera::applyScissor(Rect rect){
-    //SokolCmdQueue::add_command_apply_scissor_rect((int)rect.getX(), (int)rect.getY(), (int)rect.getWidth(), (int)rect.getHeight(), false);
-    sg_apply_scissor_rect((int)rect.getX(), (int)rect.getY(), (int)rect.getWidth(), (int)rect.getHeight(), false);
+    if (Engine::isAsyncThread()){
+        SokolCmdQueue::add_command_apply_scissor_rect((int)rect.getX(), (int)rect.getY(), (int)rect.getWidth(), (int)rect.getHeight(), false);
+    }else{
+        sg_apply_scissor_rect((int)rect.getX(), (int)rect.getY(), (int)rect.getWidth(), (int)rect.getHeight(), false);
+    }
 }
 
 void SokolCamera::endRenderPass(){
-    //SokolCmdQueue::add_command_end_pass();
-    sg_end_pass();
+    if (Engine::isAsyncThread()){
+        SokolCmdQueue::add_command_end_pass();
+    }else{
+        sg_end_pass();
+    }
 }
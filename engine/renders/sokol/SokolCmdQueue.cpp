@@ -7,14 +7,17 @@
 #include <cstring>
 #include <algorithm>
 #include <cassert>
+#include <new>
 
 #include "SokolCmdQueue.h"
+#include "System.h"
 
 using namespace Supernova;
 
 // ----------------------------------------------------------------------------------------------------
 
-std::vector<SokolRenderCommand> SokolCmdQueue::m_commands[2];
+std::vector<uint8_t> SokolCmdQueue::m_commands[2];
+std::vector<uint8_t> SokolCmdQueue::m_data[2];
 int32_t SokolCmdQueue::m_pending_commands_index = 0;
 int32_t SokolCmdQueue::m_commit_commands_index = 1;
 std::vector<SokolRenderCleanup> SokolCmdQueue::m_cleanups;
@@ -23,6 +26,8 @@ Semaphore SokolCmdQueue::m_render_semaphore;
 std::atomic<bool> SokolCmdQueue::m_flushing = false;
 std::atomic<bool> SokolCmdQueue::m_commited = false;
 std::mutex SokolCmdQueue::m_execute_mutex;
+std::mutex SokolCmdQueue::m_cleanup_mutex;
+std::mutex SokolCmdQueue::m_record_mutex;
 int32_t SokolCmdQueue::m_frame_index = 0;
 
 
@@ -30,8 +35,11 @@ int32_t SokolCmdQueue::m_frame_index = 0;
 
 // ----------------------------------------------------------------------------------------------------
 
-constexpr int32_t INITIAL_NUMBER_OF_COMMANDS = 256;
+constexpr size_t INITIAL_COMMANDS_SIZE = 16 * 1024;
 constexpr int32_t INITIAL_NUMBER_OF_CLEANUPS = 64;
+constexpr size_t INITIAL_DATA_SIZE = 64 * 1024;
+constexpr size_t DATA_ALIGNMENT = 16;
+constexpr size_t COMMAND_ALIGNMENT = 8;
 
 // ----------------------------------------------------------------------------------------------------
 
@@ -40,7 +48,10 @@ void SokolCmdQueue::start(){
 	for (int32_t i = 0; i < 2; i ++)
 	{
 		// reserve commands
-		m_commands[i].reserve(INITIAL_NUMBER_OF_COMMANDS);
+		m_commands[i].reserve(INITIAL_COMMANDS_SIZE);
+
+		// reserve data
+		m_data[i].reserve(INITIAL_DATA_SIZE);
 	}
 
 	// reserve cleamups
@@ -59,13 +70,13 @@ void SokolCmdQueue::finish(){
 
 // ----------------------------------------------------------------------------------------------------
 
-void SokolCmdQueue::execute_commands(bool resource_only)
+void SokolCmdQueue::execute_commands(bool resource_only, bool wait_commit)
 {
 	// increase frame index
 	m_frame_index ++;
 
-	// not commited? exit
-	if (!m_commited)
+	// not commited and not waiting for it? exit
+	if (!m_commited && !wait_commit)
 	{
 		return;
 	}
@@ -81,11 +92,18 @@ void SokolCmdQueue::execute_commands(bool resource_only)
 		// lock execute mutex
 		std::scoped_lock<std::mutex> lock(m_execute_mutex);
 
+		// commands stream
+		const std::vector<uint8_t>& commands = m_commands[m_commit_commands_index];
+
 		// loop through commands
-		for (const auto& command : m_commands[m_commit_commands_index])
+		for (size_t pos = 0; pos < commands.size();)
 		{
-			// ignore command?
-			if (resource_only && !(command.type >= SokolRenderCommand::TYPE::MAKE_BUFFER && command.type <= SokolRenderCommand::TYPE::DESTROY_ATTACHMENTS))
+			// get command and move to next one
+			const SokolRenderCommand& command = *reinterpret_cast<const SokolRenderCommand*>(&commands[pos]);
+			pos += command.size;
+
+			// ignore command? resource replay keeps uploads and custom callbacks, only passes are dropped
+			if (resource_only && command.type >= SokolRenderCommand::TYPE::BEGIN_PASS && command.type <= SokolRenderCommand::TYPE::COMMIT)
 			{
 				continue;
 			}
@@ -94,77 +112,135 @@ void SokolCmdQueue::execute_commands(bool resource_only)
 			switch (command.type)
 			{
 			case SokolRenderCommand::TYPE::PUSH_DEBUG_GROUP:
-				sg_push_debug_group(command.push_debug_group.name);
+				sg_push_debug_group(command.args<SokolRenderCommand::PushDebugGroup>().name);
 				break;
 			case SokolRenderCommand::TYPE::POP_DEBUG_GROUP:
 				sg_pop_debug_group();
 				break;
 			case SokolRenderCommand::TYPE::MAKE_BUFFER:
-				sg_init_buffer(command.make_buffer.buffer, command.make_buffer.desc);
+			{
+				const auto& args = command.args<SokolRenderCommand::MakeBuffer>();
+				sg_buffer_desc desc = *static_cast<const sg_buffer_desc*>(get_data(args.desc_offset));
+				if (args.has_data)
+				{
+					desc.data.ptr = get_data(args.data_offset);
+				}
+				sg_init_buffer(args.buffer, desc);
 				break;
+			}
 			case SokolRenderCommand::TYPE::MAKE_IMAGE:
-				sg_init_image(command.make_image.image, command.make_image.desc);
+			{
+				const auto& args = command.args<SokolRenderCommand::MakeImage>();
+				sg_init_image(args.image, *static_cast<const sg_image_desc*>(get_data(args.desc_offset)));
 				break;
+			}
 			case SokolRenderCommand::TYPE::MAKE_SAMPLER:
-				sg_init_sampler(command.make_sampler.sampler, command.make_sampler.desc);
+			{
+				const auto& args = command.args<SokolRenderCommand::MakeSampler>();
+				sg_init_sampler(args.sampler, *static_cast<const sg_sampler_desc*>(get_data(args.desc_offset)));
 				break;
+			}
 			case SokolRenderCommand::TYPE::MAKE_SHADER:
-				sg_init_shader(command.make_shader.shader, command.make_shader.desc);
+			{
+				const auto& args = command.args<SokolRenderCommand::MakeShader>();
+				sg_init_shader(args.shader, *static_cast<const sg_shader_desc*>(get_data(args.desc_offset)));
 				break;
+			}
 			case SokolRenderCommand::TYPE::MAKE_PIPELINE:
-				sg_init_pipeline(command.make_pipeline.pipeline, command.make_pipeline.desc);
+			{
+				const auto& args = command.args<SokolRenderCommand::MakePipeline>();
+				sg_init_pipeline(args.pipeline, *static_cast<const sg_pipeline_desc*>(get_data(args.desc_offset)));
 				break;
+			}
 			case SokolRenderCommand::TYPE::MAKE_ATTACHMENTS:
-				sg_init_attachments(command.make_attachments.attachments, command.make_attachments.desc);
+			{
+				const auto& args = command.args<SokolRenderCommand::MakeAttachments>();
+				sg_init_attachments(args.attachments, *static_cast<const sg_attachments_desc*>(get_data(args.desc_offset)));
 				break;
+			}
 			case SokolRenderCommand::TYPE::DESTROY_BUFFER:
-				sg_uninit_buffer(command.destroy_buffer.buffer);
+				sg_uninit_buffer(command.args<SokolRenderCommand::DestroyBuffer>().buffer);
 				break;
 			case SokolRenderCommand::TYPE::DESTROY_IMAGE:
-				sg_uninit_image(command.destroy_image.image);
+				sg_uninit_image(command.args<SokolRenderCommand::DestroyImage>().image);
 				break;
 			case SokolRenderCommand::TYPE::DESTROY_SAMPLER:
-				sg_uninit_sampler(command.destroy_sampler.sampler);
+				sg_uninit_sampler(command.args<SokolRenderCommand::DestroySampler>().sampler);
 				break;
 			case SokolRenderCommand::TYPE::DESTROY_SHADER:
-				sg_uninit_shader(command.destroy_shader.shader);
+				sg_uninit_shader(command.args<SokolRenderCommand::DestroyShader>().shader);
 				break;
 			case SokolRenderCommand::TYPE::DESTROY_PIPELINE:
-				sg_uninit_pipeline(command.destroy_pipeline.pipeline);
+				sg_uninit_pipeline(command.args<SokolRenderCommand::DestroyPipeline>().pipeline);
 				break;
 			case SokolRenderCommand::TYPE::DESTROY_ATTACHMENTS:
-				sg_uninit_attachments(command.destroy_attachments.attachments);
+				sg_uninit_attachments(command.args<SokolRenderCommand::DestroyAttachments>().attachments);
 				break;
 			case SokolRenderCommand::TYPE::UPDATE_BUFFER:
-				sg_update_buffer(command.update_buffer.buffer, command.update_buffer.data);
+			{
+				const auto& args = command.args<SokolRenderCommand::UpdateBuffer>();
+				sg_update_buffer(args.buffer, { get_data(args.data_offset), args.data_size });
 				break;
+			}
 			case SokolRenderCommand::TYPE::APPEND_BUFFER:
-				sg_append_buffer(command.append_buffer.buffer, command.append_buffer.data);
+			{
+				const auto& args = command.args<SokolRenderCommand::AppendBuffer>();
+				sg_append_buffer(args.buffer, { get_data(args.data_offset), args.data_size });
 				break;
+			}
 			case SokolRenderCommand::TYPE::UPDATE_IMAGE:
-				sg_update_image(command.update_image.image, command.update_image.data);
+			{
+				const auto& args = command.args<SokolRenderCommand::UpdateImage>();
+				sg_update_image(args.image, *static_cast<const sg_image_data*>(get_data(args.data_desc_offset)));
 				break;
+			}
 			case SokolRenderCommand::TYPE::BEGIN_PASS:
-				sg_begin_pass(command.begin_pass.pass);
+			{
+				const auto& args = command.args<SokolRenderCommand::BeginPass>();
+				sg_pass pass = *static_cast<const sg_pass*>(get_data(args.pass_offset));
+				if (args.swapchain)
+				{
+					sg_swapchain swapchain = System::instance().getSokolSwapchain();
+					if (pass.swapchain.width > 0 && pass.swapchain.height > 0)
+					{
+						swapchain.width = pass.swapchain.width;
+						swapchain.height = pass.swapchain.height;
+					}
+					pass.swapchain = swapchain;
+				}
+				sg_begin_pass(pass);
 				break;
+			}
 			case SokolRenderCommand::TYPE::APPLY_VIEWPORT:
-				sg_apply_viewport(command.apply_viewport.x, command.apply_viewport.y, command.apply_viewport.width, command.apply_viewport.height, command.apply_viewport.origin_top_left);
+			{
+				const auto& args = command.args<SokolRenderCommand::ApplyViewport>();
+				sg_apply_viewport(args.x, args.y, args.width, args.height, args.origin_top_left);
 				break;
+			}
 			case SokolRenderCommand::TYPE::APPLY_SCISSOR_RECT:
-				sg_apply_scissor_rect(command.apply_scissor_rect.x, command.apply_scissor_rect.y, command.apply_scissor_rect.width, command.apply_scissor_rect.height, command.apply_scissor_rect.origin_top_left);
+			{
+				const auto& args = command.args<SokolRenderCommand::ApplyScissorRect>();
+				sg_apply_scissor_rect(args.x, args.y, args.width, args.height, args.origin_top_left);
 				break;
+			}
 			case SokolRenderCommand::TYPE::APPLY_PIPELINE:
-				sg_apply_pipeline(command.apply_pipeline.pipeline);
+				sg_apply_pipeline(command.args<SokolRenderCommand::ApplyPipeline>().pipeline);
 				break;
 			case SokolRenderCommand::TYPE::APPLY_BINDINGS:
-				sg_apply_bindings(command.apply_bindings.bindings);
+				sg_apply_bindings(command.args<SokolRenderCommand::ApplyBindings>().bindings);
 				break;
 			case SokolRenderCommand::TYPE::APPLY_UNIFORMS:
-				sg_apply_uniforms(command.apply_uniforms.stage, command.apply_uniforms.ub_index, { command.apply_uniforms.buf, command.apply_uniforms.data_size });
+			{
+				const auto& args = command.args<SokolRenderCommand::ApplyUniforms>();
+				sg_apply_uniforms(args.stage, args.ub_index, { get_data(args.data_offset), args.data_size });
 				break;
+			}
 			case SokolRenderCommand::TYPE::DRAW:
-				sg_draw(command.draw.base_element, command.draw.number_of_elements, command.draw.number_of_instances);
+			{
+				const auto& args = command.args<SokolRenderCommand::Draw>();
+				sg_draw(args.base_element, args.number_of_elements, args.number_of_instances);
 				break;
+			}
 			case SokolRenderCommand::TYPE::END_PASS:
 				sg_end_pass();
 				break;
@@ -172,8 +248,11 @@ void SokolCmdQueue::execute_commands(bool resource_only)
 				sg_commit();
 				break;
 			case SokolRenderCommand::TYPE::CUSTOM:
-				command.custom.custom_cb(command.custom.custom_data);
+			{
+				const auto& args = command.args<SokolRenderCommand::Custom>();
+				args.custom_cb(args.custom_data);
 				break;
+			}
 			case SokolRenderCommand::TYPE::NOT_SET:
 				break;
 			}
@@ -209,48 +288,37 @@ void SokolCmdQueue::wait_for_flush()
 		{
 			// lock execute mutex
 			std::scoped_lock<std::mutex> lock(m_execute_mutex);
+
+			// commands stream
+			const std::vector<uint8_t>& commands = m_commands[m_commit_commands_index];
 			
 			// loop through commands
-			for (const auto& command : m_commands[m_commit_commands_index])
+			for (size_t pos = 0; pos < commands.size();)
 			{
-				// execute command
+				// get command and move to next one
+				const SokolRenderCommand& command = *reinterpret_cast<const SokolRenderCommand*>(&commands[pos]);
+				pos += command.size;
+
+				// execute command, only destroys are needed
 				switch (command.type)
 				{
-				case SokolRenderCommand::TYPE::MAKE_BUFFER:
-					//sg_init_buffer(command.make_buffer.buffer, command.make_buffer.desc);
-					break;
-				case SokolRenderCommand::TYPE::MAKE_IMAGE:
-					//sg_init_image(command.make_image.image, command.make_image.desc);
-					break;
-				case SokolRenderCommand::TYPE::MAKE_SAMPLER:
-					//sg_init_sampler(command.make_sampler.sampler, command.sampler.desc);
-					break;
-				case SokolRenderCommand::TYPE::MAKE_SHADER:
-					//sg_init_shader(command.make_shader.shader, command.make_shader.desc);
-					break;
-				case SokolRenderCommand::TYPE::MAKE_PIPELINE:
-					//sg_init_pipeline(command.make_pipeline.pipeline, command.make_pipeline.desc);
-					break;
-				case SokolRenderCommand::TYPE::MAKE_ATTACHMENTS:
-					//sg_init_attachments(command.make_attachments.attachments, command.make_attachments.desc);
-					break;
 				case SokolRenderCommand::TYPE::DESTROY_BUFFER:
-					sg_uninit_buffer(command.destroy_buffer.buffer);
+					sg_uninit_buffer(command.args<SokolRenderCommand::DestroyBuffer>().buffer);
 					break;
 				case SokolRenderCommand::TYPE::DESTROY_IMAGE:
-					sg_uninit_image(command.destroy_image.image);
+					sg_uninit_image(command.args<SokolRenderCommand::DestroyImage>().image);
 					break;
 				case SokolRenderCommand::TYPE::DESTROY_SAMPLER:
-					sg_uninit_sampler(command.destroy_sampler.sampler);
+					sg_uninit_sampler(command.args<SokolRenderCommand::DestroySampler>().sampler);
 					break;
 				case SokolRenderCommand::TYPE::DESTROY_SHADER:
-					sg_uninit_shader(command.destroy_shader.shader);
+					sg_uninit_shader(command.args<SokolRenderCommand::DestroyShader>().shader);
 					break;
 				case SokolRenderCommand::TYPE::DESTROY_PIPELINE:
-					sg_uninit_pipeline(command.destroy_pipeline.pipeline);
+					sg_uninit_pipeline(command.args<SokolRenderCommand::DestroyPipeline>().pipeline);
 					break;
 				case SokolRenderCommand::TYPE::DESTROY_ATTACHMENTS:
-					sg_uninit_attachments(command.destroy_attachments.attachments);
+					sg_uninit_attachments(command.args<SokolRenderCommand::DestroyAttachments>().attachments);
 					break;
 				default:
 					break;
@@ -268,370 +336,525 @@ void SokolCmdQueue::wait_for_flush()
 
 // ----------------------------------------------------------------------------------------------------
 
+template<typename T>
+T& SokolCmdQueue::add_command(SokolRenderCommand::TYPE::ENUM type)
+{
+	// pending commands stream
+	std::vector<uint8_t>& commands = m_commands[m_pending_commands_index];
+
+	// command size keeps next command aligned
+	size_t size = (sizeof(SokolRenderCommand) + sizeof(T) + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+	size_t offset = commands.size();
+	commands.resize(offset + size);
+
+	// add command
+	new (&commands[offset]) SokolRenderCommand(type, (uint32_t)size);
+
+	// return args
+	return *new (&commands[offset + sizeof(SokolRenderCommand)]) T();
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void SokolCmdQueue::add_command(SokolRenderCommand::TYPE::ENUM type)
+{
+	// pending commands stream
+	std::vector<uint8_t>& commands = m_commands[m_pending_commands_index];
+
+	// add command without args
+	size_t offset = commands.size();
+	commands.resize(offset + sizeof(SokolRenderCommand));
+	new (&commands[offset]) SokolRenderCommand(type, (uint32_t)sizeof(SokolRenderCommand));
+}
+
+// ----------------------------------------------------------------------------------------------------
+
 void SokolCmdQueue::add_command_push_debug_group(const char* name)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::PUSH_DEBUG_GROUP);
+	auto& args = add_command<SokolRenderCommand::PushDebugGroup>(SokolRenderCommand::TYPE::PUSH_DEBUG_GROUP);
 
 	// copy args
-	command.push_debug_group.name = name;
+	args.name = name;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_pop_debug_group()
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	/*SokolRenderCommand& command = */m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::POP_DEBUG_GROUP);
+	add_command(SokolRenderCommand::TYPE::POP_DEBUG_GROUP);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 sg_buffer SokolCmdQueue::add_command_make_buffer(const sg_buffer_desc& desc)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::MAKE_BUFFER);
+	auto& args = add_command<SokolRenderCommand::MakeBuffer>(SokolRenderCommand::TYPE::MAKE_BUFFER);
 
 	// copy args
-	command.make_buffer.desc = desc;
+	args.desc_offset = copy_data(&desc, sizeof(desc));
+	args.has_data = (desc.data.ptr != nullptr);
+	if (args.has_data)
+	{
+		args.data_offset = copy_data(desc.data.ptr, desc.data.size);
+	}
 	
 	// alloc buffer
-	command.make_buffer.buffer = sg_alloc_buffer();
+	{
+		std::scoped_lock<std::mutex> lock(m_cleanup_mutex);
+		args.buffer = sg_alloc_buffer();
+	}
 	
 	// return buffer
-	return command.make_buffer.buffer;
+	return args.buffer;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 sg_image SokolCmdQueue::add_command_make_image(const sg_image_desc& desc)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::MAKE_IMAGE);
+	auto& args = add_command<SokolRenderCommand::MakeImage>(SokolRenderCommand::TYPE::MAKE_IMAGE);
 
 	// copy args
-	command.make_image.desc = desc;
+	args.desc_offset = copy_data(&desc, sizeof(desc));
 
 	// alloc image
-	command.make_image.image = sg_alloc_image();
+	{
+		std::scoped_lock<std::mutex> lock(m_cleanup_mutex);
+		args.image = sg_alloc_image();
+	}
 	
 	// return image
-	return command.make_image.image;
+	return args.image;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 sg_sampler SokolCmdQueue::add_command_make_sampler(const sg_sampler_desc& desc)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::MAKE_SAMPLER);
+	auto& args = add_command<SokolRenderCommand::MakeSampler>(SokolRenderCommand::TYPE::MAKE_SAMPLER);
 
 	// copy args
-	command.make_sampler.desc = desc;
+	args.desc_offset = copy_data(&desc, sizeof(desc));
 
 	// alloc sampler
-	command.make_sampler.sampler = sg_alloc_sampler();
+	{
+		std::scoped_lock<std::mutex> lock(m_cleanup_mutex);
+		args.sampler = sg_alloc_sampler();
+	}
 
 	// return sampler
-	return command.make_sampler.sampler;
+	return args.sampler;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 sg_shader SokolCmdQueue::add_command_make_shader(const sg_shader_desc& desc)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::MAKE_SHADER);
+	auto& args = add_command<SokolRenderCommand::MakeShader>(SokolRenderCommand::TYPE::MAKE_SHADER);
 
 	// copy args
-	command.make_shader.desc = desc;
+	args.desc_offset = copy_data(&desc, sizeof(desc));
 
 	// alloc shader
-	command.make_shader.shader = sg_alloc_shader();
+	{
+		std::scoped_lock<std::mutex> lock(m_cleanup_mutex);
+		args.shader = sg_alloc_shader();
+	}
 	
 	// return shader
-	return command.make_shader.shader;
+	return args.shader;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 sg_pipeline SokolCmdQueue::add_command_make_pipeline(const sg_pipeline_desc& desc)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::MAKE_PIPELINE);
+	auto& args = add_command<SokolRenderCommand::MakePipeline>(SokolRenderCommand::TYPE::MAKE_PIPELINE);
 
 	// copy args
-	command.make_pipeline.desc = desc;
+	args.desc_offset = copy_data(&desc, sizeof(desc));
 
 	// alloc pipeline
-	command.make_pipeline.pipeline = sg_alloc_pipeline();
+	{
+		std::scoped_lock<std::mutex> lock(m_cleanup_mutex);
+		args.pipeline = sg_alloc_pipeline();
+	}
 	
 	// return pipeline
-	return command.make_pipeline.pipeline;
+	return args.pipeline;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 sg_attachments SokolCmdQueue::add_command_make_attachments(const sg_attachments_desc& desc)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::MAKE_ATTACHMENTS);
+	auto& args = add_command<SokolRenderCommand::MakeAttachments>(SokolRenderCommand::TYPE::MAKE_ATTACHMENTS);
 
 	// copy args
-	command.make_attachments.desc = desc;
+	args.desc_offset = copy_data(&desc, sizeof(desc));
 
 	// alloc attachments
-	command.make_attachments.attachments = sg_alloc_attachments();
+	{
+		std::scoped_lock<std::mutex> lock(m_cleanup_mutex);
+		args.attachments = sg_alloc_attachments();
+	}
 	
 	// return attachments
-	return command.make_attachments.attachments;
+	return args.attachments;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_destroy_buffer(sg_buffer buffer)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::DESTROY_BUFFER);
+	auto& args = add_command<SokolRenderCommand::DestroyBuffer>(SokolRenderCommand::TYPE::DESTROY_BUFFER);
 
 	// copy args
-	command.destroy_buffer.buffer = buffer;
+	args.buffer = buffer;
 
 	// schedule cleanup
-	schedule_cleanup(dealloc_buffer_cb, (void*)(uintptr_t)command.destroy_buffer.buffer.id);
+	schedule_cleanup(dealloc_buffer_cb, (void*)(uintptr_t)buffer.id);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_destroy_image(sg_image image)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::DESTROY_IMAGE);
+	auto& args = add_command<SokolRenderCommand::DestroyImage>(SokolRenderCommand::TYPE::DESTROY_IMAGE);
 
 	// copy args
-	command.destroy_image.image = image;
+	args.image = image;
 
 	// schedule cleanup
-	schedule_cleanup(dealloc_image_cb, (void*)(uintptr_t)command.destroy_image.image.id);
+	schedule_cleanup(dealloc_image_cb, (void*)(uintptr_t)image.id);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_destroy_sampler(sg_sampler sampler)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::DESTROY_SAMPLER);
+	auto& args = add_command<SokolRenderCommand::DestroySampler>(SokolRenderCommand::TYPE::DESTROY_SAMPLER);
 
 	// copy args
-	command.destroy_sampler.sampler = sampler;
+	args.sampler = sampler;
 
 	// schedule cleanup
-	schedule_cleanup(dealloc_sampler_cb, (void*)(uintptr_t)command.destroy_sampler.sampler.id);
+	schedule_cleanup(dealloc_sampler_cb, (void*)(uintptr_t)sampler.id);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_destroy_shader(sg_shader shader)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::DESTROY_SHADER);
+	auto& args = add_command<SokolRenderCommand::DestroyShader>(SokolRenderCommand::TYPE::DESTROY_SHADER);
 
 	// copy args
-	command.destroy_shader.shader = shader;
+	args.shader = shader;
 
 	// schedule cleanup
-	schedule_cleanup(dealloc_shader_cb, (void*)(uintptr_t)command.destroy_shader.shader.id);
+	schedule_cleanup(dealloc_shader_cb, (void*)(uintptr_t)shader.id);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_destroy_pipeline(sg_pipeline pipeline)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::DESTROY_PIPELINE);
+	auto& args = add_command<SokolRenderCommand::DestroyPipeline>(SokolRenderCommand::TYPE::DESTROY_PIPELINE);
 
 	// copy args
-	command.destroy_pipeline.pipeline = pipeline;
+	args.pipeline = pipeline;
 
 	// schedule cleanup
-	schedule_cleanup(dealloc_pipeline_cb, (void*)(uintptr_t)command.destroy_pipeline.pipeline.id);
+	schedule_cleanup(dealloc_pipeline_cb, (void*)(uintptr_t)pipeline.id);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_destroy_attachments(sg_attachments atts)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::DESTROY_ATTACHMENTS);
+	auto& args = add_command<SokolRenderCommand::DestroyAttachments>(SokolRenderCommand::TYPE::DESTROY_ATTACHMENTS);
 
 	// copy args
-	command.destroy_attachments.attachments = atts;
+	args.attachments = atts;
 
 	// schedule cleanup
-	schedule_cleanup(dealloc_attachments_cb, (void*)(uintptr_t)command.destroy_attachments.attachments.id);
+	schedule_cleanup(dealloc_attachments_cb, (void*)(uintptr_t)atts.id);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_update_buffer(sg_buffer buffer, const sg_range& data)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::UPDATE_BUFFER);
+	auto& args = add_command<SokolRenderCommand::UpdateBuffer>(SokolRenderCommand::TYPE::UPDATE_BUFFER);
 
 	// copy args
-	command.update_buffer.buffer = buffer;
-	command.update_buffer.data = data;
+	args.buffer = buffer;
+	args.data_offset = copy_data(data.ptr, data.size);
+	args.data_size = data.size;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_append_buffer(sg_buffer buffer, const sg_range& data)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::APPEND_BUFFER);
+	auto& args = add_command<SokolRenderCommand::AppendBuffer>(SokolRenderCommand::TYPE::APPEND_BUFFER);
 
 	// copy args
-	command.append_buffer.buffer = buffer;
-	command.append_buffer.data = data;
+	args.buffer = buffer;
+	args.data_offset = copy_data(data.ptr, data.size);
+	args.data_size = data.size;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_update_image(sg_image image, const sg_image_data& data)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::UPDATE_IMAGE);
+	auto& args = add_command<SokolRenderCommand::UpdateImage>(SokolRenderCommand::TYPE::UPDATE_IMAGE);
 
-	// copy args
-	command.update_image.image = image;
-	command.update_image.data = data;
+	// copy args, image pixels are kept by texture until its cleanup
+	args.image = image;
+	args.data_desc_offset = copy_data(&data, sizeof(data));
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_begin_pass(const sg_pass& pass)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
+	// add command
+	auto& args = add_command<SokolRenderCommand::BeginPass>(SokolRenderCommand::TYPE::BEGIN_PASS);
+
+	// copy args
+	args.pass_offset = copy_data(&pass, sizeof(pass));
+	args.swapchain = false;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void SokolCmdQueue::add_command_begin_swapchain_pass(const sg_pass& pass)
+{
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::BEGIN_PASS);
+	auto& args = add_command<SokolRenderCommand::BeginPass>(SokolRenderCommand::TYPE::BEGIN_PASS);
 
 	// copy args
-	command.begin_pass.pass = pass;
+	args.pass_offset = copy_data(&pass, sizeof(pass));
+	args.swapchain = true;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_apply_viewport(int x, int y, int width, int height, bool origin_top_left)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::APPLY_VIEWPORT);
+	auto& args = add_command<SokolRenderCommand::ApplyViewport>(SokolRenderCommand::TYPE::APPLY_VIEWPORT);
 
 	// copy args
-	command.apply_viewport.x = x;
-	command.apply_viewport.y = y;
-	command.apply_viewport.width = width;
-	command.apply_viewport.height = height;
-	command.apply_viewport.origin_top_left = origin_top_left;
+	args.x = x;
+	args.y = y;
+	args.width = width;
+	args.height = height;
+	args.origin_top_left = origin_top_left;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_apply_scissor_rect(int x, int y, int width, int height, bool origin_top_left)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::APPLY_SCISSOR_RECT);
+	auto& args = add_command<SokolRenderCommand::ApplyScissorRect>(SokolRenderCommand::TYPE::APPLY_SCISSOR_RECT);
 
 	// copy args
-	command.apply_scissor_rect.x = x;
-	command.apply_scissor_rect.y = y;
-	command.apply_scissor_rect.width = width;
-	command.apply_scissor_rect.height = height;
-	command.apply_scissor_rect.origin_top_left = origin_top_left;
+	args.x = x;
+	args.y = y;
+	args.width = width;
+	args.height = height;
+	args.origin_top_left = origin_top_left;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_apply_pipeline(sg_pipeline pipeline)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::APPLY_PIPELINE);
+	auto& args = add_command<SokolRenderCommand::ApplyPipeline>(SokolRenderCommand::TYPE::APPLY_PIPELINE);
 
 	// copy args
-	command.apply_pipeline.pipeline = pipeline;
+	args.pipeline = pipeline;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_apply_bindings(const sg_bindings& bindings)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::APPLY_BINDINGS);
+	auto& args = add_command<SokolRenderCommand::ApplyBindings>(SokolRenderCommand::TYPE::APPLY_BINDINGS);
 
 	// copy args
-	command.apply_bindings.bindings = bindings;
+	args.bindings = bindings;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_apply_uniforms(sg_shader_stage stage, int ub_index, const sg_range& data)
 {
-	// data size too big?
-	assert((size_t)data.size <= sizeof(SokolRenderCommand::apply_uniforms.buf));
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
 
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::APPLY_UNIFORMS);
+	auto& args = add_command<SokolRenderCommand::ApplyUniforms>(SokolRenderCommand::TYPE::APPLY_UNIFORMS);
 
 	// copy args
-	command.apply_uniforms.stage = stage;
-	command.apply_uniforms.ub_index = ub_index;
-	memcpy(command.apply_uniforms.buf, data.ptr, data.size);
-	command.apply_uniforms.data_size = data.size;
+	args.stage = stage;
+	args.ub_index = ub_index;
+	args.data_offset = copy_data(data.ptr, data.size);
+	args.data_size = data.size;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_draw(int base_element, int number_of_elements, int number_of_instances)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::DRAW);
+	auto& args = add_command<SokolRenderCommand::Draw>(SokolRenderCommand::TYPE::DRAW);
 
 	// copy args
-	command.draw.base_element = base_element;
-	command.draw.number_of_elements = number_of_elements;
-	command.draw.number_of_instances = number_of_instances;
+	args.base_element = base_element;
+	args.number_of_elements = number_of_elements;
+	args.number_of_instances = number_of_instances;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_end_pass()
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	/*SokolRenderCommand& command = */m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::END_PASS);
+	add_command(SokolRenderCommand::TYPE::END_PASS);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_commit()
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	/*SokolRenderCommand& command = */m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::COMMIT);
+	add_command(SokolRenderCommand::TYPE::COMMIT);
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::add_command_custom(void (*custom_cb)(void* custom_data), void* custom_data)
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// add command
-	SokolRenderCommand& command = m_commands[m_pending_commands_index].emplace_back(SokolRenderCommand::TYPE::CUSTOM);
+	auto& args = add_command<SokolRenderCommand::Custom>(SokolRenderCommand::TYPE::CUSTOM);
 
 	// copy args
-	command.custom.custom_cb = custom_cb;
-	command.custom.custom_data = custom_data;
+	args.custom_cb = custom_cb;
+	args.custom_data = custom_data;
 }
 
 // ----------------------------------------------------------------------------------------------------
 
 void SokolCmdQueue::schedule_cleanup(void (*cleanup_cb)(void* cleanup_data), void* cleanup_data, int32_t number_of_frames_to_defer)
 {
+	// lock cleanup mutex, update thread can schedule while render thread processes
+	std::scoped_lock<std::mutex> lock(m_cleanup_mutex);
+
 	// add cleanup
 	SokolRenderCleanup& cleanup = m_cleanups.emplace_back(cleanup_cb, cleanup_data);
 	
@@ -643,11 +866,15 @@ void SokolCmdQueue::schedule_cleanup(void (*cleanup_cb)(void* cleanup_data), voi
 
 void SokolCmdQueue::commit_commands()
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// acquire render semaphore
 	m_render_semaphore.acquire();
 	
 	// clear commands
 	m_commands[m_commit_commands_index].resize(0);
+	m_data[m_commit_commands_index].resize(0);
 	
 	// swap commands indexes
 	std::swap(m_pending_commands_index, m_commit_commands_index);
@@ -663,11 +890,15 @@ void SokolCmdQueue::commit_commands()
 
 void SokolCmdQueue::flush_commands()
 {
+	// lock record mutex
+	std::scoped_lock<std::mutex> record_lock(m_record_mutex);
+
 	// acquire render semaphore
 	m_render_semaphore.acquire();
 	
 	// clear commands
 	m_commands[m_commit_commands_index].resize(0);
+	m_data[m_commit_commands_index].resize(0);
 	
 	// swap commands indexes
 	std::swap(m_pending_commands_index, m_commit_commands_index);
@@ -681,8 +912,37 @@ void SokolCmdQueue::flush_commands()
 
 // ----------------------------------------------------------------------------------------------------
 
+size_t SokolCmdQueue::copy_data(const void* data, size_t size)
+{
+	// aligned offset
+	size_t offset = (m_data[m_pending_commands_index].size() + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+
+	// copy data
+	m_data[m_pending_commands_index].resize(offset + size);
+	if (size > 0)
+	{
+		memcpy(&m_data[m_pending_commands_index][offset], data, size);
+	}
+
+	// return offset
+	return offset;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+const void* SokolCmdQueue::get_data(size_t offset)
+{
+	// data of commands being executed
+	return m_data[m_commit_commands_index].data() + offset;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
 void SokolCmdQueue::process_cleanups(int32_t frame_index)
 {
+	// lock cleanup mutex
+	std::scoped_lock<std::mutex> lock(m_cleanup_mutex);
+
 	// loop through cleanups
 	for (auto& cleanup : m_cleanups)
 	{
@@ -12,6 +12,7 @@
 #include <mutex>
 #include <atomic>
 #include <memory>
+#include <stdint.h>
 
 #include "sokol_gfx.h"
 
@@ -63,156 +64,166 @@ namespace Supernova {
 			};
 		};
 		
-		SokolRenderCommand() {}
-		SokolRenderCommand(TYPE::ENUM _type) : type(_type) {}
+		// arguments, stored right after command in stream
+		// large descriptors and data are stored in data block, only offsets are kept here
 
-		TYPE::ENUM type = TYPE::NOT_SET;
+		struct PushDebugGroup
+		{
+			const char* name;
+		};
 
-		union
+		struct MakeBuffer
 		{
-			struct
-			{
-				const char* name;
-			} push_debug_group;
+			sg_buffer buffer;
+			size_t desc_offset;
+			bool has_data;
+			size_t data_offset;
+		};
 
-			struct
-			{
-				sg_buffer_desc desc;
-				sg_buffer buffer;
-			} make_buffer;
-			
-			struct
-			{
-				sg_image_desc desc;
-				sg_image image;
-			} make_image;
+		struct MakeImage
+		{
+			sg_image image;
+			size_t desc_offset;
+		};
 
-			struct
-			{
-				sg_sampler_desc desc;
-				sg_sampler sampler;
-			} make_sampler;
-			
-			struct
-			{
-				sg_shader_desc desc;
-				sg_shader shader;
-			} make_shader;
-			
-			struct
-			{
-				sg_pipeline_desc desc;
-				sg_pipeline pipeline;
-			} make_pipeline;
-			
-			struct
-			{
-				sg_attachments_desc desc;
-				sg_attachments attachments;
-			} make_attachments;
-			
-			struct
-			{
-				sg_buffer buffer;
-			} destroy_buffer;
-			
-			struct
-			{
-				sg_image image;
-			} destroy_image;
-			
-			struct
-			{
-				sg_sampler sampler;
-			} destroy_sampler;
-			
-			struct
-			{
-				sg_shader shader;
-			} destroy_shader;
-			
-			struct
-			{
-				sg_pipeline pipeline;
-			} destroy_pipeline;
-			
-			struct
-			{
-				sg_attachments attachments;
-			} destroy_attachments;
-			
-			struct
-			{
-				sg_buffer buffer;
-				sg_range data;
-			} update_buffer;
-			
-			struct
-			{
-				sg_buffer buffer;
-				sg_range data;
-			} append_buffer;
-			
-			struct
-			{
-				sg_image image;
-				sg_image_data data;
-			} update_image;
-			
-			struct
-			{
-				void (*custom_cb)(void* custom_data);
-				void* custom_data;
-			} custom;
+		struct MakeSampler
+		{
+			sg_sampler sampler;
+			size_t desc_offset;
+		};
 
-			struct
-			{
-				sg_pass pass;
-			} begin_pass;
+		struct MakeShader
+		{
+			sg_shader shader;
+			size_t desc_offset;
+		};
 
-			struct
-			{
-				int x;
-				int y;
-				int width;
-				int height;
-				bool origin_top_left;
-			} apply_viewport;
-			
-			struct
-			{
-				int x;
-				int y;
-				int width;
-				int height;
-				bool origin_top_left;
-			} apply_scissor_rect;
-			
-			struct
-			{
-				sg_pipeline pipeline;
-			} apply_pipeline;
-			
-			struct
-			{
-				sg_bindings bindings;
-			} apply_bindings;
-			
-			struct
-			{
-				sg_shader_stage stage;
-				int ub_index;
-				size_t data_size;
-				char buf[16384];
-			} apply_uniforms;
-			
-			struct
-			{
-				int base_element;
-				int number_of_elements;
-				int number_of_instances;
-			} draw;
+		struct MakePipeline
+		{
+			sg_pipeline pipeline;
+			size_t desc_offset;
+		};
+
+		struct MakeAttachments
+		{
+			sg_attachments attachments;
+			size_t desc_offset;
+		};
+
+		struct DestroyBuffer
+		{
+			sg_buffer buffer;
+		};
+
+		struct DestroyImage
+		{
+			sg_image image;
+		};
+
+		struct DestroySampler
+		{
+			sg_sampler sampler;
 		};
+
+		struct DestroyShader
+		{
+			sg_shader shader;
+		};
+
+		struct DestroyPipeline
+		{
+			sg_pipeline pipeline;
+		};
+
+		struct DestroyAttachments
+		{
+			sg_attachments attachments;
+		};
+
+		struct UpdateBuffer
+		{
+			sg_buffer buffer;
+			size_t data_offset;
+			size_t data_size;
+		};
+
+		struct AppendBuffer
+		{
+			sg_buffer buffer;
+			size_t data_offset;
+			size_t data_size;
+		};
+
+		struct UpdateImage
+		{
+			sg_image image;
+			size_t data_desc_offset;
+		};
+
+		struct Custom
+		{
+			void (*custom_cb)(void* custom_data);
+			void* custom_data;
+		};
+
+		struct BeginPass
+		{
+			size_t pass_offset;
+			bool swapchain;
+		};
+
+		struct ApplyViewport
+		{
+			int x;
+			int y;
+			int width;
+			int height;
+			bool origin_top_left;
+		};
+
+		struct ApplyScissorRect
+		{
+			int x;
+			int y;
+			int width;
+			int height;
+			bool origin_top_left;
+		};
+
+		struct ApplyPipeline
+		{
+			sg_pipeline pipeline;
+		};
+
+		struct ApplyBindings
+		{
+			sg_bindings bindings;
+		};
+
+		struct ApplyUniforms
+		{
+			sg_shader_stage stage;
+			int ub_index;
+			size_t data_offset;
+			size_t data_size;
+		};
+
+		struct Draw
+		{
+			int base_element;
+			int number_of_elements;
+			int number_of_instances;
+		};
+
+		SokolRenderCommand() {}
+		SokolRenderCommand(TYPE::ENUM _type, uint32_t _size) : type(_type), size(_size) {}
+
+		TYPE::ENUM type = TYPE::NOT_SET;
+		// command and its arguments, next command starts after it
+		uint32_t size = 0;
+
+		template<typename T>
+		const T& args() const { return *reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(this) + sizeof(SokolRenderCommand)); }
 	};
 
 // ----------------------------------------------------------------------------------------------------
@@ -236,7 +247,7 @@ namespace Supernova {
 		static void finish();
 
 		// render thread functions
-		static void execute_commands(bool resource_only = false);
+		static void execute_commands(bool resource_only = false, bool wait_commit = false);
 		static void wait_for_flush();
 
 		// update thread functions
@@ -262,6 +273,8 @@ namespace Supernova {
 		static void add_command_update_image(sg_image image, const sg_image_data& data);
 		
 		static void add_command_begin_pass(const sg_pass& pass);
+		// swapchain is only known by render thread, width and height of pass are kept if not zero
+		static void add_command_begin_swapchain_pass(const sg_pass& pass);
 		static void add_command_apply_viewport(int x, int y, int width, int height, bool origin_top_left);
 		static void add_command_apply_scissor_rect(int x, int y, int width, int height, bool origin_top_left);
 		static void add_command_apply_pipeline(sg_pipeline pipeline);
@@ -286,6 +299,15 @@ namespace Supernova {
 	private:
 		static void process_cleanups(int32_t frame_index);
 
+		// data is copied because update thread may change it before commands are executed
+		static size_t copy_data(const void* data, size_t size);
+		static const void* get_data(size_t offset);
+
+		// commands are packed in a byte stream, each one using only size of its arguments
+		template<typename T>
+		static T& add_command(SokolRenderCommand::TYPE::ENUM type);
+		static void add_command(SokolRenderCommand::TYPE::ENUM type);
+
 		static void dealloc_buffer_cb(void* cleanup_data) { sg_dealloc_buffer({(uint32_t)(uintptr_t)cleanup_data}); }
 		static void dealloc_image_cb(void* cleanup_data) { sg_dealloc_image({(uint32_t)(uintptr_t)cleanup_data}); }
 		static void dealloc_sampler_cb(void* cleanup_data) { sg_dealloc_sampler({(uint32_t)(uintptr_t)cleanup_data}); }
@@ -293,7 +315,8 @@ namespace Supernova {
 		static void dealloc_pipeline_cb(void* cleanup_data) { sg_dealloc_pipeline({(uint32_t)(uintptr_t)cleanup_data}); }
 		static void dealloc_attachments_cb(void* cleanup_data) { sg_dealloc_attachments({(uint32_t)(uintptr_t)cleanup_data}); }
 
-		static std::vector<SokolRenderCommand> m_commands[2];
+		static std::vector<uint8_t> m_commands[2];
+		static std::vector<uint8_t> m_data[2];
 		static int32_t m_pending_commands_index;
 		static int32_t m_commit_commands_index;
 		static std::vector<SokolRenderCleanup> m_cleanups;
@@ -303,6 +326,10 @@ namespace Supernova {
 		static std::atomic<bool> m_flushing;
 		static std::atomic<bool> m_commited;
 		static std::mutex m_execute_mutex;
+		// also taken by allocs, render thread deallocs from same pools
+		static std::mutex m_cleanup_mutex;
+		// loader threads and recording thread can add commands at same time
+		static std::mutex m_record_mutex;
 		static int32_t m_frame_index;
 	};
 
@@ -10,8 +10,28 @@
 #include "SokolCmdQueue.h"
 #include "Engine.h"
 
+#include <cstring>
+#include <algorithm>
+
 using namespace Supernova;
 
+uint32_t SokolObject::lastPipeline = SG_INVALID_ID;
+sg_bindings SokolObject::lastBindings = {};
+bool SokolObject::lastBindingsValid = false;
+uint32_t SokolObject::frameDrawCalls = 0;
+uint32_t SokolObject::frameStateChanges = 0;
+uint32_t SokolObject::frameSkippedStateChanges = 0;
+uint32_t SokolObject::drawCalls = 0;
+uint32_t SokolObject::stateChanges = 0;
+uint32_t SokolObject::skippedStateChanges = 0;
+
+uint64_t SokolObject::lastUniformHashes[SG_NUM_SHADER_STAGES][SG_MAX_SHADERSTAGE_UBS] = {};
+uint32_t SokolObject::frameUniformBytes = 0;
+uint32_t SokolObject::uniformBytes = 0;
+
+std::unordered_map<uint64_t, std::vector<PipelineCacheEntry>> SokolObject::pipelineCache;
+std::unordered_map<uint32_t, uint64_t> SokolObject::pipelineHashes;
+std::mutex SokolObject::pipelineCacheMutex;
 
 SokolObject::SokolObject(){
     pip.id = SG_INVALID_ID;
@@ -208,6 +228,154 @@ void SokolObject::addTexture(std::pair<int, int> slot, ShaderStageType stage, Te
     }
 }
 
+void SokolObject::getPipelineKey(const sg_pipeline_desc& desc, std::vector<uint32_t>& key){
+    // descriptor fields, label and padding are ignored
+    key.clear();
+    auto add = [&key](uint32_t value){
+        key.push_back(value);
+    };
+    auto addFloat = [&add](float value){
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        add(bits);
+    };
+
+    add(desc.shader.id);
+    for (int i = 0; i < SG_MAX_VERTEX_BUFFERS; i++){
+        add(desc.layout.buffers[i].stride);
+        add(desc.layout.buffers[i].step_func);
+        add(desc.layout.buffers[i].step_rate);
+    }
+    for (int i = 0; i < SG_MAX_VERTEX_ATTRIBUTES; i++){
+        add(desc.layout.attrs[i].buffer_index);
+        add(desc.layout.attrs[i].offset);
+        add(desc.layout.attrs[i].format);
+    }
+
+    add(desc.depth.pixel_format);
+    add(desc.depth.compare);
+    add(desc.depth.write_enabled);
+    addFloat(desc.depth.bias);
+    addFloat(desc.depth.bias_slope_scale);
+    addFloat(desc.depth.bias_clamp);
+
+    add(desc.stencil.enabled);
+    for (const sg_stencil_face_state* face : {&desc.stencil.front, &desc.stencil.back}){
+        add(face->compare);
+        add(face->fail_op);
+        add(face->depth_fail_op);
+        add(face->pass_op);
+    }
+    add(desc.stencil.read_mask);
+    add(desc.stencil.write_mask);
+    add(desc.stencil.ref);
+
+    add(desc.color_count);
+    for (int i = 0; i < SG_MAX_COLOR_ATTACHMENTS; i++){
+        const sg_color_target_state& color = desc.colors[i];
+        add(color.pixel_format);
+        add(color.write_mask);
+        add(color.blend.enabled);
+        add(color.blend.src_factor_rgb);
+        add(color.blend.dst_factor_rgb);
+        add(color.blend.op_rgb);
+        add(color.blend.src_factor_alpha);
+        add(color.blend.dst_factor_alpha);
+        add(color.blend.op_alpha);
+    }
+
+    add(desc.primitive_type);
+    add(desc.index_type);
+    add(desc.cull_mode);
+    add(desc.face_winding);
+    add(desc.sample_count);
+    addFloat(desc.blend_color.r);
+    addFloat(desc.blend_color.g);
+    addFloat(desc.blend_color.b);
+    addFloat(desc.blend_color.a);
+    add(desc.alpha_to_coverage_enabled);
+}
+
+uint64_t SokolObject::getPipelineHash(const std::vector<uint32_t>& key){
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t value : key){
+        for (int i = 0; i < 4; i++){
+            hash = (hash ^ ((value >> (i * 8)) & 0xFF)) * 1099511628211ull;
+        }
+    }
+
+    return hash;
+}
+
+sg_pipeline SokolObject::acquirePipeline(const sg_pipeline_desc& desc){
+    std::vector<uint32_t> key;
+    getPipelineKey(desc, key);
+    uint64_t hash = getPipelineHash(key);
+
+    std::scoped_lock<std::mutex> lock(pipelineCacheMutex);
+
+    // a different descriptor with same hash is a miss
+    auto it = pipelineCache.find(hash);
+    if (it != pipelineCache.end()){
+        for (PipelineCacheEntry& entry : it->second){
+            if (entry.key == key){
+                entry.refCount++;
+                return entry.pipeline;
+            }
+        }
+    }
+
+    sg_pipeline pipeline;
+    if (Engine::isAsyncThread()){
+        pipeline = SokolCmdQueue::add_command_make_pipeline(desc);
+    }else{
+        pipeline = sg_make_pipeline(desc);
+    }
+
+    if (pipeline.id != SG_INVALID_ID){
+        pipelineCache[hash].push_back({std::move(key), pipeline, 1});
+        pipelineHashes[pipeline.id] = hash;
+    }
+
+    return pipeline;
+}
+
+void SokolObject::releasePipeline(sg_pipeline pipeline){
+    std::scoped_lock<std::mutex> lock(pipelineCacheMutex);
+
+    auto hashIt = pipelineHashes.find(pipeline.id);
+    if (hashIt == pipelineHashes.end()){
+        return;
+    }
+
+    auto it = pipelineCache.find(hashIt->second);
+    if (it != pipelineCache.end()){
+        std::vector<PipelineCacheEntry>& entries = it->second;
+        auto entryIt = std::find_if(entries.begin(), entries.end(), [&pipeline](const PipelineCacheEntry& entry){ return entry.pipeline.id == pipeline.id; });
+
+        if (entryIt != entries.end()){
+            if (--entryIt->refCount > 0){
+                return;
+            }
+            entries.erase(entryIt);
+        }
+
+        if (entries.empty()){
+            pipelineCache.erase(it);
+        }
+    }
+    pipelineHashes.erase(hashIt);
+
+    if (sg_isvalid()){
+        if (Engine::isAsyncThread()){
+            SokolCmdQueue::add_command_destroy_pipeline(pipeline);
+        }else{
+            sg_destroy_pipeline(pipeline);
+        }
+    }
+}
+
 bool SokolObject::endLoad(uint8_t pipelines, bool enableFaceCulling, CullingMode cullingMode, WindingOrder windingOrder){
 
     if (pipelines & (int)PipelineType::PIP_DEPTH) {
@@ -224,11 +392,7 @@ bool SokolObject::endLoad(uint8_t pipelines, bool enableFaceCulling, CullingMode
         pip_depth_desc.depth.write_enabled = true;
         pip_depth_desc.colors[0].pixel_format = SG_PIXELFORMAT_RGBA8;
 
-        if (Engine::isAsyncThread()){
-            depth_pip = SokolCmdQueue::add_command_make_pipeline(pip_depth_desc);
-        }else{
-            depth_pip = sg_make_pipeline(pip_depth_desc);
-        }
+        depth_pip = acquirePipeline(pip_depth_desc);
 
         if (depth_pip.id == SG_INVALID_ID){
             return false;
@@ -251,11 +415,7 @@ bool SokolObject::endLoad(uint8_t pipelines, bool enableFaceCulling, CullingMode
         pip_default_desc.colors[0].blend.src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA;
         pip_default_desc.colors[0].blend.dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
 
-        if (Engine::isAsyncThread()){
-            pip = SokolCmdQueue::add_command_make_pipeline(pip_default_desc);
-        }else{
-            pip = sg_make_pipeline(pip_default_desc);
-        }
+        pip = acquirePipeline(pip_default_desc);
 
         if (pip.id == SG_INVALID_ID){
             return false;
@@ -285,11 +445,7 @@ bool SokolObject::endLoad(uint8_t pipelines, bool enableFaceCulling, CullingMode
         pip_rtt_desc.depth.pixel_format = SG_PIXELFORMAT_DEPTH;
         pip_rtt_desc.colors[0].pixel_format = SG_PIXELFORMAT_RGBA8;
 
-        if (Engine::isAsyncThread()){
-            rtt_pip = SokolCmdQueue::add_command_make_pipeline(pip_rtt_desc);
-        }else{
-            rtt_pip = sg_make_pipeline(pip_rtt_desc);
-        }
+        rtt_pip = acquirePipeline(pip_rtt_desc);
 
         if (rtt_pip.id == SG_INVALID_ID){
             return false;
@@ -300,30 +456,46 @@ bool SokolObject::endLoad(uint8_t pipelines, bool enableFaceCulling, CullingMode
 }
 
 bool SokolObject::beginDraw(PipelineType pipType){
+    sg_pipeline pipeline;
     if (pipType == PipelineType::PIP_DEPTH){
-        if (depth_pip.id == SG_INVALID_ID){
-            return false;
-        }
-        //SokolCmdQueue::add_command_apply_pipeline(depth_pip);
-        sg_apply_pipeline(depth_pip);
+        pipeline = depth_pip;
     }else if (pipType == PipelineType::PIP_RTT){
-        if (rtt_pip.id == SG_INVALID_ID){
-            return false;
-        }
-        //SokolCmdQueue::add_command_apply_pipeline(rtt_pip);
-        sg_apply_pipeline(rtt_pip);
+        pipeline = rtt_pip;
     }else{
-        if (pip.id == SG_INVALID_ID){
-            return false;
-        }
-        //SokolCmdQueue::add_command_apply_pipeline(pip);
-        sg_apply_pipeline(pip);
+        pipeline = pip;
+    }
+
+    if (pipeline.id == SG_INVALID_ID){
+        return false;
+    }
+
+    if (pipeline.id == lastPipeline){
+        frameSkippedStateChanges++;
+        return true;
+    }
+
+    lastPipeline = pipeline.id;
+    // bindings are validated against pipeline layout, apply them again
+    lastBindingsValid = false;
+    memset(lastUniformHashes, 0, sizeof(lastUniformHashes));
+    frameStateChanges++;
+
+    if (Engine::isAsyncThread()){
+        SokolCmdQueue::add_command_apply_pipeline(pipeline);
+    }else{
+        sg_apply_pipeline(pipeline);
     }
 
     return true;
 }
 
 void SokolObject::applyUniformBlock(int slot, ShaderStageType stage, unsigned int count, void* data){
+    if (slot != -1){
+        applyUniformBlock(slot, stage, count, data, getUniformHash(data, count));
+    }
+}
+
+void SokolObject::applyUniformBlock(int slot, ShaderStageType stage, unsigned int count, void* data, uint64_t hash){
     if (slot != -1){
         sg_shader_stage sg_stage;
         if (stage == ShaderStageType::VERTEX){
@@ -331,42 +503,101 @@ void SokolObject::applyUniformBlock(int slot, ShaderStageType stage, unsigned in
         }else if (stage == ShaderStageType::FRAGMENT){
             sg_stage = SG_SHADERSTAGE_FS;
         }
-        //SokolCmdQueue::add_command_apply_uniforms(sg_stage, slot, {data, count});
-        sg_apply_uniforms(sg_stage, slot, {data, count});
+
+        // same data is still applied for this pipeline
+        if (hash != 0 && lastUniformHashes[sg_stage][slot] == hash){
+            frameSkippedStateChanges++;
+            return;
+        }
+        lastUniformHashes[sg_stage][slot] = hash;
+        frameUniformBytes += count;
+        frameStateChanges++;
+
+        if (Engine::isAsyncThread()){
+            SokolCmdQueue::add_command_apply_uniforms(sg_stage, slot, {data, count});
+        }else{
+            sg_apply_uniforms(sg_stage, slot, {data, count});
+        }
     }
 }
 
 void SokolObject::draw(unsigned int vertexCount, unsigned int instanceCount){
-    //SokolCmdQueue::add_command_apply_bindings(bind);
-    sg_apply_bindings(bind);
-    //SokolCmdQueue::add_command_draw(0, vertexCount, 1);
-    sg_draw(0, vertexCount, instanceCount);
+    draw(0, vertexCount, instanceCount);
 }
 
-void SokolObject::destroy(){
-    if (sg_isvalid()){
-        if (pip.id != SG_INVALID_ID){
-            if (Engine::isAsyncThread()){
-                SokolCmdQueue::add_command_destroy_pipeline(pip);
-            }else{
-                sg_destroy_pipeline(pip);
+void SokolObject::draw(unsigned int baseElement, unsigned int vertexCount, unsigned int instanceCount){
+    const sg_bindings* drawBind = &bind;
+
+    sg_bindings streamBind;
+    if (SokolBuffer::hasStreamBindings()){
+        streamBind = bind;
+        for (int i = 0; i < SG_MAX_VERTEX_BUFFERS; i++){
+            sg_buffer streamBuffer;
+            int streamOffset;
+            if (bind.vertex_buffers[i].id != SG_INVALID_ID && SokolBuffer::getStreamBinding(bind.vertex_buffers[i].id, streamBuffer, streamOffset)){
+                streamBind.vertex_buffers[i] = streamBuffer;
+                streamBind.vertex_buffer_offsets[i] += streamOffset;
             }
         }
-        if (depth_pip.id != SG_INVALID_ID){
-            if (Engine::isAsyncThread()){
-                SokolCmdQueue::add_command_destroy_pipeline(depth_pip);
-            }else{
-                sg_destroy_pipeline(depth_pip);
-            }
+        drawBind = &streamBind;
+    }
+
+    // sg_bindings has only 32 bit fields, so memcmp is exact
+    if (lastBindingsValid && memcmp(&lastBindings, drawBind, sizeof(sg_bindings)) == 0){
+        frameSkippedStateChanges++;
+    }else{
+        lastBindings = *drawBind;
+        lastBindingsValid = true;
+        frameStateChanges++;
+
+        if (Engine::isAsyncThread()){
+            SokolCmdQueue::add_command_apply_bindings(*drawBind);
+        }else{
+            sg_apply_bindings(drawBind);
         }
-        if (rtt_pip.id != SG_INVALID_ID){
-            if (Engine::isAsyncThread()){
-                SokolCmdQueue::add_command_destroy_pipeline(rtt_pip);
-            }else{
-                sg_destroy_pipeline(rtt_pip);
-            }
+    }
+    if (Engine::isAsyncThread()){
+        SokolCmdQueue::add_command_draw(baseElement, vertexCount, instanceCount);
+    }else{
+        sg_draw(baseElement, vertexCount, instanceCount);
+    }
+
+    frameDrawCalls++;
+}
+
+uint32_t SokolObject::getPipelineId(PipelineType pipType) const{
+    if (pipType == PipelineType::PIP_DEPTH){
+        return depth_pip.id;
+    }else if (pipType == PipelineType::PIP_RTT){
+        return rtt_pip.id;
+    }
+    return pip.id;
+}
+
+uint32_t SokolObject::getTextureId() const{
+    for (int i = 0; i < SG_MAX_SHADERSTAGE_IMAGES; i++){
+        if (bind.fs.images[i].id != SG_INVALID_ID){
+            return bind.fs.images[i].id;
         }
     }
+    return SG_INVALID_ID;
+}
+
+uint64_t SokolObject::getTexturesHash() const{
+    // images, samplers and storage buffers of both stages
+    return getUniformHash(&bind.vs, sizeof(sg_stage_bindings)) ^ (getUniformHash(&bind.fs, sizeof(sg_stage_bindings)) * 31);
+}
+
+void SokolObject::destroy(){
+    if (pip.id != SG_INVALID_ID){
+        releasePipeline(pip);
+    }
+    if (depth_pip.id != SG_INVALID_ID){
+        releasePipeline(depth_pip);
+    }
+    if (rtt_pip.id != SG_INVALID_ID){
+        releasePipeline(rtt_pip);
+    }
 
     pip.id = SG_INVALID_ID;
     depth_pip.id = SG_INVALID_ID;
@@ -375,3 +606,65 @@ void SokolObject::destroy(){
     pipeline_desc = {};
     bindSlotIndex = 0;
 }
+
+void SokolObject::beginPass(){
+    // sokol requires pipeline and uniforms to be applied again in a new pass
+    lastPipeline = SG_INVALID_ID;
+    lastBindingsValid = false;
+    memset(lastUniformHashes, 0, sizeof(lastUniformHashes));
+}
+
+void SokolObject::endFrame(){
+    drawCalls = frameDrawCalls;
+    stateChanges = frameStateChanges;
+    skippedStateChanges = frameSkippedStateChanges;
+    uniformBytes = frameUniformBytes;
+
+    frameDrawCalls = 0;
+    frameStateChanges = 0;
+    frameSkippedStateChanges = 0;
+    frameUniformBytes = 0;
+    lastPipeline = SG_INVALID_ID;
+    lastBindingsValid = false;
+}
+
+uint32_t SokolObject::getDrawCalls(){
+    return drawCalls;
+}
+
+uint32_t SokolObject::getStateChanges(){
+    return stateChanges;
+}
+
+uint32_t SokolObject::getSkippedStateChanges(){
+    return skippedStateChanges;
+}
+
+size_t SokolObject::getNumPipelines(){
+    std::scoped_lock<std::mutex> lock(pipelineCacheMutex);
+    // pipelineHashes has one item for each pipeline, also when hashes collide
+    return pipelineHashes.size();
+}
+
+uint32_t SokolObject::getUniformBytes(){
+    return uniformBytes;
+}
+
+uint64_t SokolObject::getUniformHash(const void* data, size_t count){
+    // FNV-1a style mix over 8 byte words, zero is kept as "not applied"
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 14695981039346656037ull;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8){
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < count; i++){
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+
+    return (hash != 0) ? hash : 1;
+}
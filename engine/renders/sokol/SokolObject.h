@@ -14,6 +14,9 @@
 #include "sokol_gfx.h"
 
 #include <map>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
 
 
 namespace Supernova{
@@ -36,6 +39,12 @@ namespace Supernova{
         }
     };
 
+    struct PipelineCacheEntry{
+        std::vector<uint32_t> key; // hashed descriptor fields, compared on hash hits
+        sg_pipeline pipeline;
+        uint32_t refCount;
+    };
+
     class SokolObject{
 
     private:
@@ -52,6 +61,31 @@ namespace Supernova{
 
         std::map< BufferInfo, size_t > bufferToBindSlot;
 
+        // state bound in current pass and counters, shared by all objects
+        static uint32_t lastPipeline;
+        static sg_bindings lastBindings;
+        static bool lastBindingsValid;
+        static uint32_t frameDrawCalls;
+        static uint32_t frameStateChanges;
+        static uint32_t frameSkippedStateChanges;
+        static uint32_t drawCalls;
+        static uint32_t stateChanges;
+        static uint32_t skippedStateChanges;
+
+        // uniform blocks applied since pipeline was bound, skipped when hash is the same
+        static uint64_t lastUniformHashes[SG_NUM_SHADER_STAGES][SG_MAX_SHADERSTAGE_UBS];
+        static uint32_t frameUniformBytes;
+        static uint32_t uniformBytes;
+
+        // pipelines shared by objects with same descriptor, descriptors with same hash share a bucket
+        static std::unordered_map<uint64_t, std::vector<PipelineCacheEntry>> pipelineCache;
+        static std::unordered_map<uint32_t, uint64_t> pipelineHashes;
+        static std::mutex pipelineCacheMutex;
+
+        static void getPipelineKey(const sg_pipeline_desc& desc, std::vector<uint32_t>& key);
+        static uint64_t getPipelineHash(const std::vector<uint32_t>& key);
+        static sg_pipeline acquirePipeline(const sg_pipeline_desc& desc);
+        static void releasePipeline(sg_pipeline pipeline);
 
         sg_vertex_format getVertexFormat(unsigned int elements, AttributeDataType dataType, bool normalized);
         sg_primitive_type getPrimitiveType(PrimitiveType primitiveType);
@@ -74,10 +108,26 @@ namespace Supernova{
 
         bool beginDraw(PipelineType pipType);
         void applyUniformBlock(int slot, ShaderStageType stage, unsigned int count, void* data);
+        void applyUniformBlock(int slot, ShaderStageType stage, unsigned int count, void* data, uint64_t hash);
         void draw(unsigned int vertexCount, unsigned int instanceCount);
+        void draw(unsigned int baseElement, unsigned int vertexCount, unsigned int instanceCount);
+
+        uint32_t getPipelineId(PipelineType pipType) const;
+        uint32_t getTextureId() const;
+        uint64_t getTexturesHash() const;
 
         void destroy();
 
+        static void beginPass();
+        static void endFrame();
+        static uint32_t getDrawCalls();
+        static uint32_t getStateChanges();
+        static uint32_t getSkippedStateChanges();
+        static size_t getNumPipelines();
+        static uint32_t getUniformBytes();
+
+        static uint64_t getUniformHash(const void* data, size_t count);
+
     };
 }
 #endif //sokolobject_h
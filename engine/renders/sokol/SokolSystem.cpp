@@ -7,6 +7,8 @@
 #include "System.h"
 #include "sokol_gfx.h"
 #include "SokolCmdQueue.h"
+#include "SokolObject.h"
+#include "SokolBuffer.h"
 #include "Engine.h"
 #include "Log.h"
 
@@ -60,12 +62,42 @@ void SokolSystem::commitQueue(){
     SokolCmdQueue::commit_commands();
 }
 
-void SokolSystem::executeQueue(){
-    SokolCmdQueue::execute_commands();
+void SokolSystem::executeQueue(bool waitCommit){
+    SokolCmdQueue::execute_commands(false, waitCommit);
+}
+
+void SokolSystem::executeQueueResources(){
+    SokolCmdQueue::execute_commands(true);
 }
 
 void SokolSystem::commit(){
-    sg_commit();
+    if (Engine::isAsyncThread()){
+        SokolCmdQueue::add_command_commit();
+    }else{
+        sg_commit();
+    }
+    SokolObject::endFrame();
+    SokolBuffer::endFrame();
+}
+
+uint32_t SokolSystem::getDrawCalls(){
+    return SokolObject::getDrawCalls();
+}
+
+uint32_t SokolSystem::getStateChanges(){
+    return SokolObject::getStateChanges();
+}
+
+uint32_t SokolSystem::getSkippedStateChanges(){
+    return SokolObject::getSkippedStateChanges();
+}
+
+uint32_t SokolSystem::getUniformBytes(){
+    return SokolObject::getUniformBytes();
+}
+
+uint32_t SokolSystem::getBufferUploadBytes(){
+    return SokolBuffer::getUploadBytes();
 }
 
 void SokolSystem::shutdown(){
@@ -13,12 +13,19 @@ namespace Supernova{
     public:
         static void setup();
         static void commitQueue();
-        static void executeQueue();
+        static void executeQueue(bool waitCommit = false);
+        static void executeQueueResources();
         static void commit();
         static void shutdown();
 
         static void scheduleCleanup(void (*cleanupFunc)(void* cleanupData), void* cleanupData, int32_t numFramesToDefer = 0);
         static void addQueueCommand(void (*custom_cb)(void* custom_data), void* custom_data);
+
+        static uint32_t getDrawCalls();
+        static uint32_t getStateChanges();
+        static uint32_t getSkippedStateChanges();
+        static uint32_t getUniformBytes();
+        static uint32_t getBufferUploadBytes();
     };
 }
 
@@ -0,0 +1,70 @@
+//
+// (c) 2024 Eduardo Doria.
+//
+
+#include "SokolCmdQueue.h"
+#include "System.h"
+
+#define SOKOL_IMPL
+#include "sokol_gfx.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Supernova;
+
+// only needed by swapchain passes, that must not run in resource replay
+System& System::instance(){
+    std::fprintf(stderr, "swapchain pass executed in resource replay\n");
+    std::abort();
+}
+
+static int customCalls = 0;
+
+static void customCallback(void* data){
+    customCalls += *static_cast<int*>(data);
+}
+
+static bool check(bool condition, const char* message){
+    if (!condition){
+        std::fprintf(stderr, "FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+int main(){
+    sg_desc desc = {};
+    sg_setup(&desc);
+
+    SokolCmdQueue::start();
+
+    // one recorded frame: resource, upload, custom callback and a pass
+    sg_buffer_desc bufferDesc = {};
+    bufferDesc.size = 4 * sizeof(float);
+    bufferDesc.usage = SG_USAGE_DYNAMIC;
+    sg_buffer buffer = SokolCmdQueue::add_command_make_buffer(bufferDesc);
+
+    float values[4] = {1, 2, 3, 4};
+    SokolCmdQueue::add_command_update_buffer(buffer, SG_RANGE(values));
+
+    int increment = 1;
+    SokolCmdQueue::add_command_custom(customCallback, &increment);
+
+    sg_pass pass = {};
+    SokolCmdQueue::add_command_begin_swapchain_pass(pass);
+    SokolCmdQueue::add_command_end_pass();
+    SokolCmdQueue::add_command_commit();
+
+    SokolCmdQueue::commit_commands();
+    SokolCmdQueue::execute_commands(true);
+
+    bool passed = true;
+    passed &= check(sg_query_buffer_state(buffer) == SG_RESOURCESTATE_VALID, "buffer was not created");
+    passed &= check(sg_query_buffer_info(buffer).update_frame_index != 0, "buffer update was dropped");
+    passed &= check(customCalls == 1, "custom callback did not run once");
+
+    SokolCmdQueue::finish();
+    sg_shutdown();
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}